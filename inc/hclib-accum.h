@@ -0,0 +1,78 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HCLIB_ACCUM_H_
+#define HCLIB_ACCUM_H_
+
+#include <stddef.h>
+
+/**
+ * @file Accumulators, reducing the values put by the tasks of a finish scope.
+ *
+ * An accumulator is declared on a finish scope with hclib_start_finish_accum.
+ * Until that scope completes, any of its tasks may put values, which are
+ * combined into a lane private to the current worker without any atomic
+ * operation. Once the last task of the scope is done, the lanes are combined
+ * into the result of the accumulator, which can be read after
+ * hclib_end_finish.
+ */
+
+/**
+ * @brief Opaque type for accumulators.
+ */
+typedef struct hclib_accum_st hclib_accum_t;
+
+/*
+ * Combine value into acc (acc = acc op value). Operators must be associative,
+ * but need not be commutative: lanes are combined in worker order.
+ */
+typedef void (*hclib_accum_op_t)(void *acc, const void *value, void *arg);
+
+/*
+ * Create an accumulator over values of the given size, combined by op, which
+ * is passed arg. The lanes start from identity, which is copied.
+ */
+hclib_accum_t *hclib_accum_create(size_t size, const void *identity,
+        hclib_accum_op_t op, void *arg);
+
+/*
+ * Free an accumulator, which must not be declared on a running finish scope.
+ */
+void hclib_accum_free(hclib_accum_t *accum);
+
+/*
+ * Start a finish scope, and declare the given accumulators on it. They must not
+ * be declared on another scope that is still running.
+ */
+void hclib_start_finish_accum(hclib_accum_t **accums, int naccums);
+
+/*
+ * Combine value into the lane of the current worker.
+ */
+void hclib_accum_put(hclib_accum_t *accum, const void *value);
+
+/*
+ * Get the lane of the current worker, to update it in place. It must not be
+ * used once the current task has been suspended, as it may then resume on
+ * another worker.
+ */
+void *hclib_accum_lane(hclib_accum_t *accum);
+
+/*
+ * Get the result of the last finish scope the accumulator was declared on.
+ */
+const void *hclib_accum_get(hclib_accum_t *accum);
+
+#endif /* HCLIB_ACCUM_H_ */
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HCLIB_ACCUM_HPP_
+#define HCLIB_ACCUM_HPP_
+
+#include <functional>
+#include <type_traits>
+
+#include "hclib-accum.h"
+#include "hclib-async.hpp"
+
+namespace hclib {
+
+template <typename T>
+struct max_of {
+    T operator()(const T &a, const T &b) const { return a < b ? b : a; }
+};
+
+template <typename T>
+struct min_of {
+    T operator()(const T &a, const T &b) const { return b < a ? b : a; }
+};
+
+/*
+ * Accumulator of values of type T, combined by Op (see hclib-accum.h). Lanes
+ * are copied around as raw memory, hence the restriction to trivially copyable
+ * types.
+ */
+template <typename T, typename Op = std::plus<T>>
+class accumulator {
+    static_assert(std::is_trivially_copyable<T>::value,
+            "accumulator values must be trivially copyable");
+
+    Op op;
+    hclib_accum_t *accum;
+
+    static void combine(void *acc, const void *value, void *arg) {
+        T &a = *static_cast<T*>(acc);
+        a = (*static_cast<Op*>(arg))(a, *static_cast<const T*>(value));
+    }
+
+  public:
+    explicit accumulator(const T &identity = T(), Op op = Op()) : op(op) {
+        accum = hclib_accum_create(sizeof(T), &identity, combine, &this->op);
+    }
+
+    ~accumulator() {
+        hclib_accum_free(accum);
+    }
+
+    accumulator(const accumulator&) = delete;
+    accumulator &operator=(const accumulator&) = delete;
+
+    void put(const T &value) {
+        hclib_accum_put(accum, &value);
+    }
+
+    // lane of the current worker, see hclib_accum_lane
+    T &local() {
+        return *static_cast<T*>(hclib_accum_lane(accum));
+    }
+
+    const T &get() const {
+        return *static_cast<const T*>(hclib_accum_get(accum));
+    }
+
+    hclib_accum_t *handle() {
+        return accum;
+    }
+};
+
+/*
+ * Run lambda in a finish scope on which the given accumulators are declared.
+ */
+template <typename T, typename A, typename... As>
+inline void finish(T &&lambda, A &accum, As&... accums) {
+    hclib_accum_t *handles[] = { accum.handle(), accums.handle()... };
+    hclib_start_finish_accum(handles, 1 + sizeof...(As));
+    lambda();
+    hclib_end_finish();
+}
+
+}
+
+#endif /* HCLIB_ACCUM_HPP_ */
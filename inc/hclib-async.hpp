@@ -14,10 +14,14 @@
  * limitations under the License.
  */
 
+#include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <type_traits>
+#include <typeinfo>
 
 #include "hclib-async-struct.h"
+#include "hclib-graph.h"
 #include "hclib-promise.hpp"
 
 #ifndef HCLIB_ASYNC_H_
@@ -35,34 +39,153 @@ namespace hclib {
  * TODO optimize that overhead.
  */
 
-/* raw function pointer for calling lambdas */
+/*
+ * Names the tasks running Fn, a wrapper of lambdas of type T, after T in
+ * profiles (see hclib-profile.h). Referring to registered from Fn registers it
+ * at startup.
+ */
+template<typename T, generic_frame_ptr Fn>
+struct task_name {
+    static hclib_task_name_t entry;
+    static const int registered;
+};
+
+template<typename T, generic_frame_ptr Fn>
+hclib_task_name_t task_name<T, Fn>::entry = { Fn, nullptr, nullptr };
+
+template<typename T, generic_frame_ptr Fn>
+const int task_name<T, Fn>::registered = hclib_profile_name_task(
+        &task_name<T, Fn>::entry, typeid(T).name());
+
+/*
+ * raw function pointer for calling lambdas, which are spawned
+ * UNCANCELLABLE_ASYNC so as to be deleted even if their finish was cancelled
+ */
 template<typename T>
 void lambda_wrapper(void *arg) {
+    (void) task_name<T, lambda_wrapper<T>>::registered;
     T *lambda = static_cast<T*>(arg);
+    if (!hclib_is_cancelled()) {
+        MARK_BUSY(current_ws()->id);
+        (*lambda)(); // !!! May cause a worker-swap !!!
+        MARK_OVH(current_ws()->id);
+    }
+    delete lambda;
+}
+
+/*
+ * While a graph is captured (see hclib-graph.hpp), lambdas are owned by the
+ * graph instead, as its tasks run them at every launch.
+ */
+template<typename T>
+void graph_lambda_release(void *arg) {
+    delete static_cast<T*>(arg);
+}
+
+template<typename T>
+void graph_lambda_caller(void *arg) {
+    (void) task_name<T, graph_lambda_caller<T>>::registered;
     MARK_BUSY(current_ws()->id);
-    (*lambda)(); // !!! May cause a worker-swap !!!
+    (*static_cast<T*>(arg))(); // !!! May cause a worker-swap !!!
     MARK_OVH(current_ws()->id);
-    delete lambda;
 }
 
+// Returns false if not capturing, for the lambda to be spawned as usual.
+template<typename T>
+inline bool record_lambda(T &lambda, hclib_future_t **fs, place_t *pl) {
+    if (!hclib_graph_capturing()) {
+        return false;
+    }
+    T *arg = new T(lambda);
+    hclib_graph_attach(arg, graph_lambda_release<T>);
+    hclib_async(graph_lambda_caller<T>, arg, fs, nullptr, pl, 0);
+    return true;
+}
+
+/*
+ * The C++ tasks that satisfy a future own their promise, and cannot be run by
+ * every launch of a graph (see hclib::graph_async instead).
+ */
+inline void check_not_capturing(const char *fn) {
+    if (hclib_graph_capturing()) {
+        fprintf(stderr, "FATAL: %s cannot be recorded in a graph, use "
+                "hclib::graph_async\n", fn);
+        abort();
+    }
+}
+
+
+/*
+ * Runtime-managed future lists hold a reference on each of their promises, so
+ * that the promises outlive the wait on them.
+ */
+inline hclib_future_t *future_list_entry(hclib_future_t *future) {
+    return future;
+}
 
-/* this version also deletes a runtime-managed future list */
 template<typename T>
+inline hclib_future_t *future_list_entry(const shared_future<T> &future) {
+    return future.get_future();
+}
+
+inline void retain_future_list(hclib_future_t **future_list) {
+    for (hclib_future_t **f = future_list; *f; f++) {
+        hclib_promise_retain((*f)->owner);
+    }
+}
+
+inline void release_future_list(hclib_future_t **future_list) {
+    for (hclib_future_t **f = future_list; *f; f++) {
+        hclib_promise_release((*f)->owner);
+    }
+}
+
+template <typename... Ts>
+inline hclib_future_t **construct_future_list(Ts... futures) {
+    const size_t n = sizeof...(futures); // parameter pack count
+    hclib_future_t **fs = new hclib_future_t*[n+1] {
+        future_list_entry(futures)..., nullptr };
+    retain_future_list(fs);
+    return fs;
+}
+
+inline void delete_future_list(hclib_future_t **future_list) {
+    if (future_list == nullptr) return;
+    release_future_list(future_list);
+    delete[] future_list;
+}
+
+/*
+ * this version also holds a runtime-managed future list, allocated along with
+ * the lambda
+ */
+template<typename T, size_t N>
 struct lambda_await_args {
-    T* lambda;
-    hclib_future_t **future_list;
+    T lambda;
+    hclib_future_t *future_list[N + 1];
 };
-template<typename T>
+template<typename T, size_t N>
 void lambda_await_wrapper(void *raw_arg) {
-    auto arg = static_cast<lambda_await_args<T>*>(raw_arg);
-    delete[] arg->future_list;
-    MARK_BUSY(current_ws()->id);
-    (*arg->lambda)(); // !!! May cause a worker-swap !!!
-    MARK_OVH(current_ws()->id);
-    delete arg->lambda;
+    (void) task_name<T, lambda_await_wrapper<T, N>>::registered;
+    auto arg = static_cast<lambda_await_args<T, N>*>(raw_arg);
+    release_future_list(arg->future_list);
+    if (!hclib_is_cancelled()) {
+        MARK_BUSY(current_ws()->id);
+        arg->lambda(); // !!! May cause a worker-swap !!!
+        MARK_OVH(current_ws()->id);
+    }
     delete arg;
 }
 
+template <typename T, typename... future_list_t>
+inline lambda_await_args<T, sizeof...(future_list_t)> *
+construct_await_args(T &lambda, future_list_t... futures) {
+    auto args = new lambda_await_args<T, sizeof...(future_list_t)> {
+        lambda, { future_list_entry(futures)..., nullptr } };
+    retain_future_list(args->future_list);
+    return args;
+}
+
 /* this version also puts the result of the lambda into a promise */
 template<typename T, typename R>
 struct LambdaFutureArgs {
@@ -70,17 +193,37 @@ struct LambdaFutureArgs {
     promise_t<R> *event;
     hclib_future_t **future_list;
 };
+
+/*
+ * Put a default value on the future of a task whose finish scope is cancelled,
+ * for the types that have one. The tasks of other types still run.
+ */
+template<typename R>
+inline void put_cancelled(promise_t<R> *event, std::true_type) {
+    event->put(R());
+}
+
+template<typename R>
+inline void put_cancelled(promise_t<R> *event, std::false_type) { }
+
 // NOTE: C++11 does not allow partial specialization of function templates,
 // so instead we have to do this awkward thing with static methods.
 template<typename T, typename R>
 struct LambdaFutureWrapper {
     static void fn(void *raw_arg) {
+        (void) task_name<T, LambdaFutureWrapper<T, R>::fn>::registered;
         auto arg = static_cast<LambdaFutureArgs<T,R>*>(raw_arg);
-        delete[] arg->future_list;
-        MARK_BUSY(current_ws()->id);
-        R res = (*arg->lambda)(); // !!! May cause a worker-swap !!!
-        MARK_OVH(current_ws()->id);
-        arg->event->put(res);
+        delete_future_list(arg->future_list);
+        typedef typename std::is_default_constructible<R>::type has_default;
+        if (has_default::value && hclib_is_cancelled()) {
+            put_cancelled(arg->event, has_default());
+        } else {
+            MARK_BUSY(current_ws()->id);
+            R res = (*arg->lambda)(); // !!! May cause a worker-swap !!!
+            MARK_OVH(current_ws()->id);
+            arg->event->put(std::move(res));
+        }
+        hclib_promise_release(arg->event);
         delete arg->lambda;
         delete arg;
     }
@@ -88,12 +231,16 @@ struct LambdaFutureWrapper {
 template<typename T>
 struct LambdaFutureWrapper<T, void> {
     static void fn(void *raw_arg) {
+        (void) task_name<T, LambdaFutureWrapper<T, void>::fn>::registered;
         auto arg = static_cast<LambdaFutureArgs<T, void>*>(raw_arg);
-        delete[] arg->future_list;
-        MARK_BUSY(current_ws()->id);
-        (*arg->lambda)(); // !!! May cause a worker-swap !!!
-        MARK_OVH(current_ws()->id);
+        delete_future_list(arg->future_list);
+        if (!hclib_is_cancelled()) {
+            MARK_BUSY(current_ws()->id);
+            (*arg->lambda)(); // !!! May cause a worker-swap !!!
+            MARK_OVH(current_ws()->id);
+        }
         arg->event->put();
+        hclib_promise_release(arg->event);
         delete arg->lambda;
         delete arg;
     }
@@ -103,77 +250,214 @@ template <typename T>
 inline void async(T &&lambda) {
     MARK_OVH(current_ws()->id);
     typedef typename std::remove_reference<T>::type U;
-    hclib_async(lambda_wrapper<U>, new U(lambda), nullptr, nullptr, nullptr, 0);
+    if (record_lambda<U>(lambda, nullptr, nullptr)) {
+        return;
+    }
+    hclib_async(lambda_wrapper<U>, new U(lambda), nullptr, nullptr, nullptr,
+            UNCANCELLABLE_ASYNC);
 }
 
 template <typename T>
 inline void async_at_hpt(place_t* pl, T &&lambda) {
     MARK_OVH(current_ws()->id);
     typedef typename std::remove_reference<T>::type U;
-    hclib_async(lambda_wrapper<U>, new U(lambda), nullptr, nullptr, pl, 0);
+    if (record_lambda<U>(lambda, nullptr, pl)) {
+        return;
+    }
+    hclib_async(lambda_wrapper<U>, new U(lambda), nullptr, nullptr, pl,
+            UNCANCELLABLE_ASYNC);
 }
 
 template <typename T>
 inline void async_await(T &&lambda, hclib_future_t **fs) {
     MARK_OVH(current_ws()->id);
     typedef typename std::remove_reference<T>::type U;
-    hclib_async(lambda_wrapper<U>, new U(lambda), fs, nullptr, nullptr, 0);
-}
-
-template <typename... Ts>
-inline hclib_future_t **construct_future_list(Ts... futures) {
-    const size_t n = sizeof...(futures); // parameter pack count
-    return new hclib_future_t*[n+1] { futures..., nullptr };
+    if (record_lambda<U>(lambda, fs, nullptr)) {
+        return;
+    }
+    hclib_async(lambda_wrapper<U>, new U(lambda), fs, nullptr, nullptr,
+            UNCANCELLABLE_ASYNC);
 }
 
 template <typename T, typename... future_list_t>
 inline void async_await(T &&lambda, future_list_t... futures) {
     MARK_OVH(current_ws()->id);
     typedef typename std::remove_reference<T>::type U;
-    hclib_future_t **fs = construct_future_list(futures...);
-    lambda_await_args<U> *args = new lambda_await_args<U> { new U(lambda), fs };
-    hclib_async(lambda_await_wrapper<U>, args,
-            fs, nullptr, nullptr, 0);
+    hclib_future_t *fs[] = { future_list_entry(futures)..., nullptr };
+    if (record_lambda<U>(lambda, fs, nullptr)) {
+        return;
+    }
+    auto args = construct_await_args<U>(lambda, futures...);
+    hclib_async(lambda_await_wrapper<U, sizeof...(futures)>, args,
+            args->future_list, nullptr, nullptr, UNCANCELLABLE_ASYNC);
 }
 
 template <typename T>
 inline void async_await_at(T &&lambda, place_t *pl, hclib_future_t **fs) {
     MARK_OVH(current_ws()->id);
     typedef typename std::remove_reference<T>::type U;
-    hclib_async(lambda_wrapper<U>, new U(lambda), fs, nullptr, pl, 0);
+    if (record_lambda<U>(lambda, fs, pl)) {
+        return;
+    }
+    hclib_async(lambda_wrapper<U>, new U(lambda), fs, nullptr, pl,
+            UNCANCELLABLE_ASYNC);
 }
 
 template <typename T, typename... future_list_t>
 inline void async_await_at(T &&lambda, place_t *pl, future_list_t... futures) {
     MARK_OVH(current_ws()->id);
     typedef typename std::remove_reference<T>::type U;
-    hclib_future_t **fs = construct_future_list(futures...);
-    lambda_await_args<U> *args = new lambda_await_args<U> { new U(lambda), fs };
-    hclib_async(lambda_await_wrapper<U>, args,
-            fs, nullptr, pl, 0);
+    hclib_future_t *fs[] = { future_list_entry(futures)..., nullptr };
+    if (record_lambda<U>(lambda, fs, pl)) {
+        return;
+    }
+    auto args = construct_await_args<U>(lambda, futures...);
+    hclib_async(lambda_await_wrapper<U, sizeof...(futures)>, args,
+            args->future_list, nullptr, pl, UNCANCELLABLE_ASYNC);
 }
 
 template <typename T>
-auto async_future(T &&lambda) -> hclib::future_t<decltype(lambda())>* {
+inline void async_phased(T &&lambda, hclib_phased_t *phased) {
+    MARK_OVH(current_ws()->id);
+    typedef typename std::remove_reference<T>::type U;
+    hclib_async(lambda_wrapper<U>, new U(lambda), nullptr, phased, nullptr,
+            UNCANCELLABLE_ASYNC);
+}
+
+template <typename T>
+inline void async_phased(T &&lambda, hclib_phaser_t *phaser,
+        hclib_phaser_mode_t mode) {
+    hclib_phased_t phased = { 1, &phaser, &mode };
+    async_phased(lambda, &phased);
+}
+
+/*
+ * The promise of an async_future is deleted once the returned shared_future
+ * (and all of its copies) and the async itself are done with it.
+ */
+template <typename T>
+auto async_future(T &&lambda) -> hclib::shared_future<decltype(lambda())> {
     typedef decltype(lambda()) R;
     typedef typename std::remove_reference<T>::type U;
-    // FIXME - memory leak? (no handle to destroy the promise)
+    check_not_capturing("hclib::async_future");
     hclib::promise_t<R> *event = new hclib::promise_t<R>();
+    hclib_promise_retain(event); // released by the async once put
     auto args = new LambdaFutureArgs<U,R> { new U(lambda), event, nullptr };
-    hclib_async(LambdaFutureWrapper<U,R>::fn, args, nullptr, nullptr, nullptr, 0);
-    return event->get_future();
+    hclib_async(LambdaFutureWrapper<U,R>::fn, args, nullptr, nullptr, nullptr,
+            UNCANCELLABLE_ASYNC);
+    return hclib::shared_future<R>(event);
 }
 
 template <typename T, typename... future_list_t>
-auto async_future_await(T &&lambda, future_list_t... futures) -> hclib::future_t<decltype(lambda())>* {
+auto async_future_await(T &&lambda, future_list_t... futures) -> hclib::shared_future<decltype(lambda())> {
     typedef decltype(lambda()) R;
     typedef typename std::remove_reference<T>::type U;
-    // FIXME - memory leak? (no handle to destroy the promise)
+    check_not_capturing("hclib::async_future_await");
     hclib::promise_t<R> *event = new hclib::promise_t<R>();
+    hclib_promise_retain(event); // released by the async once put
     hclib_future_t **fs = construct_future_list(futures...);
     auto args = new LambdaFutureArgs<U,R> { new U(lambda), event, fs };
-    hclib_async(LambdaFutureWrapper<U,R>::fn, args, fs, nullptr, nullptr, 0);
-    return event->get_future();
+    hclib_async(LambdaFutureWrapper<U,R>::fn, args, fs, nullptr, nullptr,
+            UNCANCELLABLE_ASYNC);
+    return hclib::shared_future<R>(event);
+}
+
+/*
+ * Continuation of a future (see future_t::then), which holds its own reference
+ * on the future so as to retrieve its value after the future list is gone.
+ */
+template<typename T, typename F>
+struct continuation_t {
+    F lambda;
+    future_t<T> *future;
+
+    typename continuation_result<T, F>::type operator()() {
+        // copied, as other consumers of the future may read it as well
+        T value = future->get_shared();
+        hclib_promise_release(future->owner);
+        return lambda(std::forward<T>(value));
+    }
+};
+
+template<typename F>
+struct continuation_t<void, F> {
+    F lambda;
+    future_t<void> *future;
+
+    typename continuation_result<void, F>::type operator()() {
+        hclib_promise_release(future->owner);
+        return lambda();
+    }
+};
+
+template<typename T, typename F>
+shared_future<typename continuation_result<T, F>::type> future_then(
+        future_t<T> *future, F &&lambda) {
+    MARK_OVH(current_ws()->id);
+    typedef typename continuation_result<T, F>::type R;
+    typedef continuation_t<T, typename std::decay<F>::type> C;
+    check_not_capturing("hclib::future_t::then");
+    hclib::promise_t<R> *event = new hclib::promise_t<R>();
+    hclib_promise_retain(event); // released by the continuation once put
+    hclib_promise_retain(future->owner);
+    hclib_future_t **fs = construct_future_list(
+            static_cast<hclib_future_t*>(future));
+    auto args = new LambdaFutureArgs<C,R> { new C { lambda, future }, event,
+        fs };
+    hclib_async(LambdaFutureWrapper<C,R>::fn, args, fs, nullptr, nullptr,
+            UNCANCELLABLE_ASYNC);
+    return hclib::shared_future<R>(event);
+}
+
+template<typename R>
+struct continuation_put {
+    template<typename C>
+    static void run(hclib::promise_t<R> *event, C &body) {
+        event->put(body());
+    }
+};
+
+template<>
+struct continuation_put<void> {
+    template<typename C>
+    static void run(hclib::promise_t<void> *event, C &body) {
+        body();
+        event->put();
+    }
+};
+
+/*
+ * Continuation run in place by a trigger on its future (see then_inline), in a
+ * single allocation besides its result promise.
+ */
+template<typename C, typename R>
+struct inline_continuation_t {
+    hclib_continuation_t continuation;
+    C body;
+    hclib::promise_t<R> *event;
+
+    static void fn(void *arg) {
+        auto self = static_cast<inline_continuation_t*>(arg);
+        continuation_put<R>::run(self->event, self->body);
+        hclib_promise_release(self->event);
+        delete self;
+    }
+};
+
+template<typename T, typename F>
+shared_future<typename continuation_result<T, F>::type> future_then_inline(
+        future_t<T> *future, F &&lambda) {
+    MARK_OVH(current_ws()->id);
+    typedef typename continuation_result<T, F>::type R;
+    typedef continuation_t<T, typename std::decay<F>::type> C;
+    typedef inline_continuation_t<C, R> I;
+    hclib::promise_t<R> *event = new hclib::promise_t<R>();
+    hclib_promise_retain(event); // released by the continuation once put
+    hclib_promise_retain(future->owner);
+    I *continuation = new I { {}, C { lambda, future }, event };
+    hclib_future_then_inline(future, &continuation->continuation, I::fn,
+            continuation);
+    return hclib::shared_future<R>(event);
 }
 
 template <typename T>
@@ -184,12 +468,12 @@ inline void finish(T &&lambda) {
 }
 
 template <typename T>
-inline hclib::future_t<void> *nonblocking_finish(T &&lambda) {
+inline hclib::shared_future<void> nonblocking_finish(T &&lambda) {
     hclib_start_finish();
     lambda();
     hclib::promise_t<void> *event = new hclib::promise_t<void>();
     hclib_end_finish_nonblocking_helper(event);
-    return event->get_future();
+    return hclib::shared_future<void>(event);
 }
 
 }
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_CANCEL_H_
+#define HCLIB_CANCEL_H_
+
+/**
+ * @file Cancellation of the tasks of a finish scope.
+ *
+ * A finish scope started with a cancellation token stops running its tasks
+ * once the token is cancelled: tasks that have not started yet are dropped
+ * when a worker picks them up, and are still accounted for so that the finish
+ * ends as usual. Running tasks are left alone, but can check
+ * hclib_is_cancelled to stop early. Nested finish scopes inherit the token of
+ * their parent, on top of their own if they have one.
+ *
+ * Tasks spawned with UNCANCELLABLE_ASYNC always run. Those that satisfy a
+ * future (hclib_async_future) are still run to put on it, but without calling
+ * their function: the future gets NULL, or a default-constructed value for
+ * hclib::async_future (whose task runs as usual if its type has none).
+ * Forasync tasks run but skip their iterations, and the nodes of a graph
+ * launched by hclib_graph_launch skip their function but still make their
+ * successors ready, so that the launch completes.
+ */
+
+/**
+ * @brief Opaque type for cancellation tokens.
+ */
+typedef struct hclib_cancel_token_st hclib_cancel_token_t;
+
+hclib_cancel_token_t *hclib_cancel_token_create();
+
+/*
+ * Free a token, whose finish scope must have ended.
+ */
+void hclib_cancel_token_free(hclib_cancel_token_t *token);
+
+/*
+ * Start a finish scope that can be cancelled through token, which may only be
+ * used by one finish scope at a time. It is ended by hclib_end_finish.
+ */
+void hclib_start_finish_cancellable(hclib_cancel_token_t *token);
+
+/*
+ * Cancel the finish scope of token, and all the scopes nested in it. This
+ * cannot be undone.
+ */
+void hclib_cancel(hclib_cancel_token_t *token);
+
+int hclib_cancel_token_is_cancelled(hclib_cancel_token_t *token);
+
+/*
+ * Returns 1 if the current finish scope, or one it is nested in, has been
+ * cancelled.
+ */
+int hclib_is_cancelled();
+
+#endif /* HCLIB_CANCEL_H_ */
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_CANCEL_HPP_
+#define HCLIB_CANCEL_HPP_
+
+#include "hclib-cancel.h"
+
+namespace hclib {
+
+/*
+ * Cancellation token, see hclib-cancel.h.
+ */
+class cancel_token {
+    hclib_cancel_token_t *token_;
+
+public:
+    cancel_token() : token_(hclib_cancel_token_create()) { }
+    ~cancel_token() { hclib_cancel_token_free(token_); }
+    cancel_token(const cancel_token &) = delete;
+    cancel_token &operator=(const cancel_token &) = delete;
+
+    void cancel() { hclib_cancel(token_); }
+    bool cancelled() const { return hclib_cancel_token_is_cancelled(token_); }
+    hclib_cancel_token_t *handle() const { return token_; }
+};
+
+/*
+ * Run lambda in a finish scope that can be cancelled through token.
+ */
+template <typename T>
+inline void cancellable_finish(cancel_token &token, T &&lambda) {
+    hclib_start_finish_cancellable(token.handle());
+    lambda();
+    hclib_end_finish();
+}
+
+inline bool is_cancelled() {
+    return hclib_is_cancelled();
+}
+
+}
+
+#endif /* HCLIB_CANCEL_HPP_ */
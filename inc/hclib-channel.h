@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_CHANNEL_H_
+#define HCLIB_CHANNEL_H_
+
+#include "hclib-promise.h"
+
+/**
+ * @file Bounded multi-producer multi-consumer channels between tasks.
+ *
+ * Unlike promises, a channel carries any number of values, which are
+ * pointer-sized as with the datum of a promise. A task that sends to a full
+ * channel, or receives from an empty one, is suspended in the same way as in
+ * hclib_future_wait, leaving its worker free to run other tasks, and resumes
+ * once the value can go through.
+ */
+
+/**
+ * @brief Opaque type for channels.
+ */
+typedef struct hclib_channel_st hclib_channel_t;
+
+/*
+ * Create a channel buffering up to capacity values. With a capacity of 0, each
+ * send waits for a matching receive.
+ */
+hclib_channel_t *hclib_channel_create(int capacity);
+
+/*
+ * Free a channel, which no task may be waiting on anymore.
+ */
+void hclib_channel_free(hclib_channel_t *channel);
+
+/*
+ * Send value, waiting for room in the channel if it is full. Returns 1 once the
+ * value is in the channel, or 0 if the channel was closed first.
+ */
+int hclib_channel_send(hclib_channel_t *channel, void *value);
+
+/*
+ * Receive the next value into *value, waiting for one if the channel is empty.
+ * Returns 1 on success, or 0 if the channel is closed and has no values left.
+ */
+int hclib_channel_recv(hclib_channel_t *channel, void **value);
+
+/*
+ * Receive the next value into *value without waiting. The returned future is
+ * satisfied once that is done, with a datum of (void *) 1, or with a NULL datum
+ * if the channel is closed and has no values left. *value must stay valid
+ * until then. The future can be handed back with hclib_future_release.
+ */
+hclib_future_t *hclib_channel_recv_async(hclib_channel_t *channel,
+        void **value);
+
+/*
+ * Close the channel. Values already sent can still be received, but any
+ * further send fails, as do sends waiting for room in the channel.
+ */
+void hclib_channel_close(hclib_channel_t *channel);
+
+#endif /* HCLIB_CHANNEL_H_ */
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_CHANNEL_HPP_
+#define HCLIB_CHANNEL_HPP_
+
+#include "hclib-channel.h"
+#include "hclib-async.hpp"
+
+namespace hclib {
+
+/*
+ * Values go through the underlying hclib_channel_t as is when they fit in a
+ * pointer (see future_stores_inline), and are moved to the heap otherwise.
+ */
+template<typename T, bool Boxed = future_stores_inline<T>::value>
+struct channel_value;
+
+template<typename T>
+struct channel_value<T, false> {
+    static void *wrap(T value) {
+        void *tmp = nullptr;
+        *reinterpret_cast<T*>(&tmp) = value;
+        return tmp;
+    }
+
+    static T unwrap(void *datum) {
+        return future_datum<T>::take(datum);
+    }
+
+    static void discard(void *datum) { }
+};
+
+template<typename T>
+struct channel_value<T, true> {
+    static void *wrap(T &&value) {
+        return new T(std::move(value));
+    }
+
+    static T unwrap(void *datum) {
+        T *box = static_cast<T*>(datum);
+        T value(std::move(*box));
+        delete box;
+        return value;
+    }
+
+    static void discard(void *datum) {
+        delete static_cast<T*>(datum);
+    }
+};
+
+/*
+ * Bounded multi-producer multi-consumer channel of T values (see
+ * hclib-channel.h).
+ */
+template<typename T>
+class channel {
+    hclib_channel_t *ch;
+
+    // A recv_async, completed in place once the underlying receive is done
+    struct receive_t {
+        hclib_continuation_t continuation;
+        hclib_future_t *received;
+        void *slot;
+        T *value;
+        promise_t<bool> *ok;
+
+        static void fn(void *arg) {
+            receive_t *receive = static_cast<receive_t*>(arg);
+            const bool ok = hclib_future_get(receive->received) != nullptr;
+            if (ok) {
+                *receive->value = channel_value<T>::unwrap(receive->slot);
+            }
+            hclib_future_release(receive->received);
+            receive->ok->put(ok);
+            hclib_promise_release(receive->ok);
+            delete receive;
+        }
+    };
+
+  public:
+    explicit channel(int capacity) : ch(hclib_channel_create(capacity)) { }
+
+    ~channel() {
+        close();
+        void *datum;
+        while (hclib_channel_recv(ch, &datum)) {
+            channel_value<T>::discard(datum);
+        }
+        hclib_channel_free(ch);
+    }
+
+    channel(const channel&) = delete;
+    channel &operator=(const channel&) = delete;
+
+    // Returns false if the channel was closed before value could be sent.
+    bool send(T value) {
+        void *datum = channel_value<T>::wrap(std::move(value));
+        if (hclib_channel_send(ch, datum)) {
+            return true;
+        }
+        channel_value<T>::discard(datum);
+        return false;
+    }
+
+    // Returns false if the channel is closed and has no values left.
+    bool recv(T &value) {
+        void *datum;
+        if (!hclib_channel_recv(ch, &datum)) {
+            return false;
+        }
+        value = channel_value<T>::unwrap(datum);
+        return true;
+    }
+
+    /*
+     * Receive the next value into value, which must stay valid until the
+     * returned future is satisfied, with the result recv would have returned.
+     */
+    shared_future<bool> recv_async(T &value) {
+        receive_t *receive = new receive_t();
+        receive->value = &value;
+        receive->ok = new promise_t<bool>();
+        hclib_promise_retain(receive->ok); // released once put
+        shared_future<bool> ok(receive->ok);
+        receive->received = hclib_channel_recv_async(ch, &receive->slot);
+        hclib_future_then_inline(receive->received, &receive->continuation,
+                receive_t::fn, receive);
+        return ok;
+    }
+
+    void close() {
+        hclib_channel_close(ch);
+    }
+};
+
+}
+
+#endif /* HCLIB_CHANNEL_HPP_ */
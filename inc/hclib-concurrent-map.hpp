@@ -0,0 +1,455 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_CONCURRENT_MAP_HPP_
+#define HCLIB_CONCURRENT_MAP_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "hclib-accum.h"
+#include "hclib-rt.h"
+#include "hclib_common.h"
+
+namespace hclib {
+
+/*
+ * Hash map safe for concurrent use by tasks, with open addressing and linear
+ * probing. Slots are claimed and updated under a spinlock per group of
+ * GROUP_SIZE slots, and lookups only take the lock of the slot they read the
+ * value from. Erased slots are left as tombstones until the next resize.
+ *
+ * When the table is half full, it is migrated to a new one, a chunk of slots
+ * at a time, by every task that then tries to update the map. Migrated slots
+ * are marked as moved, and whoever finds a moved slot also helps until the new
+ * table is complete. Old tables are only freed with the map, since lookups may
+ * still be reading them.
+ *
+ * buffer_insert defers insertions into a buffer private to the current
+ * worker, flushed when it is full and when the finish scope the map is
+ * declared on ends (see hclib::finish in hclib-accum.hpp): each flush sorts the
+ * buffer by home slot, so that insertions walk the table in order.
+ *
+ * The map must be created after hclib_launch. K and V must be default
+ * constructible and copy assignable.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+         typename KeyEqual = std::equal_to<K>>
+class concurrent_map {
+    static const std::size_t GROUP_SIZE = 16; // slots per lock
+    static const std::size_t CHUNK_SIZE = 4096; // slots migrated at a time
+    static const std::size_t BATCH_SIZE = 16; // slots claimed per used update
+    static const std::size_t BUFFER_SIZE = 256; // buffered insertions
+
+    enum : unsigned char { EMPTY = 0, FULL, TOMBSTONE, MOVED };
+
+    struct slot_t {
+        std::atomic<unsigned char> state;
+        K key;
+        V value;
+    };
+
+    struct table_t {
+        std::size_t mask; // capacity - 1
+        slot_t *slots;
+        std::atomic<bool> *locks;
+        std::atomic<std::size_t> used; // full slots and tombstones
+        std::atomic<table_t *> next; // set once a resize started
+        std::atomic<std::size_t> next_chunk;
+        std::atomic<std::size_t> chunks_done;
+        table_t *retired; // the table this one replaced
+
+        explicit table_t(std::size_t capacity) : mask(capacity - 1),
+                slots(new slot_t[capacity]()),
+                locks(new std::atomic<bool>[capacity / GROUP_SIZE]()),
+                used(0), next(nullptr), next_chunk(0), chunks_done(0),
+                retired(nullptr) { }
+
+        ~table_t() {
+            delete[] slots;
+            delete[] locks;
+        }
+
+        std::size_t capacity() const { return mask + 1; }
+
+        std::size_t nchunks() const {
+            return (capacity() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        }
+
+        void lock(std::size_t i) {
+            std::atomic<bool> &l = locks[i / GROUP_SIZE];
+            while (l.exchange(true, std::memory_order_acquire)) {
+                while (l.load(std::memory_order_relaxed)) { }
+            }
+        }
+
+        void unlock(std::size_t i) {
+            locks[i / GROUP_SIZE].store(false, std::memory_order_release);
+        }
+    };
+
+    struct counter_t {
+        std::atomic<long> live;
+        std::size_t claimed; // slots not yet added to used
+        char pad[HCLIB_CACHE_LINE_SIZE];
+    };
+
+    struct buffered_t {
+        std::size_t hash;
+        K key;
+        V value;
+    };
+
+    struct buffer_t {
+        std::vector<buffered_t> entries;
+        char pad[HCLIB_CACHE_LINE_SIZE];
+    };
+
+    Hash hasher;
+    KeyEqual equal;
+    mutable std::atomic<table_t *> table; // lookups help resizing
+    const std::size_t min_capacity;
+    std::vector<counter_t> counters;
+    std::vector<buffer_t> buffers;
+    hclib_accum_t *flush_accum;
+
+    std::size_t hash(const K &key) const {
+        // spread out std::hash, which is the identity for integers
+        uint64_t h = hasher(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (std::size_t) h;
+    }
+
+    static std::size_t round_up(std::size_t n) {
+        std::size_t capacity = 1;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+    void start_resize(table_t *t) {
+        if (t->next.load(std::memory_order_acquire)) return;
+        std::size_t capacity = t->capacity();
+        // grow unless the table is mostly tombstones
+        if (size() * 4 > capacity) capacity *= 2;
+        table_t *n = new table_t(capacity);
+        table_t *expected = nullptr;
+        if (!t->next.compare_exchange_strong(expected, n,
+                    std::memory_order_acq_rel)) {
+            delete n;
+        }
+    }
+
+    // insert a key that is known not to be in t, while migrating to it
+    static void migrate_put(table_t *t, std::size_t h, const K &key,
+            const V &value) {
+        std::size_t i = h & t->mask;
+        for (;;) {
+            slot_t &s = t->slots[i];
+            if (s.state.load(std::memory_order_relaxed) == EMPTY) {
+                t->lock(i);
+                if (s.state.load(std::memory_order_relaxed) == EMPTY) {
+                    s.key = key;
+                    s.value = value;
+                    s.state.store(FULL, std::memory_order_release);
+                    t->unlock(i);
+                    return;
+                }
+                t->unlock(i);
+            } else {
+                i = (i + 1) & t->mask;
+            }
+        }
+    }
+
+    void migrate_chunk(table_t *t, table_t *n, std::size_t chunk) const {
+        const std::size_t end = std::min((chunk + 1) * CHUNK_SIZE,
+                t->capacity());
+        std::size_t moved = 0;
+        for (std::size_t g = chunk * CHUNK_SIZE; g < end; g += GROUP_SIZE) {
+            t->lock(g);
+            for (std::size_t i = g; i < g + GROUP_SIZE; i++) {
+                slot_t &s = t->slots[i];
+                if (s.state.load(std::memory_order_relaxed) == FULL) {
+                    migrate_put(n, hash(s.key), s.key, s.value);
+                    moved++;
+                }
+                s.state.store(MOVED, std::memory_order_release);
+            }
+            t->unlock(g);
+        }
+        n->used.fetch_add(moved, std::memory_order_relaxed);
+    }
+
+    /*
+     * Migrate chunks of t until there are none left, then wait for the other
+     * migrating tasks. Whoever migrates the last chunk installs the new table.
+     */
+    void help_resize(table_t *t) const {
+        table_t *n = t->next.load(std::memory_order_acquire);
+        const std::size_t nchunks = t->nchunks();
+        for (;;) {
+            const std::size_t chunk = t->next_chunk.fetch_add(1,
+                    std::memory_order_relaxed);
+            if (chunk >= nchunks) break;
+            migrate_chunk(t, n, chunk);
+            if (t->chunks_done.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+                    nchunks) {
+                n->retired = t;
+                table.store(n, std::memory_order_release);
+            }
+        }
+        while (table.load(std::memory_order_acquire) == t) { }
+    }
+
+    void count_claim(table_t *t) {
+        counter_t &c = counters[get_current_worker()];
+        c.live.fetch_add(1, std::memory_order_relaxed);
+        if (++c.claimed >= BATCH_SIZE) {
+            const std::size_t used = t->used.fetch_add(c.claimed,
+                    std::memory_order_relaxed) + c.claimed;
+            c.claimed = 0;
+            if (used * 2 > t->capacity()) start_resize(t);
+        }
+    }
+
+    // returns whether the key was inserted
+    bool put(std::size_t h, const K &key, const V &value, bool assign) {
+        for (;;) {
+            table_t *t = table.load(std::memory_order_acquire);
+            if (t->next.load(std::memory_order_acquire)) {
+                help_resize(t);
+                continue;
+            }
+
+            std::size_t i = h & t->mask;
+            std::size_t probes = 0;
+            while (probes <= t->mask) {
+                slot_t &s = t->slots[i];
+                const unsigned char state = s.state.load(
+                        std::memory_order_acquire);
+                if (state == EMPTY) {
+                    t->lock(i);
+                    if (s.state.load(std::memory_order_relaxed) == EMPTY) {
+                        s.key = key;
+                        s.value = value;
+                        s.state.store(FULL, std::memory_order_release);
+                        t->unlock(i);
+                        count_claim(t);
+                        return true;
+                    }
+                    // claimed in the meantime, look at it again
+                    t->unlock(i);
+                    continue;
+                }
+                if (state == MOVED) break;
+                if (state == FULL && equal(s.key, key)) {
+                    if (!assign) return false;
+                    t->lock(i);
+                    const unsigned char now = s.state.load(
+                            std::memory_order_relaxed);
+                    if (now == FULL) s.value = value;
+                    t->unlock(i);
+                    if (now == FULL) return false;
+                    if (now == MOVED) break;
+                    // erased in the meantime, keep probing
+                }
+                i = (i + 1) & t->mask;
+                probes++;
+            }
+
+            // the table is full, or being migrated
+            start_resize(t);
+            help_resize(t);
+        }
+    }
+
+    void flush(std::vector<buffered_t> &entries) {
+        const std::size_t mask = table.load(std::memory_order_acquire)->mask;
+        std::sort(entries.begin(), entries.end(),
+                [mask](const buffered_t &a, const buffered_t &b) {
+                    return (a.hash & mask) < (b.hash & mask);
+                });
+        for (const buffered_t &e : entries) {
+            put(e.hash, e.key, e.value, false);
+        }
+        entries.clear();
+    }
+
+    /*
+     * Combine operator of the accumulator that stands for the map on finish
+     * scopes. Lanes are combined in worker order and the result starts from 0,
+     * so the result counts the lanes, i.e. the buffers, done so far.
+     */
+    static void flush_lane(void *acc, const void *, void *arg) {
+        concurrent_map *map = static_cast<concurrent_map *>(arg);
+        int &worker = *static_cast<int *>(acc);
+        map->flush(map->buffers[worker++].entries);
+    }
+
+  public:
+    explicit concurrent_map(std::size_t capacity = 0) :
+            min_capacity(round_up(std::max(64 * (std::size_t)
+                            hclib_num_workers(), (std::size_t) CHUNK_SIZE))),
+            counters(hclib_num_workers()), buffers(hclib_num_workers()) {
+        table.store(new table_t(std::max(round_up(capacity * 2),
+                        min_capacity)));
+        for (counter_t &c : counters) {
+            c.live.store(0);
+            c.claimed = 0;
+        }
+        const int zero = 0;
+        flush_accum = hclib_accum_create(sizeof(int), &zero, flush_lane,
+                this);
+    }
+
+    ~concurrent_map() {
+        table_t *t = table.load();
+        while (t) {
+            table_t *retired = t->retired;
+            delete t;
+            t = retired;
+        }
+        hclib_accum_free(flush_accum);
+    }
+
+    concurrent_map(const concurrent_map &) = delete;
+    concurrent_map &operator=(const concurrent_map &) = delete;
+
+    // insert if absent, returns whether it was
+    bool insert(const K &key, const V &value) {
+        return put(hash(key), key, value, false);
+    }
+
+    void insert_or_assign(const K &key, const V &value) {
+        put(hash(key), key, value, true);
+    }
+
+    bool find(const K &key, V &value) const {
+        const std::size_t h = hash(key);
+        for (;;) {
+            table_t *t = table.load(std::memory_order_acquire);
+            std::size_t i = h & t->mask;
+            std::size_t probes = 0;
+            bool moved = false;
+            while (!moved && probes <= t->mask) {
+                slot_t &s = t->slots[i];
+                const unsigned char state = s.state.load(
+                        std::memory_order_acquire);
+                if (state == EMPTY) return false;
+                if (state == MOVED) break;
+                if (state == FULL && equal(s.key, key)) {
+                    t->lock(i);
+                    const unsigned char now = s.state.load(
+                            std::memory_order_relaxed);
+                    if (now == FULL) value = s.value;
+                    t->unlock(i);
+                    if (now != MOVED) return now == FULL;
+                    moved = true;
+                }
+                i = (i + 1) & t->mask;
+                probes++;
+            }
+            if (!t->next.load(std::memory_order_acquire)) return false;
+            /*
+             * Other slots of the table may not be migrated yet, including the
+             * one of the key, so the new table is only searched once complete.
+             */
+            help_resize(t);
+        }
+    }
+
+    bool contains(const K &key) const {
+        V value;
+        return find(key, value);
+    }
+
+    // returns whether the key was present
+    bool erase(const K &key) {
+        const std::size_t h = hash(key);
+        for (;;) {
+            table_t *t = table.load(std::memory_order_acquire);
+            if (t->next.load(std::memory_order_acquire)) {
+                help_resize(t);
+                continue;
+            }
+
+            std::size_t i = h & t->mask;
+            std::size_t probes = 0;
+            bool moved = false;
+            while (!moved && probes <= t->mask) {
+                slot_t &s = t->slots[i];
+                const unsigned char state = s.state.load(
+                        std::memory_order_acquire);
+                if (state == EMPTY) return false;
+                if (state == MOVED) break;
+                if (state == FULL && equal(s.key, key)) {
+                    t->lock(i);
+                    const unsigned char now = s.state.load(
+                            std::memory_order_relaxed);
+                    if (now == FULL) {
+                        s.state.store(TOMBSTONE, std::memory_order_relaxed);
+                    }
+                    t->unlock(i);
+                    if (now == FULL) {
+                        counters[get_current_worker()].live.fetch_sub(1,
+                                std::memory_order_relaxed);
+                    }
+                    if (now != MOVED) return now == FULL;
+                    moved = true;
+                }
+                i = (i + 1) & t->mask;
+                probes++;
+            }
+            if (!t->next.load(std::memory_order_acquire)) return false;
+            help_resize(t);
+        }
+    }
+
+    std::size_t size() const {
+        long live = 0;
+        for (const counter_t &c : counters) {
+            live += c.live.load(std::memory_order_relaxed);
+        }
+        return live < 0 ? 0 : (std::size_t) live;
+    }
+
+    /*
+     * Insert if absent, eventually: the insertion is buffered by the current
+     * worker. Only to be used by the tasks of a finish scope the map is
+     * declared on, at the end of which all buffers are flushed.
+     */
+    void buffer_insert(const K &key, const V &value) {
+        std::vector<buffered_t> &entries =
+            buffers[get_current_worker()].entries;
+        entries.push_back(buffered_t { hash(key), key, value });
+        if (entries.size() >= BUFFER_SIZE) flush(entries);
+    }
+
+    // to declare the map on a finish scope, see hclib_start_finish_accum
+    hclib_accum_t *handle() {
+        return flush_accum;
+    }
+};
+
+}
+
+#endif /* HCLIB_CONCURRENT_MAP_HPP_ */
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_COROUTINE_HPP_
+#define HCLIB_COROUTINE_HPP_
+
+/*
+ * C++20 coroutines as hclib tasks. The rest of the C++ API only needs C++11,
+ * so all of this is left out unless the compiler supports coroutines.
+ */
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define HCLIB_COROUTINES 1
+#endif
+#endif
+
+#ifdef HCLIB_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "hclib-async.hpp"
+#include "hclib-promise.hpp"
+
+namespace hclib {
+
+/*
+ * A coroutine returning T. Calling it only creates the coroutine, which then
+ * starts when co_awaited from another coroutine, running in place until its
+ * first suspension, or when handed to co_spawn.
+ *
+ * Inside a task, co_await on a future (future_t<T> *, shared_future<T> or
+ * hclib_future_t *) suspends the coroutine without blocking its worker, as
+ * hclib_future_wait does, but by registering it on the promise rather than
+ * by switching to another fiber: a suspended coroutine costs its frame and one
+ * small task, where hclib_future_wait needs a whole LiteCtx stack. The
+ * coroutine is resumed from a deque once the promise is put, in the finish
+ * scope it was suspended in.
+ */
+template <typename T = void> class task;
+
+namespace detail {
+
+/*
+ * Awaiter of a future, which lives in the frame of the suspended coroutine
+ * until the task registered on the future resumes it.
+ */
+struct future_awaiter_base {
+    hclib_future_t *deps[2];
+    struct finish_t *finish;
+    std::coroutine_handle<> handle;
+
+    explicit future_awaiter_base(hclib_future_t *future) :
+            deps { future, nullptr }, finish(nullptr) { }
+
+    bool await_ready() {
+        return hclib_future_is_satisfied(deps[0]);
+    }
+
+    static void resume(void *arg) {
+        future_awaiter_base *awaiter = static_cast<future_awaiter_base *>(arg);
+        current_ws()->current_finish = awaiter->finish;
+        awaiter->handle.resume();
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        finish = current_ws()->current_finish;
+        // the coroutine is still counted in its finish scope, see co_spawn
+        hclib_async(resume, this, deps, nullptr, nullptr, ESCAPING_ASYNC);
+    }
+};
+
+template <typename T>
+struct future_awaiter: public future_awaiter_base {
+    explicit future_awaiter(future_t<T> *future) :
+            future_awaiter_base(future) { }
+
+    T await_resume() {
+        return static_cast<future_t<T> *>(deps[0])->get();
+    }
+};
+
+// Leaves the value in the promise, for the other handles on it
+template <typename T>
+struct shared_future_awaiter: public future_awaiter_base {
+    explicit shared_future_awaiter(future_t<T> *future) :
+            future_awaiter_base(future) { }
+
+    decltype(auto) await_resume() {
+        return static_cast<future_t<T> *>(deps[0])->get_shared();
+    }
+};
+
+struct raw_future_awaiter: public future_awaiter_base {
+    explicit raw_future_awaiter(hclib_future_t *future) :
+            future_awaiter_base(future) { }
+
+    void *await_resume() {
+        return hclib_future_get(deps[0]);
+    }
+};
+
+template <typename T>
+struct is_awaited_future : std::false_type { };
+
+template <typename T>
+struct is_awaited_future<future_t<T> *> : std::true_type { };
+
+template <typename T>
+struct is_awaited_future<shared_future<T>> : std::true_type { };
+
+template <>
+struct is_awaited_future<hclib_future_t *> : std::true_type { };
+
+template <typename T>
+struct task_promise_base {
+    // holds a reference, dropped along with the frame
+    promise_t<T> *result;
+    // coroutine awaiting this one, resumed once it is done
+    std::coroutine_handle<> continuation;
+    // started by co_spawn, and destroyed once done
+    bool detached;
+
+    task_promise_base() : result(new promise_t<T>()), detached(false) { }
+
+    ~task_promise_base() {
+        hclib_promise_release(result);
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<P> h) noexcept {
+            std::coroutine_handle<> continuation = h.promise().continuation;
+            if (h.promise().detached) {
+                h.destroy();
+            }
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept { }
+    };
+
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { std::terminate(); }
+
+    template <typename U>
+    future_awaiter<U> await_transform(future_t<U> *future) {
+        return future_awaiter<U>(future);
+    }
+
+    template <typename U>
+    shared_future_awaiter<U> await_transform(const shared_future<U> &future) {
+        return shared_future_awaiter<U>(future.get_future());
+    }
+
+    raw_future_awaiter await_transform(hclib_future_t *future) {
+        return raw_future_awaiter(future);
+    }
+
+    // anything else, such as a task, is awaited as is
+    template <typename A, typename = typename std::enable_if<
+        !is_awaited_future<typename std::decay<A>::type>::value>::type>
+    A &&await_transform(A &&awaitable) {
+        return std::forward<A>(awaitable);
+    }
+};
+
+template <typename T>
+struct task_promise: public task_promise_base<T> {
+    task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U &&value) {
+        this->result->put(std::forward<U>(value));
+    }
+};
+
+template <>
+struct task_promise<void>: public task_promise_base<void> {
+    task<void> get_return_object();
+
+    void return_void() {
+        result->put();
+    }
+};
+
+}
+
+template <typename T>
+class task {
+  public:
+    typedef detail::task_promise<T> promise_type;
+
+    explicit task(std::coroutine_handle<promise_type> h) : handle(h) { }
+
+    task(task &&other) : handle(other.handle) {
+        other.handle = nullptr;
+    }
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task() {
+        if (handle) handle.destroy();
+    }
+
+    // co_await from another coroutine, starting this one in place
+    bool await_ready() { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) {
+        handle.promise().continuation = h;
+        return handle;
+    }
+
+    T await_resume() {
+        return handle.promise().result->get_future()->get();
+    }
+
+    std::coroutine_handle<promise_type> release() {
+        std::coroutine_handle<promise_type> h = handle;
+        handle = nullptr;
+        return h;
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail {
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() {
+    return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() {
+    return task<void>(
+            std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+inline void start_coroutine(void *address) {
+    std::coroutine_handle<>::from_address(address).resume();
+}
+
+}
+
+/*
+ * Start t as a new task in the current finish scope, which does not end before
+ * the coroutine is done. Returns the future of its result.
+ */
+template <typename T>
+shared_future<T> co_spawn(task<T> &&t) {
+    std::coroutine_handle<detail::task_promise<T>> h = t.release();
+    h.promise().detached = true;
+    promise_t<T> *result = h.promise().result;
+    hclib_promise_retain(result); // adopted by the returned shared_future
+    // stands for the coroutine in the finish scope, across its suspensions
+    async_await([]() { }, static_cast<hclib_future_t *>(
+                result->get_future()));
+    hclib_async(detail::start_coroutine, h.address(), nullptr, nullptr,
+            nullptr, UNCANCELLABLE_ASYNC);
+    return shared_future<T>(result);
+}
+
+}
+
+#endif /* HCLIB_COROUTINES */
+
+#endif /* HCLIB_COROUTINE_HPP_ */
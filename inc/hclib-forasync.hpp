@@ -27,6 +27,11 @@
  * Forasync mode to perform static chunking of the iteration space.
  */
 #define FORASYNC_MODE_FLAT 0
+/*
+ * Forasync mode to split the iteration space lazily, when the local deque runs
+ * out of work. The tile size is ignored.
+ */
+#define FORASYNC_MODE_ADAPTIVE 2
 
 /** @struct loop_domain_t
  * @brief Describe loop domain when spawning a forasync.
@@ -48,165 +53,566 @@ union for_async_fp_union {
     forasync1D_Fct_t f1;
     forasync2D_Fct_t f2;
     forasync3D_Fct_t f3;
+    forasync_range_Fct_t range;
+    forasyncND_Fct_t nd;
+    forasyncND_range_Fct_t nd_range;
     void *vp;
 };
 
+/*
+ * A forasync loop body and the lambda it runs, in a single allocation that is
+ * shared by all the tasks of the forasync.
+ */
+template <typename T>
+struct forasync_body_holder : public forasync_body_t {
+    T lambda;
+
+    forasync_body_holder(forasync_kind_t k, void *f, const T &l,
+            void (*rel)(forasync_body_t *)) : lambda(l) {
+        fct = f;
+        arg = &lambda;
+        kind = k;
+        release = rel;
+    }
+};
+
+template <typename T>
+void forasync_body_delete(forasync_body_t *body) {
+    delete static_cast<forasync_body_holder<T> *>(body);
+}
+
+template <int DIM, typename D>
+inline void forasync_widen_domain(const D *loop, loop_domain64_t *domain) {
+    for (int d = 0; d < DIM; d++) {
+        domain[d].low = loop[d].low;
+        domain[d].high = loop[d].high;
+        domain[d].stride = loop[d].stride;
+        domain[d].tile = loop[d].tile;
+    }
+}
+
+/*
+ * Launch a forasync whose body is released by the runtime once the last of
+ * its tasks has completed.
+ */
+template <int DIM, typename D, typename T>
+inline void forasync_launch(forasync_kind_t kind, void *fct, D *loop,
+        T &&lambda, int mode, place_t *place, hclib_future_t **future_list) {
+    HASSERT(place == NULL || is_cpu_place(place));
+    typedef typename std::decay<T>::type U;
+    forasync_body_t *body = new forasync_body_holder<U>(kind, fct, lambda,
+            forasync_body_delete<U>);
+    loop_domain64_t domain[DIM];
+    forasync_widen_domain<DIM>(loop, domain);
+    if (place || future_list) {
+        async_await_at([=]{
+                HASSERT_STATIC(sizeof(domain) == sizeof(*domain) * DIM,
+                        "The whole domain is captured by value");
+                hclib_forasync_body(body, DIM, domain, mode);
+            }, place, future_list);
+    }
+    else {
+        hclib_forasync_body(body, DIM, domain, mode);
+    }
+}
+
+/*
+ * Run a forasync to completion. Since it is waited on, its body can live on
+ * the stack.
+ */
+template <int DIM, typename D, typename T>
+inline void forasync_wait(forasync_kind_t kind, void *fct, D *loop,
+        const T &lambda, int mode) {
+    forasync_body_holder<T> body(kind, fct, lambda, nullptr);
+    loop_domain64_t domain[DIM];
+    forasync_widen_domain<DIM>(loop, domain);
+    hclib_start_finish();
+    hclib_forasync_body(&body, DIM, domain, mode);
+    hclib_end_finish();
+}
+
 template<typename T>
 void forasync1D_wrapper(void *arg, int i) {
     T* lambda = static_cast<T*>(arg);
     (*lambda)(i);
-    // FIXME - memory leak
-    // we can't delete this here (it's called in a loop)
-    // delete lambda;
 }
 
 template <typename T>
 inline void forasync1D(loop_domain_t* loop, T &&lambda,
         int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
         hclib_future_t **future_list = NULL) {
-    HASSERT(place == NULL || is_cpu_place(place));
-    constexpr int DIM = 1;
-    // copy lambda
-    typedef typename std::remove_reference<T>::type U;
-    U *arg = new U(lambda);
     // set up wrapper function
     for_async_fp_union fp;
-    fp.f1 = forasync1D_wrapper<U>;
+    fp.f1 = forasync1D_wrapper<typename std::decay<T>::type>;
     HASSERT_STATIC(sizeof(fp.f1) == sizeof(fp.vp), "can pass as void*");
-    // launch
-    if (place || future_list) {
-        loop_domain_t domain[] = { loop[0] };
-        async_await_at([=]{
-                HASSERT_STATIC(sizeof(domain) == sizeof(*domain) * DIM,
-                        "The whole domain is captured by value");
-                hclib_forasync(fp.vp, arg, nullptr, DIM, domain, mode);
-            }, place, future_list);
-    }
-    else {
-        hclib_forasync(fp.vp, arg, nullptr, DIM, loop, mode);
-    }
+    forasync_launch<1>(FORASYNC_KIND_1D, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
 }
 
 template<typename T>
 void forasync2D_wrapper(void *arg, int i, int j) {
     T* lambda = static_cast<T*>(arg);
     (*lambda)(i, j);
-    // FIXME - memory leak
-    // we can't delete this here (it's called in a loop)
-    // delete lambda;
 }
 
 template <typename T>
 inline void forasync2D(loop_domain_t* loop, T &&lambda,
         int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
         hclib_future_t **future_list = NULL) {
-    HASSERT(place == NULL || is_cpu_place(place));
-    constexpr int DIM = 2;
-    // copy lambda
-    typedef typename std::remove_reference<T>::type U;
-    U *arg = new U(lambda);
     // set up wrapper function
     for_async_fp_union fp;
-    fp.f2 = forasync2D_wrapper<U>;
+    fp.f2 = forasync2D_wrapper<typename std::decay<T>::type>;
     HASSERT_STATIC(sizeof(fp.f2) == sizeof(fp.vp), "can pass as void*");
-    // launch
-    if (place || future_list) {
-        loop_domain_t domain[] = { loop[0], loop[1] };
-        async_await_at([=]{
-                HASSERT_STATIC(sizeof(domain) == sizeof(*domain) * DIM,
-                        "The whole domain is captured by value");
-                hclib_forasync(fp.vp, arg, nullptr, DIM, domain, mode);
-            }, place, future_list);
-    }
-    else {
-        hclib_forasync(fp.vp, arg, nullptr, DIM, loop, mode);
-    }
+    forasync_launch<2>(FORASYNC_KIND_2D, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
 }
 
 template<typename T>
 void forasync3D_wrapper(void *arg, int i, int j, int k) {
     T* lambda = static_cast<T*>(arg);
     (*lambda)(i, j, k);
-    // FIXME - memory leak
-    // we can't delete this here (it's called in a loop)
-    // delete lambda;
 }
 
 template <typename T>
 inline void forasync3D(loop_domain_t* loop, T &&lambda,
         int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
         hclib_future_t **future_list = NULL) {
-    HASSERT(place == NULL || is_cpu_place(place));
-    constexpr int DIM = 3;
-    // copy lambda
-    typedef typename std::remove_reference<T>::type U;
-    U *arg = new U(lambda);
     // set up wrapper function
     for_async_fp_union fp;
-    fp.f3 = forasync3D_wrapper<U>;
+    fp.f3 = forasync3D_wrapper<typename std::decay<T>::type>;
     HASSERT_STATIC(sizeof(fp.f3) == sizeof(fp.vp), "can pass as void*");
-    // launch
-    if (place || future_list) {
-        loop_domain_t domain[] = { loop[0], loop[1], loop[2] };
-        async_await_at([=]{
-                HASSERT_STATIC(sizeof(domain) == sizeof(*domain) * DIM,
-                        "the whole domain is captured by value");
-                hclib_forasync(fp.vp, arg, nullptr, DIM, domain, mode);
-            }, place, future_list);
-    }
-    else {
-        hclib_forasync(fp.vp, arg, nullptr, DIM, loop, mode);
-    }
+    forasync_launch<3>(FORASYNC_KIND_3D, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
 }
 
 
 template <typename T>
-inline hclib::future_t<void> *forasync1D_future(loop_domain_t* loop, T &&lambda,
+inline hclib::shared_future<void> forasync1D_future(loop_domain_t* loop, T &&lambda,
         int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
         hclib_future_t **future_list = NULL) {
     hclib_start_finish();
     forasync1D(loop, std::forward<decltype(lambda)>(lambda),
             mode, place, future_list);
-    // FIXME - memory leak? (no handle to destroy the promise)
     hclib::promise_t<void> *event = new hclib::promise_t<void>();
     hclib_end_finish_nonblocking_helper(event);
-    return event->get_future();
+    return hclib::shared_future<void>(event);
 }
 
 template <typename T>
-inline hclib::future_t<void> *forasync2D_future(loop_domain_t* loop, T &&lambda,
+inline hclib::shared_future<void> forasync2D_future(loop_domain_t* loop, T &&lambda,
         int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
         hclib_future_t **future_list = NULL) {
     hclib_start_finish();
     forasync2D(loop, std::forward<decltype(lambda)>(lambda),
             mode, place, future_list);
-    // FIXME - memory leak? (no handle to destroy the promise)
     hclib::promise_t<void> *event = new hclib::promise_t<void>();
     hclib_end_finish_nonblocking_helper(event);
-    return event->get_future();
+    return hclib::shared_future<void>(event);
 }
 
 template <typename T>
-inline hclib::future_t<void> *forasync3D_future(loop_domain_t* loop, T &&lambda,
+inline hclib::shared_future<void> forasync3D_future(loop_domain_t* loop, T &&lambda,
         int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
         hclib_future_t **future_list = NULL) {
     hclib_start_finish();
     forasync3D(loop, std::forward<decltype(lambda)>(lambda),
             mode, place, future_list);
-    // FIXME - memory leak? (no handle to destroy the promise)
     hclib::promise_t<void> *event = new hclib::promise_t<void>();
     hclib_end_finish_nonblocking_helper(event);
-    return event->get_future();
+    return hclib::shared_future<void>(event);
 }
 
 // TODO - Do we also need parameter-pack versions of the other forasyncs?
 template <typename T, typename... future_list_t>
-inline hclib::future_t<void> *forasync1D_future(loop_domain_t* loop, T &&lambda,
-        int mode, place_t *place, future_list_t... futures) {
-    // FIXME - memory leak
-    hclib_future_t **future_list = construct_future_list(futures...);
-    return forasync1D_future(loop, std::forward<decltype(lambda)>(lambda),
+inline hclib::shared_future<void> forasync1D_future(loop_domain_t* loop,
+        T &&lambda, int mode, place_t *place, future_list_t... futures) {
+    HASSERT(place == NULL || is_cpu_place(place));
+    typedef typename std::decay<T>::type U;
+    loop_domain_t domain = loop[0];
+    U body(lambda);
+    hclib_start_finish();
+    async_await_at([=]() mutable {
+            forasync1D(&domain, body, mode);
+        }, place, futures...);
+    hclib::promise_t<void> *event = new hclib::promise_t<void>();
+    hclib_end_finish_nonblocking_helper(event);
+    return hclib::shared_future<void>(event);
+}
+
+
+/*
+ * Range-based forasyncs: rather than once per iteration, the lambda is called
+ * once per tile with the sub-domain ([low, high) with stride) that the tile
+ * covers in each dimension, outermost first. The lambda then runs the
+ * innermost loop itself, which lets the compiler vectorize it and avoids a
+ * function call per iteration.
+ */
+template<typename T>
+void forasync1D_range_wrapper(void *arg, const loop_domain_t *chunk) {
+    T* lambda = static_cast<T*>(arg);
+    (*lambda)(chunk[0]);
+}
+
+template<typename T>
+void forasync2D_range_wrapper(void *arg, const loop_domain_t *chunk) {
+    T* lambda = static_cast<T*>(arg);
+    (*lambda)(chunk[0], chunk[1]);
+}
+
+template<typename T>
+void forasync3D_range_wrapper(void *arg, const loop_domain_t *chunk) {
+    T* lambda = static_cast<T*>(arg);
+    (*lambda)(chunk[0], chunk[1], chunk[2]);
+}
+
+template <typename T>
+inline void forasync1D_range(loop_domain_t* loop, T &&lambda,
+        int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    for_async_fp_union fp;
+    fp.range = forasync1D_range_wrapper<typename std::decay<T>::type>;
+    forasync_launch<1>(FORASYNC_KIND_RANGE, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
+}
+
+template <typename T>
+inline void forasync2D_range(loop_domain_t* loop, T &&lambda,
+        int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    for_async_fp_union fp;
+    fp.range = forasync2D_range_wrapper<typename std::decay<T>::type>;
+    forasync_launch<2>(FORASYNC_KIND_RANGE, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
+}
+
+template <typename T>
+inline void forasync3D_range(loop_domain_t* loop, T &&lambda,
+        int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    for_async_fp_union fp;
+    fp.range = forasync3D_range_wrapper<typename std::decay<T>::type>;
+    forasync_launch<3>(FORASYNC_KIND_RANGE, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
+}
+
+template <typename T>
+inline hclib::shared_future<void> forasync1D_range_future(loop_domain_t* loop,
+        T &&lambda, int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    hclib_start_finish();
+    forasync1D_range(loop, std::forward<decltype(lambda)>(lambda),
+            mode, place, future_list);
+    hclib::promise_t<void> *event = new hclib::promise_t<void>();
+    hclib_end_finish_nonblocking_helper(event);
+    return hclib::shared_future<void>(event);
+}
+
+template <typename T>
+inline hclib::shared_future<void> forasync2D_range_future(loop_domain_t* loop,
+        T &&lambda, int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    hclib_start_finish();
+    forasync2D_range(loop, std::forward<decltype(lambda)>(lambda),
+            mode, place, future_list);
+    hclib::promise_t<void> *event = new hclib::promise_t<void>();
+    hclib_end_finish_nonblocking_helper(event);
+    return hclib::shared_future<void>(event);
+}
+
+template <typename T>
+inline hclib::shared_future<void> forasync3D_range_future(loop_domain_t* loop,
+        T &&lambda, int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    hclib_start_finish();
+    forasync3D_range(loop, std::forward<decltype(lambda)>(lambda),
+            mode, place, future_list);
+    hclib::promise_t<void> *event = new hclib::promise_t<void>();
+    hclib_end_finish_nonblocking_helper(event);
+    return hclib::shared_future<void>(event);
+}
+
+/*
+ * N-dimensional forasyncs over 64-bit domains. The lambda takes one int64_t
+ * index per dimension (or, for the range variants, one
+ * const loop_domain64_t& per dimension), outermost first:
+ *
+ *   hclib::forasync<4>(loop, [=](int64_t i, int64_t j, int64_t k,
+ *           int64_t l) { ... });
+ */
+template <std::size_t... I>
+struct forasync_index_seq { };
+
+template <std::size_t N, std::size_t... I>
+struct forasync_make_index_seq :
+        forasync_make_index_seq<N - 1, N - 1, I...> { };
+
+template <std::size_t... I>
+struct forasync_make_index_seq<0, I...> {
+    typedef forasync_index_seq<I...> type;
+};
+
+template <typename T, std::size_t... I>
+inline void forasync_nd_call(T *lambda, const int64_t *index,
+        forasync_index_seq<I...>) {
+    (*lambda)(index[I]...);
+}
+
+template <typename T, std::size_t... I>
+inline void forasync_nd_range_call(T *lambda, const loop_domain64_t *chunk,
+        forasync_index_seq<I...>) {
+    (*lambda)(chunk[I]...);
+}
+
+template <int N, typename T>
+void forasync_nd_wrapper(void *arg, const int64_t *index) {
+    forasync_nd_call(static_cast<T*>(arg), index,
+            typename forasync_make_index_seq<N>::type());
+}
+
+template <int N, typename T>
+void forasync_nd_range_wrapper(void *arg, const loop_domain64_t *chunk) {
+    forasync_nd_range_call(static_cast<T*>(arg), chunk,
+            typename forasync_make_index_seq<N>::type());
+}
+
+template <int N, typename T>
+inline void forasync(loop_domain64_t *loop, T &&lambda,
+        int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    static_assert(N > 0 && N <= HCLIB_FORASYNC_MAX_DIM,
+            "unsupported forasync dimension");
+    for_async_fp_union fp;
+    fp.nd = forasync_nd_wrapper<N, typename std::decay<T>::type>;
+    forasync_launch<N>(FORASYNC_KIND_ND, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
+}
+
+template <int N, typename T>
+inline void forasync_range(loop_domain64_t *loop, T &&lambda,
+        int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    static_assert(N > 0 && N <= HCLIB_FORASYNC_MAX_DIM,
+            "unsupported forasync dimension");
+    for_async_fp_union fp;
+    fp.nd_range = forasync_nd_range_wrapper<N, typename std::decay<T>::type>;
+    forasync_launch<N>(FORASYNC_KIND_ND_RANGE, fp.vp, loop,
+            std::forward<T>(lambda), mode, place, future_list);
+}
+
+template <int N, typename T>
+inline hclib::shared_future<void> forasync_future(loop_domain64_t *loop,
+        T &&lambda, int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    hclib_start_finish();
+    forasync<N>(loop, std::forward<decltype(lambda)>(lambda),
+            mode, place, future_list);
+    hclib::promise_t<void> *event = new hclib::promise_t<void>();
+    hclib_end_finish_nonblocking_helper(event);
+    return hclib::shared_future<void>(event);
+}
+
+template <int N, typename T>
+inline hclib::shared_future<void> forasync_range_future(loop_domain64_t *loop,
+        T &&lambda, int mode = FORASYNC_MODE_RECURSIVE, place_t *place = NULL,
+        hclib_future_t **future_list = NULL) {
+    hclib_start_finish();
+    forasync_range<N>(loop, std::forward<decltype(lambda)>(lambda),
             mode, place, future_list);
+    hclib::promise_t<void> *event = new hclib::promise_t<void>();
+    hclib_end_finish_nonblocking_helper(event);
+    return hclib::shared_future<void>(event);
+}
+
+/*
+ * Per-worker partial results for the forasync reductions below. Every worker
+ * accumulates into its own slot, and each slot is padded out to a separate
+ * cache line so that no two workers ever write to the same line. The slots are
+ * folded together once all the tasks of the forasync have completed.
+ */
+template <typename T>
+class forasync_reduce_partials {
+    struct slot_t {
+        T val;
+        char pad[HCLIB_CACHE_LINE_SIZE];
+    };
+
+    slot_t *slots;
+    const int nslots;
+
+  public:
+    explicit forasync_reduce_partials(const T &identity) :
+            nslots(hclib_num_workers()) {
+        slots = new slot_t[nslots];
+        for (int i = 0; i < nslots; i++) {
+            slots[i].val = identity;
+        }
+    }
+
+    ~forasync_reduce_partials() {
+        delete[] slots;
+    }
+
+    forasync_reduce_partials(const forasync_reduce_partials&) = delete;
+    forasync_reduce_partials &operator=(const forasync_reduce_partials&) = delete;
+
+    /*
+     * The value must be computed before calling this, since the user's map
+     * function may cause a worker-swap. Called once per tile.
+     */
+    template <typename C>
+    void accumulate(const T &val, C &combine) {
+        T &acc = slots[get_current_worker()].val;
+        acc = combine(acc, val);
+    }
+
+    template <typename C>
+    T fold(const T &identity, C &combine) const {
+        T res = identity;
+        for (int i = 0; i < nslots; i++) {
+            res = combine(res, slots[i].val);
+        }
+        return res;
+    }
+};
+
+/*
+ * Parallel reductions over a forasync domain. The map function is called once
+ * for each point in the domain, and its results are combined using the
+ * (associative and commutative) combine function, starting from identity.
+ * These block until the reduction is complete, as if they were wrapped in a
+ * finish scope.
+ */
+template <typename T, typename M, typename C>
+inline T forasync1D_reduce(loop_domain_t *loop, T identity, M &&map,
+        C &&combine, int mode = FORASYNC_MODE_RECURSIVE) {
+    forasync_reduce_partials<T> partials(identity);
+    forasync_reduce_partials<T> *p = &partials;
+    auto body = [=](const loop_domain_t &c0) mutable {
+        T acc = identity;
+        for (int i = c0.low; i < c0.high; i += c0.stride) {
+            acc = combine(acc, map(i)); // !!! May cause a worker-swap !!!
+        }
+        p->accumulate(acc, combine);
+    };
+    for_async_fp_union fp;
+    fp.range = forasync1D_range_wrapper<decltype(body)>;
+    forasync_wait<1>(FORASYNC_KIND_RANGE, fp.vp, loop, body, mode);
+    return partials.fold(identity, combine);
+}
+
+template <typename T, typename M, typename C>
+inline T forasync2D_reduce(loop_domain_t *loop, T identity, M &&map,
+        C &&combine, int mode = FORASYNC_MODE_RECURSIVE) {
+    forasync_reduce_partials<T> partials(identity);
+    forasync_reduce_partials<T> *p = &partials;
+    auto body = [=](const loop_domain_t &c0,
+            const loop_domain_t &c1) mutable {
+        T acc = identity;
+        for (int i = c0.low; i < c0.high; i += c0.stride) {
+            for (int j = c1.low; j < c1.high; j += c1.stride) {
+                acc = combine(acc, map(i, j)); // !!! May cause a worker-swap !!!
+            }
+        }
+        p->accumulate(acc, combine);
+    };
+    for_async_fp_union fp;
+    fp.range = forasync2D_range_wrapper<decltype(body)>;
+    forasync_wait<2>(FORASYNC_KIND_RANGE, fp.vp, loop, body, mode);
+    return partials.fold(identity, combine);
+}
+
+template <typename T, typename M, typename C>
+inline T forasync3D_reduce(loop_domain_t *loop, T identity, M &&map,
+        C &&combine, int mode = FORASYNC_MODE_RECURSIVE) {
+    forasync_reduce_partials<T> partials(identity);
+    forasync_reduce_partials<T> *p = &partials;
+    auto body = [=](const loop_domain_t &c0,
+            const loop_domain_t &c1, const loop_domain_t &c2) mutable {
+        T acc = identity;
+        for (int i = c0.low; i < c0.high; i += c0.stride) {
+            for (int j = c1.low; j < c1.high; j += c1.stride) {
+                for (int k = c2.low; k < c2.high; k += c2.stride) {
+                    acc = combine(acc, map(i, j, k)); // !!! May cause a worker-swap !!!
+                }
+            }
+        }
+        p->accumulate(acc, combine);
+    };
+    for_async_fp_union fp;
+    fp.range = forasync3D_range_wrapper<decltype(body)>;
+    forasync_wait<3>(FORASYNC_KIND_RANGE, fp.vp, loop, body, mode);
+    return partials.fold(identity, combine);
+}
+
+/*
+ * Non-blocking versions of the reductions above. The returned future is
+ * satisfied with the reduced value once all tasks of the forasync are done.
+ */
+template <typename T, typename M, typename C>
+inline hclib::shared_future<T> forasync1D_reduce_future(loop_domain_t *loop,
+        T identity, M &&map, C &&combine,
+        int mode = FORASYNC_MODE_RECURSIVE) {
+    auto *p = new forasync_reduce_partials<T>(identity);
+    hclib::shared_future<void> done = forasync1D_range_future(loop,
+            [=](const loop_domain_t &c0) mutable {
+                T acc = identity;
+                for (int i = c0.low; i < c0.high; i += c0.stride) {
+                    acc = combine(acc, map(i)); // !!! May cause a worker-swap !!!
+                }
+                p->accumulate(acc, combine);
+            }, mode);
+    return async_future_await([=]() mutable {
+            const T res = p->fold(identity, combine);
+            delete p;
+            return res;
+        }, done);
+}
+
+template <typename T, typename M, typename C>
+inline hclib::shared_future<T> forasync2D_reduce_future(loop_domain_t *loop,
+        T identity, M &&map, C &&combine,
+        int mode = FORASYNC_MODE_RECURSIVE) {
+    auto *p = new forasync_reduce_partials<T>(identity);
+    hclib::shared_future<void> done = forasync2D_range_future(loop,
+            [=](const loop_domain_t &c0, const loop_domain_t &c1) mutable {
+                T acc = identity;
+                for (int i = c0.low; i < c0.high; i += c0.stride) {
+                    for (int j = c1.low; j < c1.high; j += c1.stride) {
+                        acc = combine(acc, map(i, j)); // !!! May cause a worker-swap !!!
+                    }
+                }
+                p->accumulate(acc, combine);
+            }, mode);
+    return async_future_await([=]() mutable {
+            const T res = p->fold(identity, combine);
+            delete p;
+            return res;
+        }, done);
+}
+
+template <typename T, typename M, typename C>
+inline hclib::shared_future<T> forasync3D_reduce_future(loop_domain_t *loop,
+        T identity, M &&map, C &&combine,
+        int mode = FORASYNC_MODE_RECURSIVE) {
+    auto *p = new forasync_reduce_partials<T>(identity);
+    hclib::shared_future<void> done = forasync3D_range_future(loop,
+            [=](const loop_domain_t &c0, const loop_domain_t &c1,
+                const loop_domain_t &c2) mutable {
+                T acc = identity;
+                for (int i = c0.low; i < c0.high; i += c0.stride) {
+                    for (int j = c1.low; j < c1.high; j += c1.stride) {
+                        for (int k = c2.low; k < c2.high; k += c2.stride) {
+                            acc = combine(acc, map(i, j, k)); // !!! May cause a worker-swap !!!
+                        }
+                    }
+                }
+                p->accumulate(acc, combine);
+            }, mode);
+    return async_future_await([=]() mutable {
+            const T res = p->fold(identity, combine);
+            delete p;
+            return res;
+        }, done);
 }
 
 }
@@ -17,33 +17,121 @@
 #ifndef HCLIB_FUTURE_H
 #define HCLIB_FUTURE_H
 
+#include <type_traits>
+#include <utility>
+
 #include "hclib-promise.h"
 
 namespace hclib {
 
-// Specialized for scalar types
+/*
+ * Values that fit in a pointer and can be bitwise-copied are stored directly in
+ * the datum of the underlying hclib_promise_t, as with the C API. Any other
+ * value is stored inline in the C++ promise_t (see hclib-promise.hpp), and the
+ * datum points to that storage.
+ */
 template<typename T>
-struct future_t: public hclib_future_t {
-
-    HASSERT_STATIC(sizeof(T) <= sizeof(void*),
-            "future_t arg type is too large to store by value.");
+struct future_stores_inline {
 #if HAVE_CXX11_TRIVIAL_COPY_CHECK
-    HASSERT_STATIC(std::is_trivially_copyable<T>::value,
-            "future_t arg type can't be recast to void*.");
+    static const bool value = sizeof(T) > sizeof(void*) ||
+        !std::is_trivially_copyable<T>::value;
+#else
+    static const bool value = sizeof(T) > sizeof(void*) ||
+        !std::is_pod<T>::value;
 #endif  // HAVE_CXX11_TRIVIAL_COPY_CHECK
+};
+
+template<typename T, bool Inline = future_stores_inline<T>::value>
+struct future_datum;
+
+template<typename T> struct future_t;
+template<typename T> class shared_future;
+
+// Result type of a continuation of a future_t<T> (see then)
+template<typename T, typename F>
+struct continuation_result {
+    typedef decltype(std::declval<typename std::decay<F>::type&>()(
+                std::declval<T>())) type;
+};
+
+template<typename F>
+struct continuation_result<void, F> {
+    typedef decltype(std::declval<typename std::decay<F>::type&>()()) type;
+};
+
+// defined in hclib-async.hpp
+template<typename T, typename F>
+shared_future<typename continuation_result<T, F>::type> future_then(
+        future_t<T> *future, F &&lambda);
 
+template<typename T, typename F>
+shared_future<typename continuation_result<T, F>::type> future_then_inline(
+        future_t<T> *future, F &&lambda);
+
+template<typename T>
+struct future_datum<T, false> {
     union _ValUnion { T val; void *vp; };
 
-    T &&get() {
+    static T take(void *datum) {
         _ValUnion tmp;
-        tmp.vp = hclib_future_get(this);
-        return std::move(tmp.val);
+        tmp.vp = datum;
+        return tmp.val;
     }
 
-    T &&wait() {
-        _ValUnion tmp;
-        tmp.vp = hclib_future_wait(this);
-        return std::move(tmp.val);
+    static T peek(void *datum) {
+        return take(datum);
+    }
+};
+
+template<typename T>
+struct future_datum<T, true> {
+    static T take(void *datum) {
+        return std::move(*static_cast<T*>(datum));
+    }
+
+    static const T &peek(void *datum) {
+        return *static_cast<const T*>(datum);
+    }
+};
+
+// Specialized for value types
+// Values stored inline are moved out by get and wait (as with std::future),
+// so only one consumer should retrieve them. get_shared and wait_shared leave
+// them in the promise, for any number of consumers (see shared_future).
+template<typename T>
+struct future_t: public hclib_future_t {
+    T get() {
+        return future_datum<T>::take(hclib_future_get(this));
+    }
+
+    T wait() {
+        return future_datum<T>::take(hclib_future_wait(this));
+    }
+
+    auto get_shared() -> decltype(future_datum<T>::peek(nullptr)) {
+        return future_datum<T>::peek(hclib_future_get(this));
+    }
+
+    auto wait_shared() -> decltype(future_datum<T>::peek(nullptr)) {
+        return future_datum<T>::peek(hclib_future_wait(this));
+    }
+
+    /*
+     * Run lambda on the value of this future once it is satisfied, and get a
+     * future on its result. then_inline runs lambda in place on the worker
+     * that satisfies this future, as long as this does not nest too deeply,
+     * which saves scheduling a task for short continuations (see
+     * hclib_future_then_inline).
+     */
+    template<typename F>
+    shared_future<typename continuation_result<T, F>::type> then(F &&lambda) {
+        return future_then(this, std::forward<F>(lambda));
+    }
+
+    template<typename F>
+    shared_future<typename continuation_result<T, F>::type> then_inline(
+            F &&lambda) {
+        return future_then_inline(this, std::forward<F>(lambda));
     }
 };
 
@@ -57,6 +145,20 @@ struct future_t<T*>: public hclib_future_t {
     T *wait() {
         return static_cast<T*>(hclib_future_wait(this));
     }
+
+    T *get_shared() { return get(); }
+    T *wait_shared() { return wait(); }
+
+    template<typename F>
+    shared_future<typename continuation_result<T*, F>::type> then(F &&lambda) {
+        return future_then(this, std::forward<F>(lambda));
+    }
+
+    template<typename F>
+    shared_future<typename continuation_result<T*, F>::type> then_inline(
+            F &&lambda) {
+        return future_then_inline(this, std::forward<F>(lambda));
+    }
 };
 
 // Specialized for references
@@ -69,6 +171,20 @@ struct future_t<T&>: public hclib_future_t {
     T &wait() {
         return *static_cast<T*>(hclib_future_wait(this));
     }
+
+    T &get_shared() { return get(); }
+    T &wait_shared() { return wait(); }
+
+    template<typename F>
+    shared_future<typename continuation_result<T&, F>::type> then(F &&lambda) {
+        return future_then(this, std::forward<F>(lambda));
+    }
+
+    template<typename F>
+    shared_future<typename continuation_result<T&, F>::type> then_inline(
+            F &&lambda) {
+        return future_then_inline(this, std::forward<F>(lambda));
+    }
 };
 
 // Specialized for void
@@ -76,9 +192,23 @@ template<>
 struct future_t<void>: public hclib_future_t {
     void get() { }
     void wait() { hclib_future_wait(this); }
+    void get_shared() { }
+    void wait_shared() { wait(); }
+
+    template<typename F>
+    shared_future<typename continuation_result<void, F>::type> then(F &&lambda) {
+        return future_then(this, std::forward<F>(lambda));
+    }
+
+    template<typename F>
+    shared_future<typename continuation_result<void, F>::type> then_inline(
+            F &&lambda) {
+        return future_then_inline(this, std::forward<F>(lambda));
+    }
 };
 
-HASSERT_STATIC(std::is_pod<future_t<void*>>::value,
+HASSERT_STATIC(std::is_trivial<future_t<void*>>::value &&
+        std::is_standard_layout<future_t<void*>>::value,
         "future_t is plain-old-datatype");
 // assert that we can safely cast back and forth between the C and C++ types
 HASSERT_STATIC(sizeof(future_t<void*>) == sizeof(hclib_future_t),
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HCLIB_GRAPH_H_
+#define HCLIB_GRAPH_H_
+
+#include "hclib-promise.h"
+
+/**
+ * @file Capture and replay of task graphs.
+ *
+ * Between hclib_graph_capture_begin and hclib_graph_capture_end, the tasks
+ * spawned by the current task through hclib_async and hclib_async_future are
+ * not run, but recorded with their dependencies and places into a graph. The
+ * graph can then be launched any number of times, running the same functions
+ * on the same arguments in dependency order. A launch allocates nothing: the
+ * tasks and dependency counters of the graph are reused.
+ *
+ * Within the captured region, the future returned by hclib_async_future is a
+ * handle on the recorded task, for use in the future lists of later tasks of
+ * the graph. It cannot be waited on, and the value returned by the task is
+ * discarded: tasks of a graph exchange data through memory. Futures of other
+ * promises in the future lists are waited on at the start of every launch.
+ * The capturing task must not wait for anything during the capture.
+ */
+
+/**
+ * @brief Opaque type for task graphs.
+ */
+typedef struct hclib_graph_st hclib_graph_t;
+
+/*
+ * Start recording the tasks spawned by the current task.
+ */
+void hclib_graph_capture_begin();
+
+/*
+ * Stop recording, and return the graph of the recorded tasks.
+ */
+hclib_graph_t *hclib_graph_capture_end();
+
+/*
+ * Returns 1 if the current task is capturing a graph. The tasks it spawns are
+ * then run by every launch of the graph, and must not free their argument.
+ */
+int hclib_graph_capturing();
+
+/*
+ * Attach data to the graph being captured, to be released along with it (e.g.
+ * the arguments of its tasks).
+ */
+void hclib_graph_attach(void *data, void (*release)(void *data));
+
+/*
+ * Run all the tasks of graph, registered on the current finish scope. A graph
+ * can only be launched again once all the tasks of its previous launch have
+ * completed.
+ */
+void hclib_graph_launch(hclib_graph_t *graph);
+
+/*
+ * Free a graph, which must not be running.
+ */
+void hclib_graph_free(hclib_graph_t *graph);
+
+/*
+ * Number of tasks in the graph.
+ */
+int hclib_graph_size(hclib_graph_t *graph);
+
+#endif /* HCLIB_GRAPH_H_ */
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HCLIB_GRAPH_HPP_
+#define HCLIB_GRAPH_HPP_
+
+#include "hclib-graph.h"
+#include "hclib-async.hpp"
+
+namespace hclib {
+
+template<typename T>
+void *graph_lambda_wrapper(void *arg) {
+    (*static_cast<T*>(arg))();
+    return nullptr;
+}
+
+/*
+ * Record lambda as a task of the graph being captured, to run once the tasks
+ * behind the given handles have completed (null handles are skipped), and
+ * return its handle. hclib::async and hclib::async_await record their lambda
+ * as well, but the C++ functions returning a future cannot be used while
+ * capturing.
+ */
+template <typename T, typename... handle_list_t>
+hclib_future_t *graph_async(T &&lambda, handle_list_t... handles) {
+    typedef typename std::remove_reference<T>::type U;
+    U *arg = new U(lambda);
+    hclib_graph_attach(arg, graph_lambda_release<U>);
+    hclib_future_t *all[] = { handles..., nullptr };
+    hclib_future_t *deps[sizeof...(handles) + 1];
+    int ndeps = 0;
+    for (size_t i = 0; i < sizeof...(handles); i++) {
+        if (all[i]) {
+            deps[ndeps++] = all[i];
+        }
+    }
+    deps[ndeps] = nullptr;
+    return hclib_async_future(graph_lambda_wrapper<U>, arg, deps, nullptr,
+            nullptr, 0);
+}
+
+/*
+ * A graph of the tasks recorded while running capture.
+ */
+class graph {
+    hclib_graph_t *g;
+
+  public:
+    template <typename T>
+    explicit graph(T &&capture) {
+        hclib_graph_capture_begin();
+        capture();
+        g = hclib_graph_capture_end();
+    }
+
+    ~graph() {
+        hclib_graph_free(g);
+    }
+
+    graph(const graph&) = delete;
+    graph &operator=(const graph&) = delete;
+
+    // the tasks of the graph join the current finish scope
+    void launch() {
+        hclib_graph_launch(g);
+    }
+
+    // launch and wait for all the tasks of the graph
+    void run() {
+        hclib_start_finish();
+        launch();
+        hclib_end_finish();
+    }
+
+    int size() const {
+        return hclib_graph_size(g);
+    }
+};
+
+}
+
+#endif /* HCLIB_GRAPH_HPP_ */
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_IO_H_
+#define HCLIB_IO_H_
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "hclib-promise.h"
+
+/**
+ * @file Asynchronous reads, writes and accepts on file descriptors.
+ *
+ * Each call starts the operation and returns a future that is satisfied once
+ * it has completed, so that a task waiting on it with hclib_future_wait is
+ * suspended rather than blocking its worker. Operations that cannot complete
+ * right away are polled for by idle workers, through epoll for sockets, pipes
+ * and the like, while reads and writes on regular files are handed over to the
+ * next idle worker.
+ *
+ * The datum of the future is the result of the matching system call cast to a
+ * (void *): a byte count for reads and writes, or the accepted descriptor,
+ * which is never negative, or else -errno. As with read(2) and write(2), a
+ * single operation may transfer fewer than count bytes. The future can be
+ * handed back with hclib_future_release once it is satisfied.
+ *
+ * Sockets are read from and written to with MSG_DONTWAIT. Other descriptors,
+ * except for regular files, are in non-blocking mode while operations are
+ * waiting on them, and their mode is restored afterwards. The buffers must
+ * stay valid until the future is satisfied.
+ */
+
+hclib_future_t *hclib_async_read(int fd, void *buf, size_t count);
+
+hclib_future_t *hclib_async_write(int fd, const void *buf, size_t count);
+
+/*
+ * addr and addrlen may be NULL, as with accept(2).
+ */
+hclib_future_t *hclib_async_accept(int fd, struct sockaddr *addr,
+        socklen_t *addrlen);
+
+#endif /* HCLIB_IO_H_ */
@@ -0,0 +1,387 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_PAR_HPP_
+#define HCLIB_PAR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hclib-async.hpp"
+#include "hclib-forasync.hpp"
+
+/*
+ * Parallel versions of some of the standard algorithms over random-access
+ * iterators, built on forasync and async/finish. Each one returns once it is
+ * done, as if wrapped in a finish scope. The grain adapts to the input size and
+ * to the number of workers: the work is split into about eight pieces per
+ * worker, but sorts and merges do not split below SERIAL_CUTOFF elements.
+ */
+namespace hclib {
+namespace par {
+
+namespace detail {
+
+const std::size_t SERIAL_CUTOFF = 2048;
+
+inline std::size_t grain_size(std::size_t n) {
+    const std::size_t grain = n / (8 * hclib_num_workers());
+    return grain < SERIAL_CUTOFF ? SERIAL_CUTOFF : grain;
+}
+
+/*
+ * Number of chunks for the algorithms that make several passes over a fixed
+ * split of [0, n): a few per worker, or a single one (i.e. run serially) when
+ * there is only one worker or not enough work.
+ */
+inline std::size_t chunk_count(std::size_t n) {
+    const int nworkers = hclib_num_workers();
+    if (nworkers == 1) return 1;
+    const std::size_t max_chunks = (n + SERIAL_CUTOFF - 1) / SERIAL_CUTOFF;
+    return std::min(max_chunks, (std::size_t) 4 * nworkers);
+}
+
+/*
+ * Call body(low, high) over ranges covering [0, n), and wait for all calls. By
+ * default there are about eight ranges per worker. In FORASYNC_MODE_FLAT the
+ * ranges are the tiles [k * tile, (k + 1) * tile).
+ *
+ * FORASYNC_MODE_ADAPTIVE is not used: it peels 16 iterations at a time, which
+ * is far too fine for the cheap bodies of these loops.
+ */
+template <typename F>
+inline void for_ranges(std::size_t n, const F &body,
+        int mode = FORASYNC_MODE_RECURSIVE, std::size_t tile = 0) {
+    if (n == 0) return;
+    if (tile == 0) {
+        const std::size_t pieces = 8 * hclib_num_workers();
+        tile = (n + pieces - 1) / pieces;
+    }
+    auto range_body = [&body](const loop_domain64_t &range) {
+        body((std::size_t) range.low, (std::size_t) range.high);
+    };
+    loop_domain64_t loop = {0, (int64_t) n, 1, (int64_t) tile};
+    for_async_fp_union fp;
+    fp.nd_range = forasync_nd_range_wrapper<1, decltype(range_body)>;
+    forasync_wait<1>(FORASYNC_KIND_ND_RANGE, fp.vp, &loop, range_body, mode);
+}
+
+/*
+ * Scratch array of n elements, move-constructed in parallel from a range. Its
+ * elements only need to be move-constructible, not default-constructible.
+ */
+template <typename T>
+class buffer {
+    std::allocator<T> alloc;
+    T *data;
+    std::size_t n;
+
+  public:
+    template <typename I>
+    buffer(I first, std::size_t n) : data(alloc.allocate(n)), n(n) {
+        T *d = data;
+        for_ranges(n, [d, first](std::size_t low, std::size_t high) {
+            for (std::size_t i = low; i < high; i++) {
+                ::new (static_cast<void *>(d + i)) T(std::move(first[i]));
+            }
+        });
+    }
+
+    ~buffer() {
+        if (!std::is_trivially_destructible<T>::value) {
+            T *d = data;
+            for_ranges(n, [d](std::size_t low, std::size_t high) {
+                for (std::size_t i = low; i < high; i++) d[i].~T();
+            });
+        }
+        alloc.deallocate(data, n);
+    }
+
+    buffer(const buffer&) = delete;
+    buffer &operator=(const buffer&) = delete;
+
+    T *begin() { return data; }
+};
+
+/*
+ * Per-worker partial results of reduce, as forasync_reduce_partials but
+ * without an identity: a slot only holds a value once its worker has
+ * accumulated one.
+ */
+template <typename T>
+class reduce_partials {
+    struct slot_t {
+        T val;
+        bool set;
+        char pad[HCLIB_CACHE_LINE_SIZE];
+    };
+
+    std::vector<slot_t> slots;
+
+  public:
+    explicit reduce_partials(const T &init) :
+        slots(hclib_num_workers(), slot_t { init, false, { 0 } }) { }
+
+    template <typename Op>
+    void accumulate(const T &val, Op &op) {
+        slot_t &slot = slots[get_current_worker()];
+        slot.val = slot.set ? op(slot.val, val) : val;
+        slot.set = true;
+    }
+
+    template <typename Op>
+    T fold(T init, Op &op) const {
+        for (const slot_t &slot : slots) {
+            if (slot.set) init = op(init, slot.val);
+        }
+        return init;
+    }
+};
+
+/*
+ * Merge the sorted ranges [a, a_end) and [b, b_end) into out by moving, taking
+ * from the first range on ties. The larger range is split at its middle
+ * element and the other one at the matching bound, and both halves are merged
+ * in parallel.
+ */
+template <typename I, typename O, typename C>
+void merge(I a, I a_end, I b, I b_end, O out, std::size_t grain, C comp) {
+    const std::size_t na = a_end - a;
+    const std::size_t nb = b_end - b;
+    if (na + nb <= grain) {
+        std::merge(std::make_move_iterator(a), std::make_move_iterator(a_end),
+                std::make_move_iterator(b), std::make_move_iterator(b_end),
+                out, comp);
+        return;
+    }
+
+    I a_mid, b_mid;
+    if (na >= nb) {
+        a_mid = a + na / 2;
+        b_mid = std::lower_bound(b, b_end, *a_mid, comp);
+    } else {
+        b_mid = b + nb / 2;
+        a_mid = std::upper_bound(a, a_end, *b_mid, comp);
+    }
+    const O out_mid = out + (a_mid - a) + (b_mid - b);
+    hclib::finish([=]() {
+        hclib::async([=]() {
+            detail::merge(a, a_mid, b, b_mid, out, grain, comp);
+        });
+        detail::merge(a_mid, a_end, b_mid, b_end, out_mid, grain, comp);
+    });
+}
+
+/*
+ * Merge sort of the n elements at src, using the n elements at dst as scratch
+ * space, leaving the result at dst if into_dst and at src otherwise. The
+ * halves are sorted into the array that the final merge reads from.
+ */
+template <typename I, typename J, typename C>
+void sort(I src, J dst, std::size_t n, bool into_dst, std::size_t grain,
+        C comp) {
+    if (n <= grain) {
+        std::sort(src, src + n, comp);
+        if (into_dst) std::move(src, src + n, dst);
+        return;
+    }
+
+    const std::size_t half = n / 2;
+    hclib::finish([=]() {
+        hclib::async([=]() {
+            detail::sort(src, dst, half, !into_dst, grain, comp);
+        });
+        detail::sort(src + half, dst + half, n - half, !into_dst, grain,
+                comp);
+    });
+    if (into_dst) {
+        detail::merge(src, src + half, src + half, src + n, dst, grain, comp);
+    } else {
+        detail::merge(dst, dst + half, dst + half, dst + n, src, grain, comp);
+    }
+}
+
+}
+
+template <typename I, typename F>
+inline void for_each(I first, I last, F f) {
+    detail::for_ranges(last - first,
+            [first, &f](std::size_t low, std::size_t high) {
+        for (std::size_t i = low; i < high; i++) f(first[i]);
+    });
+}
+
+template <typename I, typename O, typename F>
+inline O transform(I first, I last, O d_first, F f) {
+    const std::size_t n = last - first;
+    detail::for_ranges(n, [first, d_first, &f](std::size_t low,
+                std::size_t high) {
+        for (std::size_t i = low; i < high; i++) d_first[i] = f(first[i]);
+    });
+    return d_first + n;
+}
+
+template <typename I1, typename I2, typename O, typename F>
+inline O transform(I1 first1, I1 last1, I2 first2, O d_first, F f) {
+    const std::size_t n = last1 - first1;
+    detail::for_ranges(n, [first1, first2, d_first, &f](std::size_t low,
+                std::size_t high) {
+        for (std::size_t i = low; i < high; i++) {
+            d_first[i] = f(first1[i], first2[i]);
+        }
+    });
+    return d_first + n;
+}
+
+/*
+ * Like std::reduce, op must be associative and commutative: elements are
+ * combined in no particular order.
+ */
+template <typename I, typename T, typename Op>
+inline T reduce(I first, I last, T init, Op op) {
+    detail::reduce_partials<T> partials(init);
+    detail::for_ranges(last - first, [first, &partials, &op](std::size_t low,
+                std::size_t high) {
+        T acc = first[low];
+        for (std::size_t i = low + 1; i < high; i++) acc = op(acc, first[i]);
+        partials.accumulate(acc, op);
+    });
+    return partials.fold(init, op);
+}
+
+template <typename I, typename T>
+inline T reduce(I first, I last, T init) {
+    return par::reduce(first, last, init, std::plus<T>());
+}
+
+/*
+ * Two parallel passes over a fixed split: the first one reduces each chunk,
+ * and the second one scans each chunk starting from the reduction of the
+ * chunks before it. op must be associative. d_first may be first.
+ */
+template <typename I, typename O, typename Op>
+inline O inclusive_scan(I first, I last, O d_first, Op op) {
+    typedef typename std::iterator_traits<I>::value_type T;
+    const std::size_t n = last - first;
+    const std::size_t nchunks = detail::chunk_count(n);
+    if (nchunks <= 1) return std::partial_sum(first, last, d_first, op);
+
+    const std::size_t chunk = (n + nchunks - 1) / nchunks;
+    std::vector<T> sums((n + chunk - 1) / chunk, first[0]);
+    // the sum of the last chunk is never needed
+    detail::for_ranges((sums.size() - 1) * chunk, [&](std::size_t low,
+                std::size_t high) {
+        T acc = first[low];
+        for (std::size_t i = low + 1; i < high; i++) acc = op(acc, first[i]);
+        sums[low / chunk] = acc;
+    }, FORASYNC_MODE_FLAT, chunk);
+    for (std::size_t c = 1; c < sums.size(); c++) {
+        sums[c] = op(sums[c - 1], sums[c]);
+    }
+    detail::for_ranges(n, [&](std::size_t low, std::size_t high) {
+        T acc = low == 0 ? first[0] : op(sums[low / chunk - 1], first[low]);
+        d_first[low] = acc;
+        for (std::size_t i = low + 1; i < high; i++) {
+            acc = op(acc, first[i]);
+            d_first[i] = acc;
+        }
+    }, FORASYNC_MODE_FLAT, chunk);
+    return d_first + n;
+}
+
+template <typename I, typename O>
+inline O inclusive_scan(I first, I last, O d_first) {
+    return par::inclusive_scan(first, last, d_first,
+            std::plus<typename std::iterator_traits<I>::value_type>());
+}
+
+/*
+ * Parallel merge sort with a parallel merge, as in test/cilk/Cilksort.cpp,
+ * with std::sort below the grain size. Not stable.
+ */
+template <typename I, typename C>
+inline void sort(I first, I last, C comp) {
+    typedef typename std::iterator_traits<I>::value_type T;
+    const std::size_t n = last - first;
+    const std::size_t grain = detail::grain_size(n);
+    if (n <= grain) {
+        std::sort(first, last, comp);
+        return;
+    }
+    // sorted from the buffer back into [first, last)
+    detail::buffer<T> buf(first, n);
+    detail::sort(buf.begin(), first, n, true, grain, comp);
+}
+
+template <typename I>
+inline void sort(I first, I last) {
+    par::sort(first, last,
+            std::less<typename std::iterator_traits<I>::value_type>());
+}
+
+/*
+ * Stable partition: counts the elements satisfying pred in each chunk, then
+ * moves every chunk to its place through a buffer. Returns the first element
+ * of the second group.
+ */
+template <typename I, typename P>
+inline I partition(I first, I last, P pred) {
+    typedef typename std::iterator_traits<I>::value_type T;
+    const std::size_t n = last - first;
+    const std::size_t nchunks = detail::chunk_count(n);
+    if (nchunks <= 1) return std::stable_partition(first, last, pred);
+
+    const std::size_t chunk = (n + nchunks - 1) / nchunks;
+    std::vector<std::size_t> before((n + chunk - 1) / chunk + 1, 0);
+    detail::for_ranges(n, [&](std::size_t low, std::size_t high) {
+        std::size_t count = 0;
+        for (std::size_t i = low; i < high; i++) {
+            if (pred(first[i])) count++;
+        }
+        before[low / chunk + 1] = count;
+    }, FORASYNC_MODE_FLAT, chunk);
+    // before[c]: elements of chunks below c that satisfy pred
+    for (std::size_t c = 1; c < before.size(); c++) before[c] += before[c - 1];
+    const std::size_t ntrue = before.back();
+
+    detail::buffer<T> buf(first, n);
+    T *src = buf.begin();
+    detail::for_ranges(n, [&](std::size_t low, std::size_t high) {
+        std::size_t t = before[low / chunk];
+        std::size_t f = ntrue + low - t;
+        for (std::size_t i = low; i < high; i++) {
+            if (pred(src[i])) {
+                first[t++] = std::move(src[i]);
+            } else {
+                first[f++] = std::move(src[i]);
+            }
+        }
+    }, FORASYNC_MODE_FLAT, chunk);
+    return first + ntrue;
+}
+
+}
+}
+
+#endif /* HCLIB_PAR_HPP_ */
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HCLIB_PHASER_H_
+#define HCLIB_PHASER_H_
+
+/**
+ * @file Phasers, for point-to-point and barrier synchronization between tasks.
+ *
+ * A phaser goes through a sequence of phases. Each task registered on it may
+ * signal the end of the current phase, wait for all signals of the current
+ * phase, or both. A phase completes once every task registered as a signaler
+ * has signalled it or dropped its registration. Waiting suspends the task in
+ * the same way as hclib_future_wait, leaving its worker free to run other
+ * tasks.
+ *
+ * The task creating a phaser is registered on it. Other tasks are registered
+ * when spawned, through the phased clause of hclib_async, in a mode that the
+ * spawning task's own registration must include. A task drops its
+ * registrations when it completes, and the creator of a phaser drops its own at
+ * the end of the finish scope the phaser was created in.
+ */
+
+typedef enum {
+    PHASER_SIG = 0x1,
+    PHASER_WAIT = 0x2,
+    PHASER_SIG_WAIT = PHASER_SIG | PHASER_WAIT,
+} hclib_phaser_mode_t;
+
+/**
+ * @brief Opaque type for phasers.
+ */
+typedef struct hclib_phaser_st hclib_phaser_t;
+
+/**
+ * @brief Phased clause of hclib_async: the phasers to register the new task on,
+ * and the mode of each registration. Only read during the hclib_async call.
+ */
+typedef struct _phased_t {
+    int count;
+    hclib_phaser_t **phasers;
+    hclib_phaser_mode_t *modes;
+} hclib_phased_t;
+
+/*
+ * Create a phaser, on which the current task is registered in mode. The phaser
+ * is freed once its last registration is dropped.
+ */
+hclib_phaser_t *hclib_phaser_create(hclib_phaser_mode_t mode);
+
+/*
+ * Signal the end of the current phase without waiting for the other tasks
+ * (split-phase barrier). The next call to hclib_phaser_next only waits.
+ */
+void hclib_phaser_signal(hclib_phaser_t *phaser);
+
+/*
+ * Move on to the next phase: signal the current phase if registered as a
+ * signaler and not done yet, then wait for it to complete if registered as a
+ * waiter. A task registered only as a signaler may get one phase ahead of the
+ * phaser, after which signalling waits for the current phase to complete.
+ */
+void hclib_phaser_next(hclib_phaser_t *phaser);
+
+/*
+ * Drop the registration of the current task on phaser.
+ */
+void hclib_phaser_drop(hclib_phaser_t *phaser);
+
+#endif /* HCLIB_PHASER_H_ */
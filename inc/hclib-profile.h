@@ -0,0 +1,52 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_PROFILE_H_
+#define HCLIB_PROFILE_H_
+
+#include "hclib-rt.h"
+
+/**
+ * @file Sampling profile of the tasks by function, enabled by setting
+ * HCLIB_PROFILE.
+ *
+ * One task made ready in HCLIB_PROFILE_PERIOD (100 by default, with some
+ * jitter) is sampled. For each function run by tasks, the profile gives the
+ * estimated number of tasks and time spent running them, the mean time of a
+ * task, not counting the nested tasks it runs or the time it is blocked in
+ * finish scopes and waits, the mean time between the task being made ready
+ * (e.g. pushed on a deque) and it starting, and the share of tasks run by
+ * another worker than the one that made them ready, i.e. stolen.
+ *
+ * The profile is printed on stderr at hclib_launch exit, and on SIGUSR2 while
+ * tasks are running.
+ */
+
+typedef struct hclib_task_name_st {
+    generic_frame_ptr fn;
+    const char *type;
+    struct hclib_task_name_st *next;
+} hclib_task_name_t;
+
+/*
+ * Report the tasks running entry->fn under the name of the type it wraps, as
+ * given by std::type_info::name, rather than that of the function. This is
+ * done for the lambdas spawned with the C++ API. The entry must stay valid.
+ * Returns 0.
+ */
+int hclib_profile_name_task(hclib_task_name_t *entry, const char *type);
+
+#endif /* HCLIB_PROFILE_H_ */
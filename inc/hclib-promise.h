@@ -52,15 +52,29 @@ typedef struct _hclib_future_t {
     struct hclib_promise_st *owner;
 } hclib_future_t;
 
-struct hclib_task_t;
+/*
+ * Entry in the wait list of a promise: either a task waiting on its futures,
+ * which starts with these fields in this order, or a trigger registered with
+ * hclib_future_add_trigger, which has a NULL future_list and is only this.
+ */
+typedef struct hclib_waiter_t {
+    struct hclib_waiter_t *next_waiter;
+    hclib_future_t **future_list;
+    void (*_fp)(void *);
+    void *args;
+} hclib_waiter_t;
 
 // We define a typedef in this unit for convenience
 typedef struct hclib_promise_st {
     hclib_future_t future;
     void *volatile datum;
-    // List of tasks that are awaiting the satisfaction of this promise
-    struct hclib_task_t *volatile wait_list_head;
+    // List of tasks and triggers awaiting the satisfaction of this promise
+    hclib_waiter_t *volatile wait_list_head;
     promise_kind_t kind;
+    // Number of references to this promise, see hclib_promise_retain
+    volatile int refcount;
+    // Called to destroy the promise once its last reference is dropped
+    void (*destructor)(struct hclib_promise_st *promise);
 } hclib_promise_t;
 
 /**
@@ -105,6 +119,39 @@ void hclib_promise_free_n(hclib_promise_t **promise, size_t nb_promises,
  */
 void hclib_promise_free(hclib_promise_t *promise);
 
+/**
+ * @brief Take an additional reference on a promise.
+ *
+ * Every promise starts with a single reference, held by its creator. The
+ * runtime takes its own reference while it still has to put on a promise, so
+ * a promise can be released by all its users before being satisfied.
+ * @param[in] promise 				The promise to retain
+ */
+void hclib_promise_retain(hclib_promise_t *promise);
+
+/**
+ * @brief Drop a reference on a promise.
+ *
+ * Once the last reference is dropped, the promise is destroyed. Promises
+ * allocated with hclib_promise_create are freed, promises initialized with
+ * hclib_promise_init are left alone unless their destructor has been set.
+ * @param[in] promise 				The promise to release
+ */
+void hclib_promise_release(hclib_promise_t *promise);
+
+/**
+ * @brief Drop the caller's reference on the promise behind a future returned
+ * by the runtime (e.g. by hclib_end_finish_nonblocking), so that the promise
+ * is freed once it has been satisfied.
+ * @param[in] future 				The future to release
+ */
+void hclib_future_release(hclib_future_t *future);
+
+/*
+ * Returns 1 if the promise behind future has been put on, without waiting.
+ */
+int hclib_future_is_satisfied(hclib_future_t *future);
+
 /**
  * @brief Get the value of a promise.
  * @param[in] promise 				The promise to get a value from
@@ -124,4 +171,28 @@ void hclib_promise_put(hclib_promise_t *promise, void *datum);
  */
 void *hclib_future_wait(hclib_future_t *future);
 
+/*
+ * Call trigger->_fp(trigger->args) once the future is satisfied: right away if
+ * it already is, or else from within the hclib_promise_put that satisfies it.
+ * The callback must be short and must not block. The trigger must have a NULL
+ * future_list, and stay valid until it has been called.
+ */
+void hclib_future_add_trigger(hclib_future_t *future,
+        hclib_waiter_t *trigger);
+
+/*
+ * Get a future that is satisfied once all of the nfutures futures are. Its
+ * datum is NULL. This costs one registration per future, however they get
+ * satisfied, rather than re-registering a task each time one of its futures
+ * is satisfied. The future can be handed back with hclib_future_release.
+ */
+hclib_future_t *hclib_when_all(hclib_future_t **futures, int nfutures);
+
+/*
+ * Get a future that is satisfied as soon as any of the nfutures futures is.
+ * Its datum is the index of that future in the futures array, cast to a
+ * (void *). The future can be handed back with hclib_future_release.
+ */
+hclib_future_t *hclib_when_any(hclib_future_t **futures, int nfutures);
+
 #endif /* HCLIB_PROMISE_H_ */
@@ -17,30 +17,74 @@
 #ifndef HCLIB_PROMISE_H
 #define HCLIB_PROMISE_H
 
+#include <new>
+#include <utility>
+
 #include "hclib-promise.h"
 #include "hclib-future.hpp"
 
 namespace hclib {
 
-// Specialized for pointers
-// (and pointer-sized value types)
-template<typename T>
-struct promise_t: public hclib_promise_t {
+/*
+ * Destructor of C++ promises, called once their last reference is dropped
+ * (see shared_future below).
+ */
+template<typename P>
+void promise_delete(hclib_promise_t *promise) {
+    delete static_cast<P*>(promise);
+}
 
-    HASSERT_STATIC(sizeof(T) <= sizeof(void*),
-            "promise_t arg type is too large to store by value.");
-#if HAVE_CXX11_TRIVIAL_COPY_CHECK
-    HASSERT_STATIC(std::is_trivially_copyable<T>::value,
-            "promise_t arg type can't be recast to void*.");
-#endif  // HAVE_CXX11_TRIVIAL_COPY_CHECK
+template<typename T, bool Inline = future_stores_inline<T>::value>
+struct promise_value_t;
 
-    promise_t() { hclib_promise_init(this); }
+// Pointer-sized value types, stored directly in the datum
+template<typename T>
+struct promise_value_t<T, false>: public hclib_promise_t {
+    promise_value_t() { hclib_promise_init(this); }
 
     void put(T datum) {
         void *tmp;
         *reinterpret_cast<T*>(&tmp) = datum;
         hclib_promise_put(this, tmp);
     }
+};
+
+// Larger or non-trivially-copyable value types, constructed in place in the
+// promise and destroyed along with it
+template<typename T>
+struct promise_value_t<T, true>: public hclib_promise_t {
+    promise_value_t() { hclib_promise_init(this); }
+
+    ~promise_value_t() {
+        if (datum == &storage) {
+            reinterpret_cast<T*>(&storage)->~T();
+        }
+    }
+
+    promise_value_t(const promise_value_t&) = delete;
+    promise_value_t &operator=(const promise_value_t&) = delete;
+
+    void put(const T &datum) {
+        emplace(datum);
+    }
+
+    void put(T &&datum) {
+        emplace(std::move(datum));
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        hclib_promise_put(this, new (&storage) T(std::forward<Args>(args)...));
+    }
+
+  private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+};
+
+// Specialized for value types
+template<typename T>
+struct promise_t: public promise_value_t<T> {
+    promise_t() { this->destructor = promise_delete<promise_t<T>>; }
 
     future_t<T> *get_future() {
         // this is the simplest expression I could come up with
@@ -57,7 +101,10 @@ struct promise_t: public hclib_promise_t {
 // Specialized for pointers
 template<typename T>
 struct promise_t<T*>: public hclib_promise_t {
-    promise_t() { hclib_promise_init(this); }
+    promise_t() {
+        hclib_promise_init(this);
+        destructor = promise_delete<promise_t<T*>>;
+    }
 
     void put(T *datum) {
         hclib_promise_put(this, datum);
@@ -74,7 +121,10 @@ struct promise_t<T*>: public hclib_promise_t {
 // Specialized for references
 template<typename T>
 struct promise_t<T&>: public hclib_promise_t {
-    promise_t() { hclib_promise_init(this); }
+    promise_t() {
+        hclib_promise_init(this);
+        destructor = promise_delete<promise_t<T&>>;
+    }
 
     void put(T &datum) {
         hclib_promise_put(this, &datum);
@@ -91,7 +141,10 @@ struct promise_t<T&>: public hclib_promise_t {
 // Specialized for void
 template<>
 struct promise_t<void>: public hclib_promise_t {
-    promise_t() { hclib_promise_init(this); }
+    promise_t() {
+        hclib_promise_init(this);
+        destructor = promise_delete<promise_t<void>>;
+    }
 
     void put() {
         hclib_promise_put(this, nullptr);
@@ -108,6 +161,78 @@ struct promise_t<void>: public hclib_promise_t {
 // assert that we can safely cast back and forth between the C and C++ types
 HASSERT_STATIC(sizeof(promise_t<void*>) == sizeof(hclib_promise_t),
         "promise_t is a trivial wrapper around hclib_promise_t");
+HASSERT_STATIC(sizeof(promise_t<int>) == sizeof(hclib_promise_t),
+        "pointer-sized values are stored in the hclib_promise_t datum");
+
+/*
+ * Reference-counted handle on the future of a heap-allocated promise_t. A
+ * shared_future adopts the reference of the promise's creator, and the promise
+ * is deleted once the last handle is gone and the runtime no longer needs it
+ * (tasks awaiting a shared_future keep it alive until they start).
+ */
+template<typename T>
+class shared_future {
+    future_t<T> *fut;
+
+  public:
+    shared_future() : fut(nullptr) { }
+
+    explicit shared_future(promise_t<T> *promise) :
+            fut(promise->get_future()) { }
+
+    shared_future(const shared_future &other) : fut(other.fut) {
+        if (fut) hclib_promise_retain(fut->owner);
+    }
+
+    shared_future(shared_future &&other) : fut(other.fut) {
+        other.fut = nullptr;
+    }
+
+    ~shared_future() {
+        if (fut) hclib_promise_release(fut->owner);
+    }
+
+    shared_future &operator=(shared_future other) {
+        std::swap(fut, other.fut);
+        return *this;
+    }
+
+    // values stored in the promise are read in place, as other handles may
+    // share them
+    auto get() const -> decltype(fut->get_shared()) {
+        return fut->get_shared();
+    }
+
+    auto wait() const -> decltype(fut->wait_shared()) {
+        return fut->wait_shared();
+    }
+
+    template<typename F>
+    shared_future<typename continuation_result<T, F>::type> then(F &&lambda) {
+        return fut->then(std::forward<F>(lambda));
+    }
+
+    template<typename F>
+    shared_future<typename continuation_result<T, F>::type> then_inline(
+            F &&lambda) {
+        return fut->then_inline(std::forward<F>(lambda));
+    }
+
+    // The underlying future, only valid as long as this handle is.
+    future_t<T> *get_future() const { return fut; }
+    future_t<T> *operator->() const { return fut; }
+
+    /*
+     * Conversion to a plain future pointer, so that code written before
+     * shared_future, e.g. future_t<T> *f = hclib::async_future(...), still
+     * compiles. Plain pointers are not tracked, so the promise is then never
+     * deleted, as before; hold a shared_future to have it freed.
+     */
+    operator future_t<T>*() const {
+        if (fut) hclib_promise_retain(fut->owner);
+        return fut;
+    }
+};
 
 }
 
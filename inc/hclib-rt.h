@@ -36,6 +36,7 @@ struct place_t;
 struct deque_t;
 struct hc_deque_t;
 struct finish_t;
+struct hclib_profile_sample_st;
 
 typedef struct hclib_worker_state {
         pthread_t t; // the pthread associated
@@ -52,6 +53,15 @@ typedef struct hclib_worker_state {
         int did; // the mapping device id
         LiteCtx *curr_ctx;
         LiteCtx *root_ctx;
+        int inline_depth; // nesting of INLINE_ASYNC tasks run in place
+        // phaser registrations of the task running on this worker
+        struct hclib_phaser_reg_t *current_phasers;
+        // graph being captured by the task running on this worker, if any
+        struct hclib_graph_st *capture;
+        // tasks made ready until the next one sampled by the task profiler
+        int profile_countdown;
+        // of the sampled task running on this worker, if any
+        struct hclib_profile_sample_st *profile_sample;
 } hclib_worker_state;
 
 #define HCLIB_MACRO_CONCAT(x, y) _HCLIB_MACRO_CONCAT_IMPL(x, y)
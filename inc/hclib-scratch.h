@@ -0,0 +1,47 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_SCRATCH_H_
+#define HCLIB_SCRATCH_H_
+
+#include <stddef.h>
+
+/**
+ * @file Scratch memory, freed in bulk at the end of a finish scope.
+ *
+ * Each finish scope has a bump-pointer arena per worker, which its tasks
+ * allocate from without any synchronization. The memory stays valid until the
+ * scope ends, i.e. hclib_end_finish returns (or the future of
+ * hclib_end_finish_nonblocking is satisfied), and may be used by any task in
+ * the meantime, including a task that resumed on another worker. The blocks of
+ * the arenas are then kept by the worker for the next scopes.
+ *
+ * Allocating a temporary in a nested finish scope bounds its lifetime to that
+ * scope.
+ */
+
+/*
+ * Allocate nbytes of scratch memory in the current finish scope, aligned for
+ * any type. Never returns NULL.
+ *
+ * Like malloc, the memory does not alias any other object.
+ */
+#ifdef __GNUC__
+__attribute__((malloc))
+#endif
+void *hclib_scratch_alloc(size_t nbytes);
+
+#endif /* HCLIB_SCRATCH_H_ */
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_SCRATCH_HPP_
+#define HCLIB_SCRATCH_HPP_
+
+#include <cstddef>
+#include <type_traits>
+
+#include "hclib-scratch.h"
+
+namespace hclib {
+
+/*
+ * Scratch memory of the current finish scope, see hclib-scratch.h.
+ */
+inline void *scratch_alloc(std::size_t nbytes) {
+    return hclib_scratch_alloc(nbytes);
+}
+
+/*
+ * Uninitialized array of count T, which are never destroyed.
+ */
+template <typename T>
+inline T *scratch_alloc(std::size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+            "scratch memory is freed without destroying its contents");
+    return static_cast<T *>(hclib_scratch_alloc(count * sizeof(T)));
+}
+
+}
+
+#endif /* HCLIB_SCRATCH_HPP_ */
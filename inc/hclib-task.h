@@ -17,7 +17,10 @@
 #ifndef HCLIB_TASK_H_
 #define HCLIB_TASK_H_
 
+#include <stdint.h>
+
 #include "hclib-rt.h"
+#include "hclib-workspan.h"
 
 /*
  * We just need to pack the function pointer and the pointer to
@@ -37,15 +40,23 @@
  *   5) future_list: a null-terminated list of pointers to the futures that
  *      this task depends on to execute, and which it will wait on before
  *      running.
+ *   6) phasers: the phaser registrations of this task, dropped once it
+ *      completes.
+ *   7) workspan: the work and spans of this task, only set while profiling
+ *      them.
  */
 typedef struct hclib_task_t {
+    // same layout as hclib_waiter_t, to sit in the wait lists of promises
+    struct hclib_task_t *next_waiter;
+    hclib_future_t **future_list; // Null terminated list
+    generic_frame_ptr _fp;
     void *args;
     struct finish_t *current_finish;
-    generic_frame_ptr _fp;
     int future_frontier; // index of next awaited future in list
-    hclib_future_t **future_list; // Null terminated list
+    int property; // ESCAPING_ASYNC, INLINE_ASYNC
     place_t *place;
-    struct hclib_task_t *next_waiter;
+    struct hclib_phaser_reg_t *phasers;
+    hclib_workspan_t *workspan;
 } hclib_task_t;
 
 /** @struct loop_domain_t
@@ -62,41 +73,66 @@ typedef struct {
     int tile;
 } loop_domain_t;
 
+/** @struct loop_domain64_t
+ * @brief Describe one dimension of an N-dimensional forasync domain, with
+ * 64-bit bounds. Fields have the same meaning as in loop_domain_t.
+ */
 typedef struct {
-    hclib_task_t *user;
-} forasync_t;
+    int64_t low;
+    int64_t high;
+    int64_t stride;
+    int64_t tile;
+} loop_domain64_t;
 
-typedef struct {
-    forasync_t base;
-    loop_domain_t loop0;
-} forasync1D_t;
+/** @brief Maximum number of dimensions of a forasync domain. */
+#define HCLIB_FORASYNC_MAX_DIM 8
 
-typedef struct _forasync_1D_task_t {
-    hclib_task_t forasync_task;
-    forasync1D_t def;
-} forasync1D_task_t;
+/*
+ * How the user function of a forasync is called by the runtime.
+ */
+typedef enum {
+    FORASYNC_KIND_1D,       // forasync1D_Fct_t, once per iteration
+    FORASYNC_KIND_2D,       // forasync2D_Fct_t, once per iteration
+    FORASYNC_KIND_3D,       // forasync3D_Fct_t, once per iteration
+    FORASYNC_KIND_RANGE,    // forasync_range_Fct_t, once per tile
+    FORASYNC_KIND_ND,       // forasyncND_Fct_t, once per iteration
+    FORASYNC_KIND_ND_RANGE, // forasyncND_range_Fct_t, once per tile
+} forasync_kind_t;
 
-typedef struct {
-    forasync_t base;
-    loop_domain_t loop0;
-    loop_domain_t loop1;
-} forasync2D_t;
+/*
+ * The loop body of a forasync, shared by all of its tasks. The runtime keeps
+ * a reference count of the tasks using it: once the forasync call has
+ * returned and the last of these tasks has completed, 'release' (if set) is
+ * called to free the body. With no release function, the caller must keep
+ * the body alive until the enclosing finish scope completes.
+ */
+typedef struct _forasync_body_t {
+    void *fct;
+    void *arg;
+    forasync_kind_t kind;
+    void (*release)(struct _forasync_body_t *body);
+    // Managed by the runtime
+    volatile int refcount;
+    struct _forasync_body_t *shared;
+} forasync_body_t;
 
-typedef struct _forasync_2D_task_t {
-    hclib_task_t forasync_task;
-    forasync2D_t def;
-} forasync2D_task_t;
+typedef struct {
+    forasync_body_t *body;
+} forasync_t;
 
+/*
+ * A forasync (sub-)domain. Only the first 'dim' entries of loop are valid, and
+ * forasync tasks are allocated with just enough room for those.
+ */
 typedef struct {
     forasync_t base;
-    loop_domain_t loop0;
-    loop_domain_t loop1;
-    loop_domain_t loop2;
-} forasync3D_t;
+    int dim;
+    loop_domain64_t loop[HCLIB_FORASYNC_MAX_DIM];
+} forasyncND_t;
 
-typedef struct _forasync_3D_task_t {
+typedef struct _forasync_ND_task_t {
     hclib_task_t forasync_task;
-    forasync3D_t def;
-} forasync3D_task_t;
+    forasyncND_t def;
+} forasyncND_task_t;
 
 #endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_TIMER_WHEEL_H_
+#define HCLIB_TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+#include "hclib-rt.h"
+#include "hclib-promise.h"
+
+/**
+ * @file Delayed and periodic tasks.
+ *
+ * Timers are kept in a hierarchical timer wheel, polled by idle workers from
+ * their steal loop. Once a timer expires, its task is pushed on the deque of
+ * the worker that noticed, so it may run late if every worker is busy, but
+ * never early. Timers are counted in the finish scope they were created in,
+ * which does not end before they have run for the last time or been cancelled.
+ *
+ * The returned future is satisfied once the timer is done, with the number of
+ * times fp was called cast to a (void *). It can be handed back with
+ * hclib_future_release once satisfied, and must not be before then if the
+ * timer may still be cancelled.
+ */
+
+/*
+ * Run fp(arg) as a task delay_ns nanoseconds from now.
+ */
+hclib_future_t *hclib_async_after(uint64_t delay_ns, generic_frame_ptr fp,
+        void *arg);
+
+/*
+ * Run fp(arg) as a task every period_ns nanoseconds, starting period_ns from
+ * now, until cancelled. Periods that expire while the previous run is still
+ * going are skipped.
+ */
+hclib_future_t *hclib_async_every(uint64_t period_ns, generic_frame_ptr fp,
+        void *arg);
+
+/*
+ * Cancel the timer behind the future returned by hclib_async_after or
+ * hclib_async_every. Returns 1 if fp will not be called again, or 0 if the
+ * timer was already done, or was a delayed task that has already started.
+ */
+int hclib_timer_cancel(hclib_future_t *timer);
+
+#endif /* HCLIB_TIMER_WHEEL_H_ */
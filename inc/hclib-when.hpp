@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_WHEN_H_
+#define HCLIB_WHEN_H_
+
+#include <vector>
+
+#include "hclib-async.hpp"
+
+namespace hclib {
+
+/*
+ * Future combinators. Rather than awaiting a list of futures, which registers
+ * the awaiting task again each time one of them is satisfied, a task can
+ * await the single future returned by when_all or when_any. These register
+ * once on each input and count down as the inputs are satisfied.
+ */
+
+template <typename T>
+struct is_future_handle {
+    static const bool value =
+        std::is_convertible<T, hclib_future_t*>::value;
+};
+
+template <typename T>
+struct is_future_handle<shared_future<T>> {
+    static const bool value = true;
+};
+
+inline shared_future<void> when_all_list(hclib_future_t **futures,
+        int nfutures) {
+    return shared_future<void>(static_cast<promise_t<void>*>(
+                hclib_when_all(futures, nfutures)->owner));
+}
+
+inline shared_future<size_t> when_any_list(hclib_future_t **futures,
+        int nfutures) {
+    return shared_future<size_t>(static_cast<promise_t<size_t>*>(
+                hclib_when_any(futures, nfutures)->owner));
+}
+
+template <typename... future_list_t>
+inline shared_future<void> when_all(future_list_t... futures) {
+    hclib_future_t *fs[] = { future_list_entry(futures)... };
+    return when_all_list(fs, sizeof...(futures));
+}
+
+inline shared_future<void> when_all() {
+    return when_all_list(nullptr, 0);
+}
+
+// when_all over a range of futures
+template <typename It, typename = typename std::enable_if<
+    !is_future_handle<It>::value>::type>
+inline shared_future<void> when_all(It first, It last) {
+    std::vector<hclib_future_t*> fs;
+    for (; first != last; ++first) {
+        fs.push_back(future_list_entry(*first));
+    }
+    return when_all_list(fs.data(), fs.size());
+}
+
+// when_all over an array of futures, which needs no copy
+inline shared_future<void> when_all(hclib_future_t **first,
+        hclib_future_t **last) {
+    return when_all_list(first, last - first);
+}
+
+/*
+ * The result of when_any is the index of the first future to be satisfied.
+ */
+template <typename... future_list_t>
+inline shared_future<size_t> when_any(future_list_t... futures) {
+    hclib_future_t *fs[] = { future_list_entry(futures)... };
+    return when_any_list(fs, sizeof...(futures));
+}
+
+// when_any over a range of futures
+template <typename It, typename = typename std::enable_if<
+    !is_future_handle<It>::value>::type>
+inline shared_future<size_t> when_any(It first, It last) {
+    std::vector<hclib_future_t*> fs;
+    for (; first != last; ++first) {
+        fs.push_back(future_list_entry(*first));
+    }
+    return when_any_list(fs.data(), fs.size());
+}
+
+inline shared_future<size_t> when_any(hclib_future_t **first,
+        hclib_future_t **last) {
+    return when_any_list(first, last - first);
+}
+
+}
+
+#endif /* HCLIB_WHEN_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HCLIB_WORKSPAN_H_
+#define HCLIB_WORKSPAN_H_
+
+#include <stdint.h>
+
+/**
+ * @file Work/span profiling, enabled by setting HCLIB_WORKSPAN.
+ *
+ * The runtime then times the strands of every task, in cycles, and follows
+ * the dependences between them: a spawned task starts where its parent was at
+ * the spawn, a task awaiting futures after the puts on them, and the
+ * continuation of a finish scope or of a wait after what it waited on. The
+ * work is the total time of all the strands and the span is the length of the
+ * critical path through them, so that no schedule on any number of workers can
+ * take less than work / workers or span cycles.
+ *
+ * The burdened span also charges HCLIB_WORKSPAN_BURDEN cycles (15000 by
+ * default) to each spawn, promise and join edge, as an estimate of what a
+ * steal costs. At hclib_launch exit, the parallelism (work / span), the
+ * burdened parallelism and the bounds on the speedup of the program and of
+ * its finish scopes are reported on stderr. Finish scopes are told apart by
+ * the call site of hclib_start_finish, and those nested in a scope of the
+ * same site (recursion) are accounted for in that one.
+ */
+
+typedef struct {
+    uint64_t work;
+    uint64_t span;
+    uint64_t burdened_span;
+} hclib_workspan_t;
+
+/*
+ * Get the work and spans of the last program run by hclib_launch with
+ * profiling enabled. Returns 0 if there has been none.
+ */
+int hclib_workspan_get(hclib_workspan_t *totals);
+
+#endif /* HCLIB_WORKSPAN_H_ */
@@ -24,6 +24,16 @@ extern "C" {
 #include "hclib_common.h"
 #include "hclib-task.h"
 #include "hclib-promise.h"
+#include "hclib-channel.h"
+#include "hclib-phaser.h"
+#include "hclib-accum.h"
+#include "hclib-graph.h"
+#include "hclib-io.h"
+#include "hclib-timer-wheel.h"
+#include "hclib-cancel.h"
+#include "hclib-scratch.h"
+#include "hclib-workspan.h"
+#include "hclib-profile.h"
 
 /**
  * @file Interface to HCLIB
@@ -36,9 +46,6 @@ extern "C" {
  * @{
  **/
 
-//TODO make this conditional in phased.h
-struct _phased_t;
-
 /**
  * @brief Function prototype executable by an async.
  * @param[in] arg           Arguments to the function
@@ -52,7 +59,7 @@ void hclib_launch(asyncFct_t fct_ptr, void * arg);
  * Async definition and API
  */
 
-// forward declaration for phased clause defined in phased.h
+// forward declaration for phased clause defined in hclib-phaser.h
 struct _phased_t;
 // forward declaration for promise_st in hclib-promise.h
 struct hclib_promise_st;
@@ -76,6 +83,30 @@ hclib_future_t *hclib_async_future(futureFct_t fp, void *arg,
         hclib_future_t **future_list, struct _phased_t *phased_clause,
         place_t *place, int property);
 
+/*
+ * Storage of a continuation registered with hclib_future_then_inline, to be
+ * embedded in the caller's own data.
+ */
+typedef struct hclib_continuation_st {
+    hclib_waiter_t trigger;
+    asyncFct_t fp;
+    void *arg;
+    struct finish_t *finish;
+} hclib_continuation_t;
+
+/*
+ * Call fp(arg) once future is satisfied, in place: right away if it already
+ * is, or else from within the hclib_promise_put that satisfies it, on the
+ * putting worker. This costs a trigger on the future rather than a task, for
+ * short continuations. fp runs in the current finish scope, which waits for
+ * it, and is not dropped if that scope is cancelled. Past
+ * HCLIB_MAX_INLINE_DEPTH continuations nested in each other, a task is
+ * scheduled to run fp instead. continuation must stay valid until fp is
+ * called.
+ */
+void hclib_future_then_inline(hclib_future_t *future,
+        hclib_continuation_t *continuation, asyncFct_t fp, void *arg);
+
 /*
  * Forasync definition and API
  */
@@ -87,8 +118,26 @@ typedef int forasync_mode_t;
 #define FORASYNC_MODE_RECURSIVE 1
 /** @brief Forasync mode to perform static chunking of the iteration space. */
 #define FORASYNC_MODE_FLAT 0
+/**
+ * @brief Forasync mode to split the iteration space lazily, only when the
+ * local deque runs out of work (the tile size is ignored).
+ */
+#define FORASYNC_MODE_ADAPTIVE 2
 /** @brief To indicate an async need not register with any finish scopes. */
 #define ESCAPING_ASYNC ((int) 0x2)
+/**
+ * @brief To indicate an async is short and non-blocking, and may run in place
+ * on the worker that satisfies its last future (or spawns it, if its futures
+ * are already satisfied), rather than being pushed on a deque. Inline
+ * execution nests at most HCLIB_MAX_INLINE_DEPTH deep, after which the async
+ * is scheduled as usual.
+ */
+#define INLINE_ASYNC ((int) 0x4)
+/**
+ * @brief To indicate an async must run even once its finish scope has been
+ * cancelled (see hclib-cancel.h), e.g. because it frees its argument.
+ */
+#define UNCANCELLABLE_ASYNC ((int) 0x8)
 
 /**
  * @brief Function prototype for a 1-dimension forasync.
@@ -115,6 +164,38 @@ typedef void (*forasync2D_Fct_t)(void *arg, int index_outer, int index_inner);
 typedef void (*forasync3D_Fct_t)(void *arg, int index_outer, int index_mid,
         int index_inner);
 
+/**
+ * @brief Function prototype for a range-based forasync of any dimension.
+ *
+ * Rather than being called once per iteration, the function is called once
+ * per tile with the sub-domain of the loop that tile covers, so that the
+ * innermost loop is under the control of the user (and the compiler).
+ *
+ * @param[in] arg               Argument to the loop tile
+ * @param[in] chunk             Bounds and stride of the tile in each dimension
+ *                              (array of size 'dim', outermost first)
+ */
+typedef void (*forasync_range_Fct_t)(void *arg, const loop_domain_t *chunk);
+
+/**
+ * @brief Function prototype for an N-dimensions forasync.
+ *
+ * @param[in] arg               Argument to the loop iteration
+ * @param[in] index             Current iteration index in each dimension
+ *                              (array of size 'dim', outermost first)
+ */
+typedef void (*forasyncND_Fct_t)(void *arg, const int64_t *index);
+
+/**
+ * @brief Function prototype for a range-based N-dimensions forasync.
+ *
+ * @param[in] arg               Argument to the loop tile
+ * @param[in] chunk             Bounds and stride of the tile in each dimension
+ *                              (array of size 'dim', outermost first)
+ */
+typedef void (*forasyncND_range_Fct_t)(void *arg,
+        const loop_domain64_t *chunk);
+
 /**
  * @brief Parallel for loop 'forasync' (up to 3 dimensions).
  *
@@ -136,12 +217,87 @@ void hclib_forasync(void *forasync_fct, void *argv,
 
 /*
  * Semantically equivalent to hclib_forasync, but returns a promise that is
- * triggered when all tasks belonging to this forasync have finished.
+ * triggered when all tasks belonging to this forasync have finished. As with
+ * hclib_end_finish_nonblocking, the future can be handed back with
+ * hclib_future_release.
  */
 hclib_future_t *hclib_forasync_future(void *forasync_fct, void *argv,
         hclib_future_t **future_list, int dim, const loop_domain_t *domain,
         forasync_mode_t mode);
 
+/*
+ * Equivalent to hclib_forasync, except that forasync_fct is called once for
+ * each tile of the domain rather than once for each iteration.
+ */
+void hclib_forasync_range(forasync_range_Fct_t forasync_fct, void *argv,
+        hclib_future_t **future_list, int dim, const loop_domain_t *domain,
+        forasync_mode_t mode);
+
+/*
+ * Range-based equivalent of hclib_forasync_future.
+ */
+hclib_future_t *hclib_forasync_range_future(forasync_range_Fct_t forasync_fct,
+        void *argv, hclib_future_t **future_list, int dim,
+        const loop_domain_t *domain, forasync_mode_t mode);
+
+/**
+ * @brief Parallel for loop 'forasync' over an N-dimensional domain with 64-bit
+ * bounds (up to HCLIB_FORASYNC_MAX_DIM dimensions).
+ *
+ * @param[in] forasync_fct      The function pointer to execute.
+ * @param[in] argv              Argument to the function
+ * @param[in] future_list       dependences
+ * @param[in] dim               Dimension of the loop
+ * @param[in] domain            Loop domains to iterate over (array of size 'dim').
+ * @param[in] mode              Forasync mode to control chunking strategy.
+ */
+void hclib_forasync_nd(forasyncND_Fct_t forasync_fct, void *argv,
+        hclib_future_t **future_list, int dim, const loop_domain64_t *domain,
+        forasync_mode_t mode);
+
+/*
+ * N-dimensional equivalent of hclib_forasync_future.
+ */
+hclib_future_t *hclib_forasync_nd_future(forasyncND_Fct_t forasync_fct,
+        void *argv, hclib_future_t **future_list, int dim,
+        const loop_domain64_t *domain, forasync_mode_t mode);
+
+/*
+ * N-dimensional equivalent of hclib_forasync_range.
+ */
+void hclib_forasync_nd_range(forasyncND_range_Fct_t forasync_fct, void *argv,
+        hclib_future_t **future_list, int dim, const loop_domain64_t *domain,
+        forasync_mode_t mode);
+
+/*
+ * N-dimensional equivalent of hclib_forasync_range_future.
+ */
+hclib_future_t *hclib_forasync_nd_range_future(
+        forasyncND_range_Fct_t forasync_fct, void *argv,
+        hclib_future_t **future_list, int dim, const loop_domain64_t *domain,
+        forasync_mode_t mode);
+
+/**
+ * @brief Forasync over an N-dimensional domain, with a caller-provided loop
+ * body.
+ *
+ * The fct, arg, kind and release fields of the body must be set. The body is
+ * shared by all the tasks of the forasync, and released through its release
+ * function once this call has returned and the last of these tasks has
+ * completed. This lets the body and the state it refers to be allocated
+ * together, and freed without waiting on the forasync.
+ *
+ * The 1D, 2D and 3D kinds need dim to match, and the range kind takes up to
+ * three dimensions; the program aborts on any other combination.
+ *
+ * @param[in] body              Loop body shared by all tasks.
+ * @param[in] dim               Dimension of the loop
+ * @param[in] domain            Loop domains to iterate over (array of size 'dim').
+ * @param[in] mode              Forasync mode to control chunking strategy.
+ */
+void hclib_forasync_body(forasync_body_t *body, int dim,
+        const loop_domain64_t *domain, forasync_mode_t mode);
+
 /**
  * @brief starts a new finish scope
  */
@@ -154,7 +310,9 @@ void hclib_end_finish();
 
 /*
  * Get a promise that is triggered when all tasks inside this finish scope have
- * finished, but return immediately.
+ * finished, but return immediately. The caller can hand the future back with
+ * hclib_future_release once it is done with it, and the promise is then freed
+ * as soon as it has been satisfied.
  */
 hclib_future_t *hclib_end_finish_nonblocking();
 void hclib_end_finish_nonblocking_helper(hclib_promise_t *event);
@@ -23,6 +23,15 @@
 #include "hclib-async.hpp"
 #include "hclib-forasync.hpp"
 #include "hclib-promise.hpp"
+#include "hclib-when.hpp"
+#include "hclib-channel.hpp"
+#include "hclib-accum.hpp"
+#include "hclib-graph.hpp"
+#include "hclib-cancel.hpp"
+#include "hclib-scratch.hpp"
+#include "hclib-coroutine.hpp"
+#include "hclib-par.hpp"
+#include "hclib-concurrent-map.hpp"
 
 namespace hclib {
 
@@ -40,6 +40,9 @@
 /** @brief No accumulator argument provided. */
 #define NO_ACCUM NULL
 
+/** @brief Size in bytes used to pad per-worker data onto separate cache lines. */
+#define HCLIB_CACHE_LINE_SIZE 64
+
 #define HCLIB_LITECTX_STRATEGY 1
 // #define VERBOSE 1
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+
+#include "hclib-internal.h"
+#include "hclib-accum.h"
+
+struct hclib_accum_st {
+    size_t size;
+    size_t stride; // distance between lanes, in whole cache lines
+    hclib_accum_op_t op;
+    void *arg;
+    int nlanes;
+    finish_t *finish; // scope the accumulator is declared on, if running
+    struct hclib_accum_st *next; // other accumulators of that scope
+    void *identity;
+    void *result;
+    char *lanes;
+    void *alloc; // lanes start at the first cache line boundary in there
+};
+
+static inline void *lane(hclib_accum_t *accum, int i) {
+    return accum->lanes + i * accum->stride;
+}
+
+hclib_accum_t *hclib_accum_create(size_t size, const void *identity,
+        hclib_accum_op_t op, void *arg) {
+    hclib_accum_t *accum = malloc(sizeof(hclib_accum_t));
+    HASSERT(accum);
+    accum->size = size;
+    accum->stride = (size + HCLIB_CACHE_LINE_SIZE - 1) /
+        HCLIB_CACHE_LINE_SIZE * HCLIB_CACHE_LINE_SIZE;
+    accum->op = op;
+    accum->arg = arg;
+    accum->nlanes = hclib_num_workers();
+    accum->finish = NULL;
+    accum->next = NULL;
+    accum->identity = malloc(size);
+    accum->result = malloc(size);
+    accum->alloc = malloc(accum->nlanes * accum->stride +
+            HCLIB_CACHE_LINE_SIZE);
+    HASSERT(accum->identity && accum->result && accum->alloc);
+    accum->lanes = (char *) (((uintptr_t) accum->alloc +
+                HCLIB_CACHE_LINE_SIZE - 1) & ~(uintptr_t)
+            (HCLIB_CACHE_LINE_SIZE - 1));
+    memcpy(accum->identity, identity, size);
+    memcpy(accum->result, identity, size);
+    return accum;
+}
+
+void hclib_accum_free(hclib_accum_t *accum) {
+    HASSERT(accum->finish == NULL);
+    free(accum->identity);
+    free(accum->result);
+    free(accum->alloc);
+    free(accum);
+}
+
+void hclib_start_finish_accum(hclib_accum_t **accums, int naccums) {
+    hclib_start_finish();
+    finish_t *finish = CURRENT_WS_INTERNAL->current_finish;
+    for (int i = 0; i < naccums; i++) {
+        hclib_accum_t *accum = accums[i];
+        HASSERT(accum->finish == NULL &&
+                "accumulator declared on a running finish scope");
+        for (int l = 0; l < accum->nlanes; l++) {
+            memcpy(lane(accum, l), accum->identity, accum->size);
+        }
+        accum->finish = finish;
+        accum->next = finish->accums;
+        finish->accums = accum;
+    }
+}
+
+void hclib_accum_put(hclib_accum_t *accum, const void *value) {
+    accum->op(lane(accum, get_current_worker()), value, accum->arg);
+}
+
+void *hclib_accum_lane(hclib_accum_t *accum) {
+    return lane(accum, get_current_worker());
+}
+
+const void *hclib_accum_get(hclib_accum_t *accum) {
+    HASSERT(accum->finish == NULL);
+    return accum->result;
+}
+
+void hclib_accum_combine_all(finish_t *finish) {
+    hclib_accum_t *accum = finish->accums;
+    while (accum) {
+        hclib_accum_t *next = accum->next;
+        memcpy(accum->result, accum->identity, accum->size);
+        for (int l = 0; l < accum->nlanes; l++) {
+            accum->op(accum->result, lane(accum, l), accum->arg);
+        }
+        accum->finish = NULL;
+        accum->next = NULL;
+        accum = next;
+    }
+    finish->accums = NULL;
+}
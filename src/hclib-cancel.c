@@ -0,0 +1,51 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hclib-internal.h"
+#include "hclib-cancel.h"
+
+hclib_cancel_token_t *hclib_cancel_token_create() {
+    hclib_cancel_token_t *token = (hclib_cancel_token_t *) malloc(
+            sizeof(hclib_cancel_token_t));
+    HASSERT(token);
+    token->cancelled = 0;
+    token->parent = NULL;
+    return token;
+}
+
+void hclib_cancel_token_free(hclib_cancel_token_t *token) {
+    free(token);
+}
+
+void hclib_start_finish_cancellable(hclib_cancel_token_t *token) {
+    hclib_start_finish();
+    finish_t *finish = CURRENT_WS_INTERNAL->current_finish;
+    token->parent = finish->cancel;
+    finish->cancel = token;
+}
+
+void hclib_cancel(hclib_cancel_token_t *token) {
+    _hclib_atomic_store_relaxed(&token->cancelled, 1);
+}
+
+int hclib_cancel_token_is_cancelled(hclib_cancel_token_t *token) {
+    return _hclib_cancel_token_is_cancelled(token);
+}
+
+int hclib_is_cancelled() {
+    finish_t *finish = CURRENT_WS_INTERNAL->current_finish;
+    return finish && _hclib_cancel_token_is_cancelled(finish->cancel);
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hclib-internal.h"
+#include "hclib-channel.h"
+
+/*
+ * A task waiting on a channel, either to receive a value into slot or to send
+ * value, and resumed by a put on its promise. The promise of recv_async is
+ * referenced by its waiter, while the others live on the stack of the waiting
+ * task.
+ */
+typedef struct hclib_channel_waiter_t {
+    hclib_promise_t *promise;
+    void **slot;
+    void *value;
+    int async;
+    struct hclib_channel_waiter_t *next;
+} hclib_channel_waiter_t;
+
+typedef struct {
+    hclib_channel_waiter_t *head;
+    hclib_channel_waiter_t *tail;
+} hclib_channel_waitq_t;
+
+struct hclib_channel_st {
+    _Atomic int lock;
+    int closed;
+    int capacity;
+    int head; // index of the oldest value in buffer
+    int count;
+    hclib_channel_waitq_t receivers;
+    hclib_channel_waitq_t senders;
+    void *buffer[];
+};
+
+// promise of hclib_channel_recv_async, along with its waiter
+typedef struct {
+    hclib_promise_t promise;
+    hclib_channel_waiter_t waiter;
+} hclib_channel_async_recv_t;
+
+#define CHANNEL_OK ((void *) 1)
+#define CHANNEL_CLOSED NULL
+
+/*
+ * The lock is only ever held for a few instructions, and never while waiting
+ * or putting on a promise.
+ */
+static inline void channel_lock(hclib_channel_t *channel) {
+    while (!_hclib_atomic_cas_acq_rel(&channel->lock, 0, 1)) { }
+}
+
+static inline void channel_unlock(hclib_channel_t *channel) {
+    _hclib_atomic_store_release(&channel->lock, 0);
+}
+
+static inline void waitq_push(hclib_channel_waitq_t *q,
+        hclib_channel_waiter_t *waiter) {
+    waiter->next = NULL;
+    if (q->tail) {
+        q->tail->next = waiter;
+    } else {
+        q->head = waiter;
+    }
+    q->tail = waiter;
+}
+
+static inline hclib_channel_waiter_t *waitq_pop(hclib_channel_waitq_t *q) {
+    hclib_channel_waiter_t *waiter = q->head;
+    if (waiter) {
+        q->head = waiter->next;
+        if (q->head == NULL) {
+            q->tail = NULL;
+        }
+    }
+    return waiter;
+}
+
+/*
+ * A waiter may be gone as soon as its promise is put, so this must be the last
+ * access to it.
+ */
+static inline void resume(hclib_channel_waiter_t *waiter, void *datum) {
+    hclib_promise_t *promise = waiter->promise;
+    const int async = waiter->async;
+    hclib_promise_put(promise, datum);
+    if (async) {
+        hclib_promise_release(promise);
+    }
+}
+
+hclib_channel_t *hclib_channel_create(int capacity) {
+    HASSERT(capacity >= 0);
+    hclib_channel_t *channel = (hclib_channel_t *) malloc(
+            sizeof(hclib_channel_t) + capacity * sizeof(void *));
+    HASSERT(channel);
+    _hclib_atomic_store_relaxed(&channel->lock, 0);
+    channel->closed = 0;
+    channel->capacity = capacity;
+    channel->head = 0;
+    channel->count = 0;
+    channel->receivers.head = channel->receivers.tail = NULL;
+    channel->senders.head = channel->senders.tail = NULL;
+    return channel;
+}
+
+void hclib_channel_free(hclib_channel_t *channel) {
+    HASSERT(channel->receivers.head == NULL && channel->senders.head == NULL);
+    free(channel);
+}
+
+int hclib_channel_send(hclib_channel_t *channel, void *value) {
+    channel_lock(channel);
+    if (channel->closed) {
+        channel_unlock(channel);
+        return 0;
+    }
+
+    hclib_channel_waiter_t *receiver = waitq_pop(&channel->receivers);
+    if (receiver) {
+        // the channel is empty, hand the value over directly
+        channel_unlock(channel);
+        *receiver->slot = value;
+        resume(receiver, CHANNEL_OK);
+        return 1;
+    }
+
+    if (channel->count < channel->capacity) {
+        channel->buffer[(channel->head + channel->count) % channel->capacity] =
+            value;
+        channel->count++;
+        channel_unlock(channel);
+        return 1;
+    }
+
+    // full: wait for a receiver to take the value
+    hclib_promise_t promise;
+    hclib_promise_init(&promise);
+    hclib_channel_waiter_t sender = { &promise, NULL, value, 0, NULL };
+    waitq_push(&channel->senders, &sender);
+    channel_unlock(channel);
+    return hclib_future_wait(&promise.future) == CHANNEL_OK;
+}
+
+/*
+ * Take the next value out of a locked channel into *value, if there is one.
+ * *sender is then set to the waiting sender this made room for, if any, to be
+ * resumed once the channel is unlocked.
+ */
+static int channel_take(hclib_channel_t *channel, void **value,
+        hclib_channel_waiter_t **sender) {
+    if (channel->count > 0) {
+        *value = channel->buffer[channel->head];
+        channel->head = (channel->head + 1) % channel->capacity;
+        channel->count--;
+        *sender = waitq_pop(&channel->senders);
+        if (*sender) {
+            channel->buffer[(channel->head + channel->count) %
+                channel->capacity] = (*sender)->value;
+            channel->count++;
+        }
+        return 1;
+    }
+
+    // with no room in the channel, take the value of a waiting sender
+    *sender = waitq_pop(&channel->senders);
+    if (*sender) {
+        *value = (*sender)->value;
+        return 1;
+    }
+    return 0;
+}
+
+int hclib_channel_recv(hclib_channel_t *channel, void **value) {
+    hclib_channel_waiter_t *sender;
+    channel_lock(channel);
+    if (channel_take(channel, value, &sender)) {
+        channel_unlock(channel);
+        if (sender) {
+            resume(sender, CHANNEL_OK);
+        }
+        return 1;
+    } else if (channel->closed) {
+        channel_unlock(channel);
+        return 0;
+    }
+
+    // empty: wait for a sender to hand a value over
+    hclib_promise_t promise;
+    hclib_promise_init(&promise);
+    hclib_channel_waiter_t receiver = { &promise, value, NULL, 0, NULL };
+    waitq_push(&channel->receivers, &receiver);
+    channel_unlock(channel);
+    return hclib_future_wait(&promise.future) == CHANNEL_OK;
+}
+
+hclib_future_t *hclib_channel_recv_async(hclib_channel_t *channel,
+        void **value) {
+    hclib_channel_async_recv_t *recv = (hclib_channel_async_recv_t *) malloc(
+            sizeof(hclib_channel_async_recv_t));
+    HASSERT(recv);
+    hclib_promise_init(&recv->promise);
+    recv->promise.destructor = hclib_promise_free;
+
+    hclib_channel_waiter_t *sender;
+    channel_lock(channel);
+    if (channel_take(channel, value, &sender)) {
+        channel_unlock(channel);
+        if (sender) {
+            resume(sender, CHANNEL_OK);
+        }
+        hclib_promise_put(&recv->promise, CHANNEL_OK);
+    } else if (channel->closed) {
+        channel_unlock(channel);
+        hclib_promise_put(&recv->promise, CHANNEL_CLOSED);
+    } else {
+        recv->waiter = (hclib_channel_waiter_t) { &recv->promise, value, NULL,
+            1, NULL };
+        // the waiter holds a reference until the promise is put
+        hclib_promise_retain(&recv->promise);
+        waitq_push(&channel->receivers, &recv->waiter);
+        channel_unlock(channel);
+    }
+    return &recv->promise.future;
+}
+
+void hclib_channel_close(hclib_channel_t *channel) {
+    channel_lock(channel);
+    channel->closed = 1;
+    hclib_channel_waitq_t receivers = channel->receivers;
+    hclib_channel_waitq_t senders = channel->senders;
+    channel->receivers.head = channel->receivers.tail = NULL;
+    channel->senders.head = channel->senders.tail = NULL;
+    channel_unlock(channel);
+
+    // waiting receivers imply that the channel is empty
+    hclib_channel_waiter_t *waiter;
+    while ((waiter = waitq_pop(&receivers))) {
+        resume(waiter, CHANNEL_CLOSED);
+    }
+    while ((waiter = waitq_pop(&senders))) {
+        resume(waiter, CHANNEL_CLOSED);
+    }
+}
@@ -37,6 +37,24 @@ int deque_push(deque_t *deq, hclib_task_t *entry) {
     return 1;
 }
 
+/*
+ * push up to n entries onto the tail of the deque, making them visible to
+ * thieves all at once, and return how many were pushed
+ */
+int deque_push_n(deque_t *deq, hclib_task_t **entries, int n) {
+    int tail = _hclib_atomic_load_relaxed(&deq->tail);
+    int head = _hclib_atomic_load_relaxed(&deq->head);
+    int room = INIT_DEQUE_CAPACITY - (tail - head);
+    if (n > room) {
+        n = room;
+    }
+    for (int i = 0; i < n; i++) {
+        deq->data[(tail + i) % INIT_DEQUE_CAPACITY] = entries[i];
+    }
+    _hclib_atomic_store_release(&deq->tail, tail + n);
+    return n;
+}
+
 /*
  * the steal protocol
  */
@@ -97,3 +115,11 @@ hclib_task_t *deque_pop(deque_t *deq) {
     return t;
 }
 
+/*
+ * approximate number of entries in the deque (exact if called by the owner
+ * while no steal is in progress)
+ */
+int deque_size(deque_t *deq) {
+    return _hclib_atomic_load_relaxed(&deq->tail) -
+        _hclib_atomic_load_relaxed(&deq->head);
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+
+#include "hclib-internal.h"
+#include "hclib-graph.h"
+
+// Successors made ready by a task, scheduled together
+#define GRAPH_READY_BATCH 64
+
+_Atomic int hclib_ncaptures = 0;
+
+/*
+ * A task recorded while capturing. Its handle is the future returned by
+ * hclib_async_future, which points back to the record.
+ */
+typedef struct graph_record_t {
+    hclib_future_t handle;
+    int index;
+    generic_frame_ptr fp;
+    futureFct_t future_fp;
+    void *arg;
+    place_t *place;
+    int property;
+    int ndeps;
+    hclib_future_t **deps;
+} graph_record_t;
+
+// Owner of all handles, which never gets satisfied
+hclib_promise_t hclib_graph_handle_owner = {
+    .future = { .owner = &hclib_graph_handle_owner },
+    .datum = UNINITIALIZED_PROMISE_DATA_PTR,
+    .wait_list_head = SENTINEL_FUTURE_WAITLIST_PTR,
+    .kind = PROMISE_KIND_SHARED,
+    .refcount = 1,
+};
+
+typedef struct {
+    void *data;
+    void (*release)(void *data);
+} graph_attachment_t;
+
+typedef struct hclib_graph_node_t {
+    hclib_task_t task; // reused by every launch
+    struct hclib_graph_st *graph;
+    generic_frame_ptr fp;
+    futureFct_t future_fp;
+    void *arg;
+    int indegree;
+    _Atomic int pending; // predecessors left in the current launch
+    int first_succ; // successors are succs[first_succ, first_succ + nsuccs)
+    int nsuccs;
+} hclib_graph_node_t;
+
+struct hclib_graph_st {
+    int nnodes;
+    hclib_graph_node_t *nodes;
+    int *succs;
+    int nroots;
+    int *roots;
+    hclib_task_t **ready; // roots of the launch in progress
+    int nexternal;
+    hclib_future_t **external; // waited on before each launch
+    int nattached;
+    int attached_capacity;
+    graph_attachment_t *attached;
+    // only while capturing
+    int records_capacity;
+    graph_record_t **records;
+};
+
+static void run_node(void *arg) {
+    hclib_graph_node_t *node = (hclib_graph_node_t *) arg;
+    /*
+     * Nodes are persistent tasks, which the runtime always runs, so that a
+     * cancelled node still makes its successors ready and the launch ends.
+     */
+    if ((node->task.property & UNCANCELLABLE_ASYNC) || !hclib_is_cancelled()) {
+        if (node->future_fp) {
+            (node->future_fp)(node->arg);
+        } else {
+            (node->fp)(node->arg);
+        }
+    }
+
+    hclib_graph_node_t *nodes = node->graph->nodes;
+    const int *succs = node->graph->succs;
+    hclib_task_t *ready[GRAPH_READY_BATCH];
+    int nready = 0;
+    for (int i = node->first_succ; i < node->first_succ + node->nsuccs; i++) {
+        hclib_graph_node_t *succ = &nodes[succs[i]];
+        if (_hclib_atomic_dec_acq_rel(&succ->pending) == 0) {
+            ready[nready++] = &succ->task;
+            if (nready == GRAPH_READY_BATCH) {
+                schedule_ready_tasks(ready, nready);
+                nready = 0;
+            }
+        }
+    }
+    if (nready > 0) {
+        schedule_ready_tasks(ready, nready);
+    }
+}
+
+void hclib_graph_capture_begin() {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    HASSERT(ws->capture == NULL && "already capturing a graph");
+    hclib_graph_t *graph = calloc(1, sizeof(hclib_graph_t));
+    HASSERT(graph);
+    graph->records_capacity = 64;
+    graph->records = malloc(graph->records_capacity * sizeof(graph_record_t *));
+    HASSERT(graph->records);
+    ws->capture = graph;
+    _hclib_atomic_inc_release(&hclib_ncaptures);
+}
+
+int hclib_graph_capturing() {
+    return _hclib_atomic_load_relaxed(&hclib_ncaptures) > 0 &&
+        CURRENT_WS_INTERNAL->capture;
+}
+
+hclib_future_t *hclib_graph_record(generic_frame_ptr fp, futureFct_t future_fp,
+        void *arg, hclib_future_t **future_list, place_t *place,
+        int property) {
+    hclib_graph_t *graph = CURRENT_WS_INTERNAL->capture;
+    // cancelled nodes skip their function unless UNCANCELLABLE_ASYNC
+    check_log_die(property & ~(INLINE_ASYNC | UNCANCELLABLE_ASYNC),
+            "tasks with property %d cannot be recorded in a graph", property);
+    graph_record_t *record = malloc(sizeof(graph_record_t));
+    HASSERT(record);
+    record->handle.owner = &hclib_graph_handle_owner;
+    record->index = graph->nnodes;
+    record->fp = fp;
+    record->future_fp = future_fp;
+    record->arg = arg;
+    record->place = place;
+    record->property = property;
+    record->ndeps = 0;
+    if (future_list) {
+        while (future_list[record->ndeps]) record->ndeps++;
+    }
+    record->deps = NULL;
+    if (record->ndeps > 0) {
+        record->deps = malloc(record->ndeps * sizeof(hclib_future_t *));
+        HASSERT(record->deps);
+        memcpy(record->deps, future_list,
+                record->ndeps * sizeof(hclib_future_t *));
+    }
+
+    if (graph->nnodes == graph->records_capacity) {
+        graph->records_capacity *= 2;
+        graph->records = realloc(graph->records,
+                graph->records_capacity * sizeof(graph_record_t *));
+        HASSERT(graph->records);
+    }
+    graph->records[graph->nnodes++] = record;
+    return &record->handle;
+}
+
+void hclib_graph_attach(void *data, void (*release)(void *data)) {
+    hclib_graph_t *graph = CURRENT_WS_INTERNAL->capture;
+    HASSERT(graph && "not capturing a graph");
+    if (graph->nattached == graph->attached_capacity) {
+        graph->attached_capacity = graph->attached_capacity ?
+            2 * graph->attached_capacity : 64;
+        graph->attached = realloc(graph->attached,
+                graph->attached_capacity * sizeof(graph_attachment_t));
+        HASSERT(graph->attached);
+    }
+    graph->attached[graph->nattached].data = data;
+    graph->attached[graph->nattached].release = release;
+    graph->nattached++;
+}
+
+static inline graph_record_t *handle_record(hclib_future_t *future) {
+    return future->owner == &hclib_graph_handle_owner ?
+        (graph_record_t *) future : NULL;
+}
+
+hclib_graph_t *hclib_graph_capture_end() {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    hclib_graph_t *graph = ws->capture;
+    HASSERT(graph && "not capturing a graph");
+    ws->capture = NULL;
+    _hclib_atomic_dec_release(&hclib_ncaptures);
+
+    const int n = graph->nnodes;
+    graph->nodes = malloc(n * sizeof(hclib_graph_node_t));
+    graph->roots = malloc(n * sizeof(int));
+    graph->ready = malloc(n * sizeof(hclib_task_t *));
+    HASSERT(n == 0 || (graph->nodes && graph->roots && graph->ready));
+
+    // count the edges out of every node, and the external dependencies
+    int nedges = 0;
+    int nexternal = 0;
+    for (int i = 0; i < n; i++) {
+        graph->nodes[i].nsuccs = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        graph_record_t *record = graph->records[i];
+        for (int d = 0; d < record->ndeps; d++) {
+            graph_record_t *pred = handle_record(record->deps[d]);
+            if (pred) {
+                HASSERT(pred->index < i && graph->records[pred->index] == pred);
+                graph->nodes[pred->index].nsuccs++;
+                nedges++;
+            } else {
+                nexternal++;
+            }
+        }
+    }
+    graph->succs = malloc(nedges * sizeof(int));
+    graph->external = malloc(nexternal * sizeof(hclib_future_t *));
+    int first = 0;
+    for (int i = 0; i < n; i++) {
+        graph->nodes[i].first_succ = first;
+        first += graph->nodes[i].nsuccs;
+        graph->nodes[i].nsuccs = 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        graph_record_t *record = graph->records[i];
+        hclib_graph_node_t *node = &graph->nodes[i];
+        node->task = (hclib_task_t) {
+            ._fp = run_node,
+            .args = node,
+            .place = record->place,
+            .property = record->property | PERSISTENT_TASK,
+        };
+        node->graph = graph;
+        node->fp = record->fp;
+        node->future_fp = record->future_fp;
+        node->arg = record->arg;
+        node->indegree = 0;
+        for (int d = 0; d < record->ndeps; d++) {
+            graph_record_t *pred = handle_record(record->deps[d]);
+            if (pred) {
+                hclib_graph_node_t *pred_node = &graph->nodes[pred->index];
+                graph->succs[pred_node->first_succ + pred_node->nsuccs++] = i;
+                node->indegree++;
+            } else {
+                graph->external[graph->nexternal++] = record->deps[d];
+            }
+        }
+        if (node->indegree == 0) {
+            graph->roots[graph->nroots++] = i;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(graph->records[i]->deps);
+        free(graph->records[i]);
+    }
+    free(graph->records);
+    graph->records = NULL;
+    return graph;
+}
+
+void hclib_graph_launch(hclib_graph_t *graph) {
+    HASSERT(graph->records == NULL && "graph still being captured");
+    for (int i = 0; i < graph->nexternal; i++) {
+        hclib_future_wait(graph->external[i]);
+    }
+    if (graph->nnodes == 0) {
+        return;
+    }
+
+    finish_t *finish = CURRENT_WS_INTERNAL->current_finish;
+    HASSERT(finish);
+    _hclib_atomic_add_acquire(&finish->counter, graph->nnodes);
+    for (int i = 0; i < graph->nnodes; i++) {
+        hclib_graph_node_t *node = &graph->nodes[i];
+        node->task.current_finish = finish;
+        _hclib_atomic_store_relaxed(&node->pending, node->indegree);
+    }
+    for (int i = 0; i < graph->nroots; i++) {
+        graph->ready[i] = &graph->nodes[graph->roots[i]].task;
+    }
+    schedule_ready_tasks(graph->ready, graph->nroots);
+}
+
+void hclib_graph_free(hclib_graph_t *graph) {
+    for (int i = 0; i < graph->nattached; i++) {
+        graph->attached[i].release(graph->attached[i].data);
+    }
+    free(graph->attached);
+    free(graph->nodes);
+    free(graph->succs);
+    free(graph->roots);
+    free(graph->ready);
+    free(graph->external);
+    free(graph);
+}
+
+int hclib_graph_size(hclib_graph_t *graph) {
+    return graph->nnodes;
+}
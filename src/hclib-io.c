@@ -0,0 +1,400 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hclib-internal.h"
+#include "hclib-io.h"
+
+#define IO_POLL_BATCH 64
+
+typedef enum {
+    IO_READ,
+    IO_WRITE,
+    IO_ACCEPT
+} hclib_io_kind_t;
+
+// promise of an operation, along with its arguments
+typedef struct hclib_io_op_t {
+    hclib_promise_t promise;
+    hclib_io_kind_t kind;
+    int fd;
+    int socket; // read and written with MSG_DONTWAIT
+    void *buf;
+    size_t count;
+    struct sockaddr *addr;
+    socklen_t *addrlen;
+    ssize_t result;
+    struct hclib_io_op_t *next;
+} hclib_io_op_t;
+
+/*
+ * Operations waiting on a descriptor, in order, reads and accepts in one queue
+ * and writes in the other, so that a descriptor can be read from and written
+ * to at the same time. The descriptor is registered with epoll for the
+ * directions that have operations waiting.
+ */
+typedef struct {
+    _Atomic int lock;
+    hclib_io_op_t *head[2];
+    hclib_io_op_t *tail[2];
+    int registered;
+    int restore_flags; // O_NONBLOCK was set here, to be cleared once idle
+} io_fd_t;
+
+_Atomic int hclib_io_pending = 0;
+
+static int epfd = -1;
+static _Atomic int poll_lock = 0;
+
+// indexed by descriptor, entries are kept for reuse
+static _Atomic int fds_lock = 0;
+static io_fd_t **fds = NULL;
+static int nfds = 0;
+
+/*
+ * Operations on regular files, which epoll does not support. Idle workers take
+ * them one at a time.
+ */
+static _Atomic int deferred_lock = 0;
+static hclib_io_op_t *deferred_head = NULL;
+static hclib_io_op_t *deferred_tail = NULL;
+
+void hclib_io_init() {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    HASSERT(epfd >= 0);
+}
+
+void hclib_io_cleanup() {
+    close(epfd);
+    epfd = -1;
+    for (int fd = 0; fd < nfds; fd++) {
+        free(fds[fd]);
+    }
+    free(fds);
+    fds = NULL;
+    nfds = 0;
+}
+
+static inline void spin_lock(_Atomic int *lock) {
+    while (!_hclib_atomic_cas_acq_rel(lock, 0, 1)) { }
+}
+
+static inline void spin_unlock(_Atomic int *lock) {
+    _hclib_atomic_store_release(lock, 0);
+}
+
+static void deferred_push(hclib_io_op_t *op) {
+    op->next = NULL;
+    spin_lock(&deferred_lock);
+    if (deferred_tail) {
+        deferred_tail->next = op;
+    } else {
+        deferred_head = op;
+    }
+    deferred_tail = op;
+    spin_unlock(&deferred_lock);
+}
+
+static hclib_io_op_t *deferred_pop() {
+    if (!_hclib_atomic_cas_acq_rel(&deferred_lock, 0, 1)) {
+        return NULL;
+    }
+    hclib_io_op_t *op = deferred_head;
+    if (op) {
+        deferred_head = op->next;
+        if (deferred_head == NULL) {
+            deferred_tail = NULL;
+        }
+    }
+    spin_unlock(&deferred_lock);
+    return op;
+}
+
+static io_fd_t *io_fd(int fd) {
+    spin_lock(&fds_lock);
+    if (fd >= nfds) {
+        int n = nfds ? 2 * nfds : 64;
+        while (n <= fd) n *= 2;
+        fds = realloc(fds, n * sizeof(io_fd_t *));
+        HASSERT(fds);
+        memset(fds + nfds, 0, (n - nfds) * sizeof(io_fd_t *));
+        nfds = n;
+    }
+    if (fds[fd] == NULL) {
+        fds[fd] = calloc(1, sizeof(io_fd_t));
+        HASSERT(fds[fd]);
+    }
+    io_fd_t *entry = fds[fd];
+    spin_unlock(&fds_lock);
+    return entry;
+}
+
+static inline int io_direction(hclib_io_op_t *op) {
+    return op->kind == IO_WRITE;
+}
+
+// Returns the result of the system call, or -errno
+static ssize_t io_try(hclib_io_op_t *op) {
+    ssize_t ret;
+    do {
+        switch (op->kind) {
+            case IO_READ:
+                ret = op->socket ?
+                    recv(op->fd, op->buf, op->count, MSG_DONTWAIT) :
+                    read(op->fd, op->buf, op->count);
+                break;
+            case IO_WRITE:
+                ret = op->socket ?
+                    send(op->fd, op->buf, op->count, MSG_DONTWAIT) :
+                    write(op->fd, op->buf, op->count);
+                break;
+            default:
+                ret = accept(op->fd, op->addr, op->addrlen);
+                break;
+        }
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? -errno : ret;
+}
+
+static inline int io_again(ssize_t ret) {
+    return ret == -EAGAIN || ret == -EWOULDBLOCK;
+}
+
+// the runtime holds a reference on the promise until it has put on it
+static void io_start(hclib_io_op_t *op) {
+    hclib_promise_retain(&op->promise);
+    _hclib_atomic_inc_relaxed(&hclib_io_pending);
+}
+
+static void io_complete(hclib_io_op_t *op, ssize_t ret) {
+    _hclib_atomic_dec_relaxed(&hclib_io_pending);
+    hclib_promise_put(&op->promise, (void *) (intptr_t) ret);
+    hclib_promise_release(&op->promise);
+}
+
+/*
+ * Other than on sockets, where MSG_DONTWAIT does, a descriptor only stays in
+ * non-blocking mode while operations are waiting on it, as its mode is shared
+ * with any other user of the open file. Called with the entry locked.
+ */
+static int io_set_nonblocking(io_fd_t *entry, int fd) {
+    if (entry->restore_flags) {
+        return 0;
+    }
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags < 0) {
+        return -errno;
+    }
+    if (!(flags & O_NONBLOCK)) {
+        if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            return -errno;
+        }
+        entry->restore_flags = 1;
+    }
+    return 0;
+}
+
+/*
+ * Register the descriptor with epoll for the operations waiting on it, or
+ * unregister it and restore its mode if none are. Called with the entry
+ * locked.
+ */
+static int io_arm(io_fd_t *entry, int fd) {
+    const int events = (entry->head[0] ? EPOLLIN : 0) |
+        (entry->head[1] ? EPOLLOUT : 0);
+    if (events == 0) {
+        if (entry->registered) {
+            epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+            entry->registered = 0;
+        }
+        if (entry->restore_flags) {
+            const int flags = fcntl(fd, F_GETFL);
+            if (flags >= 0) {
+                fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+            }
+            entry->restore_flags = 0;
+        }
+        return 0;
+    }
+
+    struct epoll_event ev;
+    ev.events = events | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, entry->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd,
+                &ev) < 0) {
+        return -errno;
+    }
+    entry->registered = 1;
+    return 0;
+}
+
+static void io_push(io_fd_t *entry, hclib_io_op_t *op) {
+    const int dir = io_direction(op);
+    op->next = NULL;
+    if (entry->tail[dir]) {
+        entry->tail[dir]->next = op;
+    } else {
+        entry->head[dir] = op;
+    }
+    entry->tail[dir] = op;
+}
+
+static hclib_io_op_t *io_pop(io_fd_t *entry, int dir) {
+    hclib_io_op_t *op = entry->head[dir];
+    entry->head[dir] = op->next;
+    if (entry->head[dir] == NULL) {
+        entry->tail[dir] = NULL;
+    }
+    return op;
+}
+
+static hclib_future_t *io_submit(hclib_io_kind_t kind, int fd, void *buf,
+        size_t count, struct sockaddr *addr, socklen_t *addrlen) {
+    hclib_io_op_t *op = (hclib_io_op_t *) malloc(sizeof(hclib_io_op_t));
+    HASSERT(op);
+    hclib_promise_init(&op->promise);
+    op->promise.destructor = hclib_promise_free;
+    op->kind = kind;
+    op->fd = fd;
+    op->buf = buf;
+    op->count = count;
+    op->addr = addr;
+    op->addrlen = addrlen;
+
+    // as the system call would, without indexing the table with it
+    if (fd < 0) {
+        hclib_promise_put(&op->promise, (void *) (intptr_t) -EBADF);
+        return &op->promise.future;
+    }
+
+    struct stat st;
+    const int known = (fstat(fd, &st) == 0);
+    if (known && S_ISREG(st.st_mode)) {
+        op->socket = 0;
+        io_start(op);
+        deferred_push(op);
+        return &op->promise.future;
+    }
+    op->socket = known && S_ISSOCK(st.st_mode) && kind != IO_ACCEPT;
+
+    io_fd_t *entry = io_fd(fd);
+    spin_lock(&entry->lock);
+    ssize_t ret = op->socket ? 0 : io_set_nonblocking(entry, fd);
+    // behind the operations already waiting in the same direction, if any
+    if (ret == 0 && entry->head[io_direction(op)] == NULL) {
+        ret = io_try(op);
+    } else if (ret == 0) {
+        ret = -EAGAIN;
+    }
+    if (io_again(ret)) {
+        io_start(op);
+        io_push(entry, op);
+        ret = io_arm(entry, fd);
+        if (ret < 0) {
+            io_pop(entry, io_direction(op));
+            io_arm(entry, fd);
+            spin_unlock(&entry->lock);
+            io_complete(op, ret);
+            return &op->promise.future;
+        }
+        spin_unlock(&entry->lock);
+        return &op->promise.future;
+    }
+    io_arm(entry, fd);
+    spin_unlock(&entry->lock);
+    hclib_promise_put(&op->promise, (void *) (intptr_t) ret);
+    return &op->promise.future;
+}
+
+hclib_future_t *hclib_async_read(int fd, void *buf, size_t count) {
+    return io_submit(IO_READ, fd, buf, count, NULL, NULL);
+}
+
+hclib_future_t *hclib_async_write(int fd, const void *buf, size_t count) {
+    return io_submit(IO_WRITE, fd, (void *) buf, count, NULL, NULL);
+}
+
+hclib_future_t *hclib_async_accept(int fd, struct sockaddr *addr,
+        socklen_t *addrlen) {
+    return io_submit(IO_ACCEPT, fd, NULL, 0, addr, addrlen);
+}
+
+/*
+ * Called by idle workers while operations are pending. Only one worker at a
+ * time waits on epoll, with a zero timeout, and the promises are put once it
+ * has let go of it. Returns the number of operations completed.
+ */
+int hclib_io_poll() {
+    int ncompleted = 0;
+
+    hclib_io_op_t *op = deferred_pop();
+    if (op) {
+        const ssize_t ret = io_try(op);
+        if (io_again(ret)) {
+            deferred_push(op);
+        } else {
+            io_complete(op, ret);
+            ncompleted++;
+        }
+    }
+
+    if (!_hclib_atomic_cas_acq_rel(&poll_lock, 0, 1)) {
+        return ncompleted;
+    }
+    struct epoll_event events[IO_POLL_BATCH];
+    hclib_io_op_t *done = NULL;
+    const int nevents = epoll_wait(epfd, events, IO_POLL_BATCH, 0);
+    for (int i = 0; i < nevents; i++) {
+        const int fd = events[i].data.fd;
+        io_fd_t *entry = io_fd(fd);
+        spin_lock(&entry->lock);
+        // either direction may have been woken up, or neither (spuriously)
+        for (int dir = 0; dir < 2; dir++) {
+            while (entry->head[dir]) {
+                const ssize_t ret = io_try(entry->head[dir]);
+                if (io_again(ret)) {
+                    break;
+                }
+                op = io_pop(entry, dir);
+                op->result = ret;
+                op->next = done;
+                done = op;
+            }
+        }
+        // re-arms the one-shot registration
+        const int err = io_arm(entry, fd);
+        HASSERT(err == 0);
+        spin_unlock(&entry->lock);
+    }
+    _hclib_atomic_store_release(&poll_lock, 0);
+
+    while (done) {
+        op = done;
+        done = op->next;
+        io_complete(op, op->result);
+        ncompleted++;
+    }
+    return ncompleted;
+}
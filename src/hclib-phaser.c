@@ -0,0 +1,358 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "hclib-internal.h"
+#include "hclib-phaser.h"
+
+/*
+ * Signals are combined through a tree whose leaves are shared out between the
+ * signalers, so that each phase only has a few arrivals per counter. The node
+ * counting down the last arrival of its subtree moves on to its parent, and the
+ * one that completes the root moves the phaser to the next phase.
+ */
+#define PHASER_TREE_FANOUT 4
+
+typedef struct phaser_node_t {
+    _Atomic int pending; // arrivals still missing in the current phase
+    int expected; // signalers on this leaf, or children with any
+    struct phaser_node_t *parent;
+    char pad[HCLIB_CACHE_LINE_SIZE - 2 * sizeof(int) - sizeof(void *)];
+} phaser_node_t;
+
+/*
+ * The registration of a task on a phaser. phase is the next phase the task
+ * signals and/or waits for.
+ */
+typedef struct hclib_phaser_reg_t {
+    hclib_phaser_t *phaser;
+    hclib_phaser_mode_t mode;
+    int phase;
+    int signalled; // already signalled phase
+    phaser_node_t *leaf;
+    struct hclib_phaser_reg_t *next; // other registrations of the same task
+    struct hclib_phaser_reg_t *prev_signaler;
+    struct hclib_phaser_reg_t *next_signaler;
+} hclib_phaser_reg_t;
+
+struct hclib_phaser_st {
+    _Atomic int lock;
+    _Atomic int phase; // all phases before this one are complete
+    _Atomic int refcount; // registrations, plus drops still arriving
+    hclib_promise_t *phase_done; // put once the current phase completes
+    finish_t *finish; // scope at the end of which the creator is dropped
+    int nsignalers;
+    /*
+     * Set when signalers register or drop, in which case the leaves are shared
+     * out again once the current phase completes.
+     */
+    int dirty;
+    hclib_phaser_reg_t *signalers;
+    int nleaves;
+    int nnodes;
+    phaser_node_t nodes[]; // leaves first, root last
+};
+
+static inline void phaser_lock(hclib_phaser_t *phaser) {
+    while (!_hclib_atomic_cas_acq_rel(&phaser->lock, 0, 1)) { }
+}
+
+static inline void phaser_unlock(hclib_phaser_t *phaser) {
+    _hclib_atomic_store_release(&phaser->lock, 0);
+}
+
+static inline void phaser_release(hclib_phaser_t *phaser) {
+    if (_hclib_atomic_dec_acq_rel(&phaser->refcount) == 0) {
+        hclib_promise_release(phaser->phase_done);
+        free(phaser);
+    }
+}
+
+/*
+ * Get the tree ready for the next phase. Called with the lock held, or before
+ * the phaser is shared.
+ */
+static void reset_tree(hclib_phaser_t *phaser) {
+    phaser_node_t *nodes = phaser->nodes;
+    if (phaser->dirty) {
+        for (int i = 0; i < phaser->nnodes; i++) {
+            nodes[i].expected = 0;
+        }
+        int i = 0;
+        for (hclib_phaser_reg_t *reg = phaser->signalers; reg;
+                reg = reg->next_signaler) {
+            reg->leaf = &nodes[i];
+            reg->leaf->expected++;
+            i = (i + 1) % phaser->nleaves;
+        }
+        // Children come before their parent
+        for (int i = 0; i < phaser->nnodes - 1; i++) {
+            if (nodes[i].expected > 0) {
+                nodes[i].parent->expected++;
+            }
+        }
+        phaser->dirty = 0;
+    }
+    for (int i = 0; i < phaser->nnodes; i++) {
+        _hclib_atomic_store_relaxed(&nodes[i].pending, nodes[i].expected);
+    }
+}
+
+static void advance(hclib_phaser_t *phaser) {
+    hclib_promise_t *done = hclib_promise_create();
+    phaser_lock(phaser);
+    reset_tree(phaser);
+    hclib_promise_t *completed = phaser->phase_done;
+    phaser->phase_done = done;
+    _hclib_atomic_inc_release(&phaser->phase);
+    phaser_unlock(phaser);
+
+    hclib_promise_put(completed, NULL);
+    hclib_promise_release(completed);
+}
+
+static void arrive(hclib_phaser_t *phaser, phaser_node_t *leaf) {
+    for (phaser_node_t *node = leaf; node; node = node->parent) {
+        if (_hclib_atomic_dec_acq_rel(&node->pending) > 0) {
+            return;
+        }
+    }
+    advance(phaser);
+}
+
+// Wait for phase to complete
+static void wait_phase(hclib_phaser_t *phaser, int phase) {
+    if (_hclib_atomic_load_acquire(&phaser->phase) > phase) {
+        return;
+    }
+    phaser_lock(phaser);
+    if (_hclib_atomic_load_relaxed(&phaser->phase) > phase ||
+            phaser->nsignalers == 0) {
+        phaser_unlock(phaser);
+        return;
+    }
+    hclib_promise_t *done = phaser->phase_done;
+    hclib_promise_retain(done);
+    phaser_unlock(phaser);
+
+    hclib_future_wait(&done->future);
+    hclib_promise_release(done);
+}
+
+static void signal_reg(hclib_phaser_reg_t *reg) {
+    if (!(reg->mode & PHASER_SIG) || reg->signalled) {
+        return;
+    }
+    hclib_phaser_t *phaser = reg->phaser;
+    // Only the current phase can be signalled
+    wait_phase(phaser, reg->phase - 1);
+    reg->signalled = 1;
+    arrive(phaser, reg->leaf);
+}
+
+static void drop_reg(hclib_phaser_reg_t *reg) {
+    hclib_phaser_t *phaser = reg->phaser;
+    int arriving = 0;
+    phaser_lock(phaser);
+    if (reg->mode & PHASER_SIG) {
+        arriving = !reg->signalled &&
+            reg->phase == _hclib_atomic_load_relaxed(&phaser->phase);
+        if (reg->prev_signaler) {
+            reg->prev_signaler->next_signaler = reg->next_signaler;
+        } else {
+            phaser->signalers = reg->next_signaler;
+        }
+        if (reg->next_signaler) {
+            reg->next_signaler->prev_signaler = reg->prev_signaler;
+        }
+        phaser->nsignalers--;
+        phaser->dirty = 1;
+    }
+    phaser_node_t *leaf = reg->leaf;
+    phaser_unlock(phaser);
+    free(reg);
+
+    if (arriving) {
+        arrive(phaser, leaf);
+    }
+    phaser_release(phaser);
+}
+
+static hclib_phaser_reg_t *find_reg(hclib_phaser_t *phaser) {
+    hclib_phaser_reg_t *reg = CURRENT_WS_INTERNAL->current_phasers;
+    while (reg && reg->phaser != phaser) {
+        reg = reg->next;
+    }
+    HASSERT(reg && "the current task is not registered on this phaser");
+    return reg;
+}
+
+static hclib_phaser_reg_t *register_child(hclib_phaser_reg_t *parent,
+        hclib_phaser_mode_t mode) {
+    HASSERT((mode & ~parent->mode) == 0 &&
+            "a task can only register others in its own mode");
+    hclib_phaser_t *phaser = parent->phaser;
+    hclib_phaser_reg_t *reg = malloc(sizeof(*reg));
+    HASSERT(reg);
+    reg->phaser = phaser;
+    reg->mode = mode;
+    reg->phase = parent->phase;
+    reg->signalled = 0;
+    reg->leaf = NULL;
+    reg->next = NULL;
+    _hclib_atomic_inc_relaxed(&phaser->refcount);
+
+    if (mode & PHASER_SIG) {
+        phaser_lock(phaser);
+        if (!parent->signalled &&
+                parent->phase == _hclib_atomic_load_relaxed(&phaser->phase)) {
+            /*
+             * The current phase cannot complete before the parent signals, so
+             * the child can take part in it on the same leaf.
+             */
+            reg->leaf = parent->leaf;
+            _hclib_atomic_inc_relaxed(&reg->leaf->pending);
+        } else if (parent->signalled) {
+            reg->phase++;
+        }
+        reg->prev_signaler = NULL;
+        reg->next_signaler = phaser->signalers;
+        if (phaser->signalers) {
+            phaser->signalers->prev_signaler = reg;
+        }
+        phaser->signalers = reg;
+        phaser->nsignalers++;
+        phaser->dirty = 1;
+        phaser_unlock(phaser);
+    }
+    return reg;
+}
+
+hclib_phaser_reg_t *hclib_phased_register(hclib_phased_t *phased_clause,
+        int property) {
+    hclib_phaser_reg_t *regs = NULL;
+    hclib_phaser_reg_t **tail = &regs;
+    hclib_phaser_reg_t *parents = CURRENT_WS_INTERNAL->current_phasers;
+    if (property & PHASER_TRANSMIT_ALL) {
+        for (hclib_phaser_reg_t *parent = parents; parent;
+                parent = parent->next) {
+            *tail = register_child(parent, parent->mode);
+            tail = &(*tail)->next;
+        }
+    } else if (phased_clause) {
+        for (int i = 0; i < phased_clause->count; i++) {
+            *tail = register_child(find_reg(phased_clause->phasers[i]),
+                    phased_clause->modes[i]);
+            tail = &(*tail)->next;
+        }
+    }
+    return regs;
+}
+
+void hclib_phaser_drop_all(hclib_phaser_reg_t *regs) {
+    while (regs) {
+        hclib_phaser_reg_t *next = regs->next;
+        drop_reg(regs);
+        regs = next;
+    }
+}
+
+void hclib_phaser_drop_scope(finish_t *finish) {
+    hclib_phaser_reg_t **link = &CURRENT_WS_INTERNAL->current_phasers;
+    while (*link) {
+        hclib_phaser_reg_t *reg = *link;
+        if (reg->phaser->finish == finish) {
+            *link = reg->next;
+            drop_reg(reg);
+        } else {
+            link = &reg->next;
+        }
+    }
+}
+
+hclib_phaser_t *hclib_phaser_create(hclib_phaser_mode_t mode) {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    const int nleaves = hclib_num_workers();
+    int nnodes = 0;
+    for (int n = nleaves; ; n = (n + PHASER_TREE_FANOUT - 1) /
+            PHASER_TREE_FANOUT) {
+        nnodes += n;
+        if (n == 1) break;
+    }
+
+    hclib_phaser_t *phaser = malloc(sizeof(hclib_phaser_t) +
+            nnodes * sizeof(phaser_node_t));
+    HASSERT(phaser);
+    int first = 0;
+    for (int n = nleaves; n > 1; n = (n + PHASER_TREE_FANOUT - 1) /
+            PHASER_TREE_FANOUT) {
+        for (int i = 0; i < n; i++) {
+            phaser->nodes[first + i].parent =
+                &phaser->nodes[first + n + i / PHASER_TREE_FANOUT];
+        }
+        first += n;
+    }
+    phaser->nodes[nnodes - 1].parent = NULL;
+    phaser->nleaves = nleaves;
+    phaser->nnodes = nnodes;
+
+    hclib_phaser_reg_t *reg = malloc(sizeof(*reg));
+    HASSERT(reg);
+    reg->phaser = phaser;
+    reg->mode = mode;
+    reg->phase = 0;
+    reg->signalled = 0;
+    reg->leaf = NULL;
+    reg->prev_signaler = NULL;
+    reg->next_signaler = NULL;
+
+    _hclib_atomic_store_relaxed(&phaser->lock, 0);
+    _hclib_atomic_store_relaxed(&phaser->phase, 0);
+    _hclib_atomic_store_relaxed(&phaser->refcount, 1);
+    phaser->phase_done = hclib_promise_create();
+    phaser->finish = ws->current_finish;
+    phaser->nsignalers = (mode & PHASER_SIG) ? 1 : 0;
+    phaser->signalers = (mode & PHASER_SIG) ? reg : NULL;
+    phaser->dirty = 1;
+    reset_tree(phaser);
+
+    reg->next = ws->current_phasers;
+    ws->current_phasers = reg;
+    return phaser;
+}
+
+void hclib_phaser_signal(hclib_phaser_t *phaser) {
+    signal_reg(find_reg(phaser));
+}
+
+void hclib_phaser_next(hclib_phaser_t *phaser) {
+    hclib_phaser_reg_t *reg = find_reg(phaser);
+    signal_reg(reg);
+    if (reg->mode & PHASER_WAIT) {
+        wait_phase(phaser, reg->phase);
+    }
+    reg->phase++;
+    reg->signalled = 0;
+}
+
+void hclib_phaser_drop(hclib_phaser_t *phaser) {
+    hclib_phaser_reg_t **link = &CURRENT_WS_INTERNAL->current_phasers;
+    while (*link && (*link)->phaser != phaser) {
+        link = &(*link)->next;
+    }
+    HASSERT(*link && "the current task is not registered on this phaser");
+    hclib_phaser_reg_t *reg = *link;
+    *link = reg->next;
+    drop_reg(reg);
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE // dladdr
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hclib-internal.h"
+
+#define PROFILE_DEFAULT_PERIOD 100
+// task functions kept by each worker, further ones are lumped together
+#define PROFILE_MAX_FUNCTIONS 256
+#define PROFILE_SIGNAL SIGUSR2
+// initial room for the sampled tasks made ready by a worker, a power of two
+#define PROFILE_MIN_PENDING 64
+
+typedef struct {
+    void *fn; // NULL for the lumped functions
+    uint64_t samples;
+    uint64_t stolen;
+    uint64_t run_ns;
+    uint64_t queued_ns;
+} profile_entry_t;
+
+// A sampled task waiting to run, kept here rather than in the task.
+typedef struct {
+    hclib_task_t *task; // NULL for a free slot
+    uint64_t ready_at;
+} profile_pending_t;
+
+typedef struct {
+    uint64_t random; // of the sampling period, never 0
+    profile_entry_t entries[PROFILE_MAX_FUNCTIONS + 1];
+    // taken by the worker running a task it sampled, as it may be stolen
+    _Atomic int lock;
+    size_t npending;
+    size_t capacity; // of pending, kept at most 3/4 full
+    profile_pending_t *pending;
+    char pad[HCLIB_CACHE_LINE_SIZE];
+} profile_worker_t;
+
+extern hc_context *hclib_context;
+
+int hclib_profile_enabled = 0;
+static int period = PROFILE_DEFAULT_PERIOD;
+static profile_worker_t *workers = NULL;
+// registered by hclib_profile_name_task, possibly before the runtime starts
+static void * _Atomic names = NULL;
+static volatile sig_atomic_t report_requested = 0;
+static struct sigaction previous_action;
+
+uint64_t hclib_profile_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// uniform in [1, 2 * period - 1], so as not to follow patterns in the tasks
+static int next_countdown(profile_worker_t *pw) {
+    // xorshift64
+    pw->random ^= pw->random << 13;
+    pw->random ^= pw->random >> 7;
+    pw->random ^= pw->random << 17;
+    return 1 + (int) (pw->random % (2 * (uint64_t) period - 1));
+}
+
+static void request_report(int signum) {
+    report_requested = 1;
+}
+
+void hclib_profile_init() {
+    hclib_profile_enabled = (getenv("HCLIB_PROFILE") != NULL);
+    if (!hclib_profile_enabled) {
+        return;
+    }
+    const char *period_str = getenv("HCLIB_PROFILE_PERIOD");
+    period = period_str ? atoi(period_str) : PROFILE_DEFAULT_PERIOD;
+    if (period < 1) {
+        period = 1;
+    }
+
+    const int nworkers = hclib_num_workers();
+    workers = calloc(nworkers, sizeof(profile_worker_t));
+    HASSERT(workers);
+    for (int w = 0; w < nworkers; w++) {
+        workers[w].random = 0x9E3779B97F4A7C15ULL * (w + 1);
+        hclib_context->workers[w]->profile_countdown =
+            next_countdown(&workers[w]);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_report;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(PROFILE_SIGNAL, &action, &previous_action);
+}
+
+void hclib_profile_cleanup() {
+    if (!hclib_profile_enabled) {
+        return;
+    }
+    sigaction(PROFILE_SIGNAL, &previous_action, NULL);
+    for (int w = 0; w < hclib_num_workers(); w++) {
+        free(workers[w].pending);
+    }
+    free(workers);
+    workers = NULL;
+    hclib_profile_enabled = 0;
+}
+
+int hclib_profile_name_task(hclib_task_name_t *entry, const char *type) {
+    entry->type = type;
+    do {
+        entry->next = _hclib_atomic_load_ptr_acquire(&names);
+    } while (!_hclib_atomic_cas_ptr_acq_rel(&names, entry->next, entry));
+    return 0;
+}
+
+static inline void lock_pending(profile_worker_t *pw) {
+    while (!_hclib_atomic_cas_acq_rel(&pw->lock, 0, 1)) { }
+}
+
+static inline void unlock_pending(profile_worker_t *pw) {
+    _hclib_atomic_store_release(&pw->lock, 0);
+}
+
+static inline size_t pending_slot(const profile_worker_t *pw,
+        hclib_task_t *task) {
+    return (((uintptr_t) task * 0x9E3779B97F4A7C15ULL) >> 32) &
+        (pw->capacity - 1);
+}
+
+// Called with the worker locked.
+static void add_pending(profile_worker_t *pw, hclib_task_t *task,
+        uint64_t ready_at) {
+    size_t i = pending_slot(pw, task);
+    while (pw->pending[i].task) {
+        i = (i + 1) & (pw->capacity - 1);
+    }
+    pw->pending[i].task = task;
+    pw->pending[i].ready_at = ready_at;
+    pw->npending++;
+}
+
+static void grow_pending(profile_worker_t *pw) {
+    profile_pending_t *old = pw->pending;
+    const size_t old_capacity = pw->capacity;
+    pw->capacity = old_capacity ? 2 * old_capacity : PROFILE_MIN_PENDING;
+    pw->pending = calloc(pw->capacity, sizeof(profile_pending_t));
+    HASSERT(pw->pending);
+    pw->npending = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].task) {
+            add_pending(pw, old[i].task, old[i].ready_at);
+        }
+    }
+    free(old);
+}
+
+void hclib_profile_sample(hclib_worker_state *ws, hclib_task_t *task) {
+    profile_worker_t *pw = &workers[ws->id];
+    ws->profile_countdown = next_countdown(pw);
+    if (report_requested) {
+        report_requested = 0;
+        hclib_profile_report();
+    }
+
+    lock_pending(pw);
+    if (4 * (pw->npending + 1) > 3 * pw->capacity) {
+        grow_pending(pw);
+    }
+    add_pending(pw, task, hclib_profile_now());
+    unlock_pending(pw);
+}
+
+static int claim_pending(profile_worker_t *pw, hclib_task_t *task,
+        uint64_t *ready_at) {
+    lock_pending(pw);
+    if (pw->npending == 0) {
+        unlock_pending(pw);
+        return 0;
+    }
+    const size_t mask = pw->capacity - 1;
+    size_t i = pending_slot(pw, task);
+    while (pw->pending[i].task && pw->pending[i].task != task) {
+        i = (i + 1) & mask;
+    }
+    const int found = (pw->pending[i].task != NULL);
+    if (found) {
+        *ready_at = pw->pending[i].ready_at;
+        pw->npending--;
+        // move back the entries after it that would no longer be found
+        for (size_t j = (i + 1) & mask; pw->pending[j].task;
+                j = (j + 1) & mask) {
+            const size_t home = pending_slot(pw, pw->pending[j].task);
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                pw->pending[i] = pw->pending[j];
+                i = j;
+            }
+        }
+        pw->pending[i].task = NULL;
+    }
+    unlock_pending(pw);
+    return found;
+}
+
+int hclib_profile_claim(hclib_worker_state *ws, hclib_task_t *task,
+        uint64_t *ready_at) {
+    // most sampled tasks run on the worker that made them ready
+    if (claim_pending(&workers[ws->id], task, ready_at)) {
+        return ws->id;
+    }
+    const int nworkers = hclib_num_workers();
+    for (int w = 0; w < nworkers; w++) {
+        if (w != ws->id && claim_pending(&workers[w], task, ready_at)) {
+            return w;
+        }
+    }
+    return -1;
+}
+
+void hclib_profile_record(hclib_worker_state *ws,
+        const hclib_profile_sample_t *sample, uint64_t end) {
+    profile_entry_t *entries = workers[ws->id].entries;
+    profile_entry_t *entry = &entries[PROFILE_MAX_FUNCTIONS];
+    size_t i = ((uintptr_t) sample->fn >> 4) % PROFILE_MAX_FUNCTIONS;
+    for (int n = 0; n < PROFILE_MAX_FUNCTIONS; n++) {
+        if (entries[i].samples == 0 || entries[i].fn == sample->fn) {
+            entry = &entries[i];
+            entry->fn = sample->fn;
+            break;
+        }
+        i = (i + 1) % PROFILE_MAX_FUNCTIONS;
+    }
+    entry->samples++;
+    entry->stolen += sample->stolen;
+    entry->run_ns += end - sample->start - sample->excluded;
+    entry->queued_ns += sample->queued;
+}
+
+static void print_function(FILE *f, void *fn) {
+    if (fn == NULL) {
+        fprintf(f, "(other functions)");
+        return;
+    }
+    for (hclib_task_name_t *name = _hclib_atomic_load_ptr_acquire(&names);
+            name; name = name->next) {
+        if ((void *) name->fn == fn) {
+            char *demangled = hclib_demangle(name->type);
+            fprintf(f, "%s", demangled ? demangled : name->type);
+            free(demangled);
+            return;
+        }
+    }
+
+    Dl_info info;
+    if (dladdr(fn, &info) && info.dli_sname && info.dli_saddr == fn) {
+        char *demangled = strncmp(info.dli_sname, "_Z", 2) == 0 ?
+            hclib_demangle(info.dli_sname) : NULL;
+        fprintf(f, "%s", demangled ? demangled : info.dli_sname);
+        free(demangled);
+    } else if (dladdr(fn, &info) && info.dli_fname) {
+        // for addr2line
+        fprintf(f, "%s+0x%lx", info.dli_fname,
+                (unsigned long) ((char *) fn - (char *) info.dli_fbase));
+    } else {
+        fprintf(f, "%p", fn);
+    }
+}
+
+static int compare_entries_by_time(const void *a, const void *b) {
+    const uint64_t time_a = ((const profile_entry_t *) a)->run_ns;
+    const uint64_t time_b = ((const profile_entry_t *) b)->run_ns;
+    return time_a < time_b ? 1 : (time_a > time_b ? -1 : 0);
+}
+
+void hclib_profile_report() {
+    const int nworkers = hclib_num_workers();
+    const size_t max_entries = (size_t) nworkers * (PROFILE_MAX_FUNCTIONS + 1);
+    profile_entry_t *merged = calloc(max_entries, sizeof(profile_entry_t));
+    HASSERT(merged);
+    int nmerged = 0;
+    uint64_t samples = 0;
+    for (int w = 0; w < nworkers; w++) {
+        for (int i = 0; i <= PROFILE_MAX_FUNCTIONS; i++) {
+            const profile_entry_t *entry = &workers[w].entries[i];
+            if (entry->samples == 0) {
+                continue;
+            }
+            int j = 0;
+            while (j < nmerged && merged[j].fn != entry->fn) {
+                j++;
+            }
+            if (j == nmerged) {
+                merged[nmerged++].fn = entry->fn;
+            }
+            merged[j].samples += entry->samples;
+            merged[j].stolen += entry->stolen;
+            merged[j].run_ns += entry->run_ns;
+            merged[j].queued_ns += entry->queued_ns;
+            samples += entry->samples;
+        }
+    }
+    qsort(merged, nmerged, sizeof(profile_entry_t), compare_entries_by_time);
+
+    FILE *f = stderr;
+    fprintf(f, "================================ Task Profile "
+            "================================\n");
+    fprintf(f, "%" PRIu64 " tasks sampled, one in %d on average\n", samples,
+            period);
+    fprintf(f, "%12s %12s %12s %12s %7s  %s\n", "tasks", "time (ms)",
+            "mean (us)", "queued (us)", "stolen", "function");
+    for (int i = 0; i < nmerged; i++) {
+        const profile_entry_t *entry = &merged[i];
+        fprintf(f, "%12" PRIu64 " %12.3f %12.3f %12.3f %6.1f%%  ",
+                entry->samples * period, entry->run_ns * period / 1e6,
+                entry->run_ns / 1e3 / entry->samples,
+                entry->queued_ns / 1e3 / entry->samples,
+                100.0 * entry->stolen / entry->samples);
+        print_function(f, entry->fn);
+        fprintf(f, "\n");
+    }
+    fprintf(f, "------------------------------ End Task Profile "
+            "-------------------------------\n");
+    free(merged);
+}
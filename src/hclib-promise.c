@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "hclib-internal.h"
 #include "hclib-task.h"
@@ -24,10 +26,17 @@
 
 // Index value indicating that all dependencies are ready
 #define FUTURE_FRONTIER_EMPTY (-1)
+#define PROMISE_PUT_BATCH_SIZE 64
 
-static inline hclib_task_t **_next_waiting_task(hclib_task_t *t) {
-    HASSERT(t && t->future_list);
-    return &t->next_waiter;
+#define WAITER_FIELD_MATCHES(field) \
+    (offsetof(hclib_task_t, field) == offsetof(hclib_waiter_t, field))
+HASSERT_STATIC(WAITER_FIELD_MATCHES(next_waiter) &&
+        WAITER_FIELD_MATCHES(future_list) && WAITER_FIELD_MATCHES(_fp) &&
+        WAITER_FIELD_MATCHES(args), "tasks must start like hclib_waiter_t");
+
+static inline hclib_waiter_t **_next_waiter(hclib_waiter_t *w) {
+    HASSERT(w);
+    return &w->next_waiter;
 }
 
 /**
@@ -38,6 +47,12 @@ void hclib_promise_init(hclib_promise_t *promise) {
     promise->datum = UNINITIALIZED_PROMISE_DATA_PTR;
     promise->wait_list_head = SENTINEL_FUTURE_WAITLIST_PTR;
     promise->future.owner = promise;
+    promise->refcount = 1;
+    promise->destructor = NULL;
+    if (hclib_workspan_enabled) {
+        // of a promise that was at the same address
+        hclib_workspan_forget(promise);
+    }
 }
 
 /**
@@ -47,6 +62,7 @@ hclib_promise_t *hclib_promise_create() {
     hclib_promise_t *promise = (hclib_promise_t *) malloc(sizeof(hclib_promise_t));
     HASSERT(promise);
     hclib_promise_init(promise);
+    promise->destructor = hclib_promise_free;
     return promise;
 }
 
@@ -79,6 +95,10 @@ hclib_promise_t **hclib_promise_create_n(size_t nb_promises,
  * Get datum from a promise.
  * Note: this is concurrent with the 'put' operation.
  */
+int hclib_future_is_satisfied(hclib_future_t *future) {
+    return _hclib_promise_is_satisfied(future->owner);
+}
+
 void *hclib_future_get(hclib_future_t *future) {
     HASSERT(_hclib_promise_is_satisfied(future->owner));
     return future->owner->datum;
@@ -108,30 +128,46 @@ void hclib_promise_free(hclib_promise_t *promise) {
     free(promise);
 }
 
-/** Returns '1' if the task was registered and is now waiting */
+void hclib_promise_retain(hclib_promise_t *promise) {
+    _hclib_atomic_inc_relaxed((_Atomic int *) &promise->refcount);
+}
+
+void hclib_promise_release(hclib_promise_t *promise) {
+    if (_hclib_atomic_dec_acq_rel((_Atomic int *) &promise->refcount) == 0 &&
+            promise->destructor) {
+        promise->destructor(promise);
+    }
+}
+
+void hclib_future_release(hclib_future_t *future) {
+    hclib_promise_release(future->owner);
+}
+
+/** Returns '1' if the waiter was registered and is now waiting */
 static inline int _register_if_promise_not_ready(
-    hclib_task_t *task,
+    hclib_waiter_t *waiter,
     hclib_future_t *future_to_check) {
-    HASSERT(task != SENTINEL_FUTURE_WAITLIST_PTR);
+    HASSERT(waiter != SENTINEL_FUTURE_WAITLIST_PTR);
     int success = 0;
-    hclib_promise_t *p = future_to_check->owner;
-    hclib_task_t *current_head = p->wait_list_head;
+    void * _Atomic *wait_list = _hclib_promise_wait_list(
+            future_to_check->owner);
+    hclib_waiter_t *current_head = _hclib_atomic_load_ptr_acquire(wait_list);
 
     if (current_head != SATISFIED_FUTURE_WAITLIST_PTR) {
 
         while (current_head != SATISFIED_FUTURE_WAITLIST_PTR && !success) {
             // current_head can not be SATISFIED_FUTURE_WAITLIST_PTR in here
-            *_next_waiting_task(task) = current_head;
+            *_next_waiter(waiter) = current_head;
 
-            success = __sync_bool_compare_and_swap(
-                    &p->wait_list_head, current_head, task);
+            success = _hclib_atomic_cas_ptr_acq_rel(wait_list, current_head,
+                    waiter);
 
             /*
              * may have failed because either some other task tried to be the
              * head or a put occurred.
              */
             if (!success) {
-                current_head = p->wait_list_head;
+                current_head = _hclib_atomic_load_ptr_acquire(wait_list);
                 /*
                  * if current_head was set to SATISFIED_FUTURE_WAITLIST_PTR,
                  * the loop condition will handle that if another task was
@@ -154,7 +190,10 @@ int register_on_all_promise_dependencies(hclib_task_t *task) {
     if (i == FUTURE_FRONTIER_EMPTY) { return true; }
 
     while ((next_future = task->future_list[i++])) { // this is an assignment
-        if (_register_if_promise_not_ready(task, next_future)) {
+        HASSERT(next_future->owner != &hclib_graph_handle_owner &&
+                "handles of recorded tasks only order tasks of their graph");
+        if (_register_if_promise_not_ready((hclib_waiter_t *) task,
+                    next_future)) {
             task->future_frontier = i;
             return false;
         }
@@ -177,34 +216,171 @@ void hclib_promise_put(hclib_promise_t *promiseToBePut, void *datumToBePut) {
              !_hclib_promise_is_satisfied(promiseToBePut) &&
              "violated single assignment property for promises");
 
-    hclib_task_t *current_list_head;
-
     promiseToBePut->datum = datumToBePut;
+    if (hclib_workspan_enabled) {
+        hclib_workspan_put(promiseToBePut);
+    }
 
-    do {
-        current_list_head = promiseToBePut->wait_list_head;
-    /*seems like I can not avoid a CAS here*/
-    // FIXME - should be able ot use __atomic_exchange builtin here
-    } while (!__sync_bool_compare_and_swap(&(promiseToBePut->wait_list_head),
-                current_list_head, SATISFIED_FUTURE_WAITLIST_PTR));
+    // publishes the datum, and closes the wait list to new registrations
+    hclib_waiter_t *curr = _hclib_atomic_exchange_ptr_acq_rel(
+            _hclib_promise_wait_list(promiseToBePut),
+            SATISFIED_FUTURE_WAITLIST_PTR);
 
-    hclib_task_t *curr_task = current_list_head;
-    hclib_task_t *next_task = NULL;
+    /*
+     * Tasks made ready by this put are scheduled in batches, rather than one
+     * deque push at a time.
+     */
+    hclib_task_t *ready[PROMISE_PUT_BATCH_SIZE];
+    int nready = 0;
     int iter_count = 0;
-    while (curr_task != SENTINEL_FUTURE_WAITLIST_PTR) {
+    while (curr != SENTINEL_FUTURE_WAITLIST_PTR) {
 
-        next_task = *_next_waiting_task(curr_task);
-        if (register_on_all_promise_dependencies(curr_task)) {
-            /*deque_push_default(currFrame);*/
+        hclib_waiter_t *next = *_next_waiter(curr);
+        // waiters are scattered in memory: fetch the next one meanwhile
+        __builtin_prefetch(next);
+        hclib_task_t *curr_task = (hclib_task_t *) curr;
+        if (curr->future_list == NULL) {
+            // trigger registered with hclib_future_add_trigger
+            (curr->_fp)(curr->args);
+        } else if (register_on_all_promise_dependencies(curr_task)) {
             // task eligible to scheduling
             if (DEBUG_PROMISE) {
                 printf("promise: async_task %p at %d\n", curr_task, iter_count);
             }
-            try_schedule_async(curr_task, CURRENT_WS_INTERNAL);
+            ready[nready++] = curr_task;
+            if (nready == PROMISE_PUT_BATCH_SIZE) {
+                schedule_ready_tasks(ready, nready);
+                nready = 0;
+            }
         }
-        curr_task = next_task;
+        curr = next;
         iter_count++;
     }
+
+    if (nready > 0) {
+        schedule_ready_tasks(ready, nready);
+    }
+}
+
+void hclib_future_add_trigger(hclib_future_t *future, hclib_waiter_t *trigger) {
+    HASSERT(trigger->future_list == NULL);
+    if (!_register_if_promise_not_ready(trigger, future)) {
+        (trigger->_fp)(trigger->args);
+    }
 }
 
+/*
+ * Combined future of hclib_when_all and hclib_when_any, along with the
+ * triggers registered on each of their inputs, in a single allocation. The
+ * triggers share a reference on the promise until the last of them is called.
+ *
+ * when_all triggers are bare waiters, whose argument is the countdown itself,
+ * so that an input costs no more than its wait list entry. when_any triggers
+ * also point back to the countdown, to tell which input came first.
+ */
+typedef struct hclib_countdown_t {
+    hclib_promise_t promise;
+    _Atomic int remaining;
+    _Atomic int claimed; // when_any: set by the first input to be satisfied
+    int nfutures;
+    // copy of the inputs while profiling work and span, NULL otherwise
+    hclib_future_t **inputs;
+} hclib_countdown_t;
 
+typedef struct {
+    hclib_waiter_t waiter;
+    hclib_countdown_t *countdown;
+} hclib_any_trigger_t;
+
+static inline void countdown_check_out(hclib_countdown_t *countdown) {
+    if (_hclib_atomic_dec_acq_rel(&countdown->remaining) == 0) {
+        hclib_promise_release(&countdown->promise);
+    }
+}
+
+static void when_all_trigger(void *arg) {
+    hclib_countdown_t *countdown = (hclib_countdown_t *) arg;
+    if (_hclib_atomic_dec_acq_rel(&countdown->remaining) == 0) {
+        if (countdown->inputs) {
+            for (int i = 0; i < countdown->nfutures; i++) {
+                hclib_workspan_gather(&countdown->promise,
+                        countdown->inputs[i]->owner);
+            }
+        }
+        hclib_promise_put(&countdown->promise, NULL);
+        hclib_promise_release(&countdown->promise);
+    }
+}
+
+static void when_any_trigger(void *arg) {
+    hclib_any_trigger_t *trigger = (hclib_any_trigger_t *) arg;
+    hclib_countdown_t *countdown = trigger->countdown;
+
+    if (_hclib_atomic_cas_acq_rel(&countdown->claimed, 0, 1)) {
+        const intptr_t index = trigger - (hclib_any_trigger_t *) (countdown + 1);
+        if (countdown->inputs) {
+            hclib_workspan_gather(&countdown->promise,
+                    countdown->inputs[index]->owner);
+        }
+        hclib_promise_put(&countdown->promise, (void *) index);
+    }
+    countdown_check_out(countdown);
+}
+
+static hclib_future_t *when_internal(hclib_future_t **futures, int nfutures,
+        int any) {
+    HASSERT(nfutures >= 0);
+    const size_t trigger_size = any ? sizeof(hclib_any_trigger_t) :
+        sizeof(hclib_waiter_t);
+    const size_t inputs_size = hclib_workspan_enabled ?
+        nfutures * sizeof(hclib_future_t *) : 0;
+    hclib_countdown_t *countdown = (hclib_countdown_t *) malloc(
+            sizeof(hclib_countdown_t) + nfutures * trigger_size + inputs_size);
+    HASSERT(countdown);
+    hclib_promise_init(&countdown->promise);
+    countdown->promise.destructor = hclib_promise_free;
+
+    if (nfutures == 0) {
+        hclib_promise_put(&countdown->promise, NULL);
+        return &countdown->promise.future;
+    }
+
+    hclib_promise_retain(&countdown->promise); // for the triggers
+    _hclib_atomic_store_relaxed(&countdown->remaining, nfutures);
+    _hclib_atomic_store_relaxed(&countdown->claimed, 0);
+    countdown->nfutures = nfutures;
+    countdown->inputs = NULL;
+    if (inputs_size) {
+        countdown->inputs = (hclib_future_t **) ((char *) (countdown + 1) +
+                nfutures * trigger_size);
+        memcpy(countdown->inputs, futures, inputs_size);
+    }
+
+    hclib_waiter_t *all = (hclib_waiter_t *) (countdown + 1);
+    hclib_any_trigger_t *any_triggers = (hclib_any_trigger_t *) all;
+    for (int i = 0; i < nfutures; i++) {
+        hclib_waiter_t *waiter = any ? &any_triggers[i].waiter : &all[i];
+        waiter->future_list = NULL;
+        if (any) {
+            waiter->_fp = when_any_trigger;
+            waiter->args = &any_triggers[i];
+            any_triggers[i].countdown = countdown;
+        } else {
+            waiter->_fp = when_all_trigger;
+            waiter->args = countdown;
+        }
+        // may fire right away, the countdown being set up already
+        if (!_register_if_promise_not_ready(waiter, futures[i])) {
+            (waiter->_fp)(waiter->args);
+        }
+    }
+    return &countdown->promise.future;
+}
+
+hclib_future_t *hclib_when_all(hclib_future_t **futures, int nfutures) {
+    return when_internal(futures, nfutures, 0);
+}
+
+hclib_future_t *hclib_when_any(hclib_future_t **futures, int nfutures) {
+    return when_internal(futures, nfutures, 1);
+}
@@ -53,7 +53,6 @@ void log_(const char *file, int line, hclib_worker_state *ws,
 }
 
 // Statistics
-int total_push_outd;
 int *total_push_ind;
 int *total_steals;
 
@@ -116,12 +115,14 @@ void hclib_global_init() {
         hclib_worker_state *ws = hclib_context->workers[i];
         ws->context = hclib_context;
         ws->current_finish = NULL;
+        ws->current_phasers = NULL;
+        ws->capture = NULL;
         ws->curr_ctx = NULL;
         ws->root_ctx = NULL;
+        ws->profile_sample = NULL;
     }
     hclib_context->done_flags = (worker_done_t *)malloc(
                                     hclib_context->nworkers * sizeof(worker_done_t));
-    total_push_outd = 0;
     total_steals = (int *)malloc(hclib_context->nworkers * sizeof(int));
     HASSERT(total_steals);
     total_push_ind = (int *)malloc(hclib_context->nworkers * sizeof(int));
@@ -135,6 +136,12 @@ void hclib_global_init() {
     // Sets up the deques and worker contexts for the parsed HPT
     hc_hpt_init(hclib_context);
 
+    hclib_io_init();
+    hclib_timer_wheel_init();
+    hclib_scratch_init();
+    hclib_workspan_init();
+    hclib_profile_init();
+
 }
 
 void hclib_display_runtime() {
@@ -217,6 +224,10 @@ void hclib_join(int nb_workers) {
 }
 
 void hclib_cleanup() {
+    hclib_io_cleanup();
+    hclib_scratch_cleanup();
+    hclib_workspan_cleanup();
+    hclib_profile_cleanup();
     hc_hpt_cleanup(hclib_context); /* cleanup deques (allocated by hc mm) */
     pthread_key_delete(ws_key);
 
@@ -234,30 +245,156 @@ static inline void check_in_finish(finish_t *finish) {
 
 static inline void check_out_finish(finish_t *finish) {
     if (finish) {
+        // accumulator lanes written by other tasks must be visible when combined
+        const int remaining = finish->accums ?
+            _hclib_atomic_dec_acq_rel(&finish->counter) :
+            _hclib_atomic_dec_release(&finish->counter);
         // was this the last async to check out?
-        if (_hclib_atomic_dec_release(&finish->counter) == 0) {
+        if (remaining == 0) {
+            if (finish->accums) {
+                hclib_accum_combine_all(finish);
+            }
+            if (_hclib_atomic_load_ptr_acquire(&finish->scratch)) {
+                // the tasks that wrote to the scratch memory are done with it
+                _hclib_atomic_fence_acquire();
+                hclib_scratch_release(finish);
+            }
 #if HCLIB_LITECTX_STRATEGY
-            HASSERT(!_hclib_promise_is_satisfied(finish->finish_deps[0]->owner));
-            hclib_promise_put(finish->finish_deps[0]->owner, finish);
+            hclib_promise_t *finish_promise = finish->finish_deps[0]->owner;
+            HASSERT(!_hclib_promise_is_satisfied(finish_promise));
+            if (finish->workspan) {
+                hclib_workspan_check_out(finish, finish_promise);
+            }
+            hclib_promise_put(finish_promise, finish);
+            // drop the reference taken when setting up finish_deps
+            hclib_promise_release(finish_promise);
 #endif /* HCLIB_LITECTX_STRATEGY */
         }
     }
 }
 
+void hclib_check_out_finish(finish_t *finish) {
+    check_out_finish(finish);
+}
+
+/*
+ * Sample one task in about HCLIB_PROFILE_PERIOD made ready on this worker, see
+ * hclib-profile.h.
+ */
+static inline void profile_ready(hclib_task_t *task, hclib_worker_state *ws) {
+    if (--ws->profile_countdown <= 0) {
+        hclib_profile_sample(ws, task);
+        task->property |= SAMPLED_TASK;
+    }
+}
+
+// Returns the sample of the task this one runs nested in, if any.
+static inline hclib_profile_sample_t *profile_begin(hclib_task_t *task,
+        hclib_worker_state *ws, hclib_profile_sample_t *sample) {
+    hclib_profile_sample_t *caller = ws->profile_sample;
+    if (task->property & SAMPLED_TASK) {
+        uint64_t ready_at;
+        const int sampled_by = hclib_profile_claim(ws, task, &ready_at);
+        HASSERT(sampled_by >= 0);
+        sample->fn = hclib_task_function(task);
+        sample->start = hclib_profile_now();
+        sample->queued = sample->start - ready_at;
+        sample->stolen = (ws->id != sampled_by);
+        sample->excluded = 0;
+        ws->profile_sample = sample;
+    } else if (caller) {
+        // only to be excluded from the time of the caller
+        sample->start = hclib_profile_now();
+        ws->profile_sample = NULL;
+    }
+    return caller;
+}
+
+static inline void profile_end(hclib_task_t *task, hclib_worker_state *ws,
+        hclib_profile_sample_t *sample, hclib_profile_sample_t *caller) {
+    const int sampled = (task->property & SAMPLED_TASK);
+    if (sampled || caller) {
+        const uint64_t end = hclib_profile_now();
+        if (sampled) {
+            hclib_profile_record(ws, sample, end);
+            task->property &= ~SAMPLED_TASK;
+        }
+        if (caller) {
+            caller->excluded += end - sample->start;
+        }
+    }
+    ws->profile_sample = caller;
+}
+
+/*
+ * The task running on this worker blocks, the time until it resumes is not
+ * counted.
+ */
+static inline hclib_profile_sample_t *profile_suspend(hclib_worker_state *ws) {
+    hclib_profile_sample_t *sample = ws->profile_sample;
+    if (sample) {
+        sample->suspended_at = hclib_profile_now();
+        ws->profile_sample = NULL;
+    }
+    return sample;
+}
+
+static inline void profile_resume(hclib_worker_state *ws,
+        hclib_profile_sample_t *sample) {
+    if (sample) {
+        sample->excluded += hclib_profile_now() - sample->suspended_at;
+    }
+    ws->profile_sample = sample;
+}
+
 static inline void execute_task(hclib_task_t *task) {
     finish_t *current_finish = task->current_finish;
+    // may be gone once checked out of its finish otherwise
+    const int persistent = task->property & PERSISTENT_TASK;
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    // registrations of the task this one runs nested in, if any
+    struct hclib_phaser_reg_t *caller_phasers = ws->current_phasers;
     /*
      * Update the current finish of this worker to be inherited from the
      * currently executing task so that any asyncs spawned from the currently
      * executing task are registered on the same finish.
      */
-    CURRENT_WS_INTERNAL->current_finish = current_finish;
-
-    // task->_fp is of type 'void (*generic_frame_ptr)(void*)'
-    LOG_DEBUG("execute_task: task=%p fp=%p\n", task, task->_fp);
-    (task->_fp)(task->args);
+    ws->current_finish = current_finish;
+    ws->current_phasers = task->phasers;
+    hclib_workspan_t *caller_workspan = hclib_workspan_enabled ?
+        hclib_workspan_begin_task(task) : NULL;
+    hclib_profile_sample_t sample;
+    hclib_profile_sample_t *caller_sample = hclib_profile_enabled ?
+        profile_begin(task, ws, &sample) : NULL;
+
+    // tasks of a cancelled finish are dropped, but still checked out
+    if (persistent || (task->property & UNCANCELLABLE_ASYNC) ||
+            current_finish == NULL ||
+            !_hclib_cancel_token_is_cancelled(current_finish->cancel)) {
+        // task->_fp is of type 'void (*generic_frame_ptr)(void*)'
+        LOG_DEBUG("execute_task: task=%p fp=%p\n", task, task->_fp);
+        (task->_fp)(task->args);
+    }
+    ws = CURRENT_WS_INTERNAL; // may have been swapped
+    hclib_phaser_drop_all(ws->current_phasers);
+    ws->current_phasers = caller_phasers;
+    if (hclib_profile_enabled) {
+        profile_end(task, ws, &sample, caller_sample);
+    }
+    if (hclib_workspan_enabled) {
+        hclib_workspan_end_task(task, caller_workspan);
+    }
     check_out_finish(current_finish);
-    free(task);
+    if (!persistent) {
+        free(task);
+    }
+}
+
+// The deque of this worker is full, so the task runs in place
+static void execute_task_unpushed(hclib_task_t *task) {
+    // TODO: grow the deque instead
+    printf("WARNING: deque full, local execution\n");
+    execute_task(task);
 }
 
 static inline void rt_schedule_async(hclib_task_t *async_task,
@@ -274,9 +411,7 @@ static inline void rt_schedule_async(hclib_task_t *async_task,
                 "hclib_context=%p\n", wid, hclib_context);
         if (!deque_push(&(hclib_context->workers[wid]->current->deque),
                         async_task)) {
-            // TODO: deque is full, so execute in place
-            printf("WARNING: deque full, local execution\n");
-            execute_task(async_task);
+            execute_task_unpushed(async_task);
         }
         LOG_DEBUG("rt_schedule_async: finished scheduling on worker wid=%d\n",
                 wid);
@@ -301,6 +436,24 @@ static inline int is_eligible_to_schedule(hclib_task_t *async_task) {
     }
 }
 
+/*
+ * Run an INLINE_ASYNC task in place, within the spawn or promise put that made
+ * it eligible, then go back to the finish scope of the caller. The task may
+ * block and resume on another worker, whose state is restored instead (the
+ * inline depth travels with the blocked context, see help_finish and
+ * hclib_future_wait).
+ */
+static inline void execute_task_inline(hclib_task_t *async_task,
+                                       hclib_worker_state *ws) {
+    finish_t *caller_finish = ws->current_finish;
+    const int caller_depth = ws->inline_depth;
+    ws->inline_depth = caller_depth + 1;
+    execute_task(async_task);
+    ws = CURRENT_WS_INTERNAL; // may have been swapped
+    ws->inline_depth = caller_depth;
+    ws->current_finish = caller_finish;
+}
+
 /*
  * If this async is eligible for scheduling, we insert it into the work-stealing
  * runtime. See is_eligible_to_schedule to understand when a task is or isn't
@@ -308,8 +461,106 @@ static inline int is_eligible_to_schedule(hclib_task_t *async_task) {
  */
 void try_schedule_async(hclib_task_t *async_task, hclib_worker_state *ws) {
     if (is_eligible_to_schedule(async_task)) {
-        rt_schedule_async(async_task, ws);
+        if (hclib_profile_enabled) {
+            profile_ready(async_task, ws);
+        }
+        if ((async_task->property & INLINE_ASYNC) &&
+                ws->inline_depth < HCLIB_MAX_INLINE_DEPTH) {
+            execute_task_inline(async_task, ws);
+        } else {
+            rt_schedule_async(async_task, ws);
+        }
+    }
+}
+
+/*
+ * Schedule tasks whose futures are all satisfied, pushing those that go to the
+ * current deque of this worker at once.
+ */
+void schedule_ready_tasks(hclib_task_t **tasks, int ntasks) {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    // move the tasks to push to the front, INLINE_ASYNC ones stay behind
+    int npush = 0;
+    for (int i = 0; i < ntasks; i++) {
+        hclib_task_t *task = tasks[i];
+        if (hclib_profile_enabled) {
+            profile_ready(task, ws);
+        }
+        if (task->place) {
+            deque_push_place(ws, task->place, task);
+            tasks[i] = NULL;
+        } else if (!(task->property & INLINE_ASYNC)) {
+            tasks[i] = tasks[npush];
+            tasks[npush++] = task;
+        }
     }
+
+    int pushed = deque_push_n(&ws->current->deque, tasks, npush);
+    for (int i = pushed; i < npush; i++) {
+        execute_task_unpushed(tasks[i]);
+    }
+
+    for (int i = npush; i < ntasks; i++) {
+        if (tasks[i] == NULL) {
+            continue;
+        }
+        // any task run so far may have blocked, and resumed on another worker
+        ws = CURRENT_WS_INTERNAL;
+        if (ws->inline_depth < HCLIB_MAX_INLINE_DEPTH) {
+            execute_task_inline(tasks[i], ws);
+        } else {
+            rt_schedule_async(tasks[i], ws);
+        }
+    }
+}
+
+/*
+ * Trigger of a continuation (see hclib_future_then_inline), run like an
+ * INLINE_ASYNC task, within the finish scope it was created in.
+ */
+static void continuation_trigger(void *arg) {
+    hclib_continuation_t *continuation = (hclib_continuation_t *) arg;
+    finish_t *finish = continuation->finish; // fp may free the continuation
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    if (ws->inline_depth >= HCLIB_MAX_INLINE_DEPTH) {
+        hclib_task_t *task = malloc(sizeof(*task));
+        HASSERT(task);
+        *task = (hclib_task_t){
+            ._fp = continuation->fp,
+            .args = continuation->arg,
+            .current_finish = finish, // already checked in
+            .property = UNCANCELLABLE_ASYNC,
+        };
+        try_schedule_async(task, ws);
+        return;
+    }
+
+    finish_t *caller_finish = ws->current_finish;
+    struct hclib_phaser_reg_t *caller_phasers = ws->current_phasers;
+    const int caller_depth = ws->inline_depth;
+    ws->current_finish = finish;
+    ws->current_phasers = NULL;
+    ws->inline_depth = caller_depth + 1;
+    (continuation->fp)(continuation->arg);
+    ws = CURRENT_WS_INTERNAL; // may have been swapped
+    ws->inline_depth = caller_depth;
+    ws->current_phasers = caller_phasers;
+    ws->current_finish = caller_finish;
+    check_out_finish(finish);
+}
+
+void hclib_future_then_inline(hclib_future_t *future,
+        hclib_continuation_t *continuation, asyncFct_t fp, void *arg) {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    continuation->trigger = (hclib_waiter_t){
+        ._fp = continuation_trigger,
+        .args = continuation,
+    };
+    continuation->fp = fp;
+    continuation->arg = arg;
+    continuation->finish = ws->current_finish;
+    check_in_finish(continuation->finish);
+    hclib_future_add_trigger(future, &continuation->trigger);
 }
 
 void spawn_handler(hclib_task_t *task, place_t *pl, bool escaping) {
@@ -328,6 +579,9 @@ void spawn_handler(hclib_task_t *task, place_t *pl, bool escaping) {
 
     LOG_DEBUG("spawn_handler: task=%p\n", task);
 
+    if (hclib_workspan_enabled) {
+        hclib_workspan_spawn(task);
+    }
     try_schedule_async(task, ws);
 }
 
@@ -337,8 +591,11 @@ void spawn_at_hpt(place_t *pl, hclib_task_t *task) {
     check_in_finish(ws->current_finish);
     task->current_finish = ws->current_finish;
     task->place = pl;
+    if (hclib_workspan_enabled) {
+        hclib_workspan_spawn(task);
+    }
     try_schedule_async(task, ws);
-#ifdef HC_COMM_WORKER_STATS
+#ifdef HC_WORKER_STATS
     const int wid = get_current_worker();
     increment_async_counter(wid);
 #endif
@@ -369,6 +626,21 @@ void spawn_await(hclib_task_t *task, hclib_future_t **future_list) {
     spawn_await_at(task, future_list, NULL);
 }
 
+/*
+ * Complete pending I/O and schedule expired timers, which may make tasks ready
+ * on this worker. Returns how many operations and timers that was.
+ */
+static inline int poll_events() {
+    int n = 0;
+    if (_hclib_atomic_load_relaxed(&hclib_io_pending) > 0) {
+        n += hclib_io_poll();
+    }
+    if (_hclib_atomic_load_relaxed(&hclib_timers_pending) > 0) {
+        n += hclib_timer_wheel_poll();
+    }
+    return n;
+}
+
 void find_and_run_task(hclib_worker_state *ws) {
     hclib_task_t *task = hpt_pop_task(ws);
     if (!task) {
@@ -376,11 +648,14 @@ void find_and_run_task(hclib_worker_state *ws) {
             // try to steal
             task = hpt_steal_task(ws);
             if (task) {
-#ifdef HC_COMM_WORKER_STATS
+#ifdef HC_WORKER_STATS
                 increment_steals_counter(ws->id);
 #endif
                 break;
             }
+            if (poll_events() > 0 && (task = hpt_pop_task(ws))) {
+                break;
+            }
         }
     }
 
@@ -498,12 +773,27 @@ void _help_wait(LiteCtx *ctx) {
 }
 
 void *hclib_future_wait(hclib_future_t *future) {
+    HASSERT(future->owner != &hclib_graph_handle_owner &&
+            "can not wait on the handle of a recorded task");
     if (_hclib_promise_is_satisfied(future->owner)) {
+        if (hclib_workspan_enabled) {
+            hclib_workspan_join(hclib_workspan_suspend(), future->owner);
+        }
         return future->owner->datum;
     }
 
     // save current finish scope (in case of worker swap)
     finish_t *current_finish = CURRENT_WS_INTERNAL->current_finish;
+    struct hclib_phaser_reg_t *current_phasers =
+        CURRENT_WS_INTERNAL->current_phasers;
+    // the work loop run meanwhile starts with no INLINE_ASYNC task in place
+    const int inline_depth = CURRENT_WS_INTERNAL->inline_depth;
+    CURRENT_WS_INTERNAL->inline_depth = 0;
+
+    hclib_workspan_t *workspan = hclib_workspan_enabled ?
+        hclib_workspan_suspend() : NULL;
+    hclib_profile_sample_t *sample = hclib_profile_enabled ?
+        profile_suspend(CURRENT_WS_INTERNAL) : NULL;
 
     hclib_future_t *continuation_deps[] = { future, NULL };
     LiteCtx *currentCtx = get_curr_lite_ctx();
@@ -513,8 +803,17 @@ void *hclib_future_wait(hclib_future_t *future) {
     ctx_swap(currentCtx, newCtx, __func__);
     LiteCtx_destroy(currentCtx->prev);
 
+    if (hclib_profile_enabled) {
+        profile_resume(CURRENT_WS_INTERNAL, sample);
+    }
+    if (hclib_workspan_enabled) {
+        hclib_workspan_join(workspan, future->owner);
+    }
+
     // restore current finish scope (in case of worker swap)
     CURRENT_WS_INTERNAL->current_finish = current_finish;
+    CURRENT_WS_INTERNAL->current_phasers = current_phasers;
+    CURRENT_WS_INTERNAL->inline_depth = inline_depth;
 
     HASSERT(_hclib_promise_is_satisfied(future->owner) &&
             "promise must be satisfied before returning from wait");
@@ -553,7 +852,7 @@ static void _help_finish_ctx(LiteCtx *ctx) {
 
 static inline void slave_worker_finishHelper_routine(finish_t *finish) {
     hclib_worker_state *ws = CURRENT_WS_INTERNAL;
-#ifdef HC_COMM_WORKER_STATS
+#ifdef HC_WORKER_STATS
     const int wid = ws->id;
 #endif
 
@@ -565,11 +864,14 @@ static inline void slave_worker_finishHelper_routine(finish_t *finish) {
                 // try to steal
                 task = hpt_steal_task(ws);
                 if (task) {
-#ifdef HC_COMM_WORKER_STATS
+#ifdef HC_WORKER_STATS
                     increment_steals_counter(wid);
 #endif
                     break;
                 }
+                if (poll_events() > 0 && (task = hpt_pop_task(ws))) {
+                    break;
+                }
             }
         }
         if (task) {
@@ -634,8 +936,13 @@ void help_finish(finish_t *finish) {
             // create finish event
             hclib_promise_t *finish_promise = hclib_promise_create();
             hclib_future_t *finish_deps[] = { &finish_promise->future, NULL };
+            hclib_promise_retain(finish_promise); // released once put
             finish->finish_deps = finish_deps;
 
+            // as in hclib_future_wait, this context may resume elsewhere
+            const int inline_depth = CURRENT_WS_INTERNAL->inline_depth;
+            CURRENT_WS_INTERNAL->inline_depth = 0;
+
             LiteCtx *currentCtx = get_curr_lite_ctx();
             HASSERT(currentCtx);
             LiteCtx *newCtx = LiteCtx_create(_help_finish_ctx);
@@ -643,13 +950,14 @@ void help_finish(finish_t *finish) {
 
             LOG_DEBUG("help_finish: newCtx = %p, newCtx->arg = %p\n", newCtx, newCtx->arg);
             ctx_swap(currentCtx, newCtx, __func__);
+            CURRENT_WS_INTERNAL->inline_depth = inline_depth;
 
             // note: the other context checks out of the current finish scope
 
             // destroy the context that resumed this one since it's now defunct
             // (there are no other handles to it, and it will never be resumed)
             LiteCtx_destroy(currentCtx->prev);
-            hclib_promise_free(finish_promise);
+            hclib_promise_release(finish_promise);
         } else {
             HASSERT(_hclib_atomic_load_relaxed(&finish->counter) == 1);
             // finish->counter == 1 implies that all the tasks are done
@@ -687,9 +995,16 @@ void hclib_start_finish() {
      * completed, or just the tasks launched so far.
      */
     finish->parent = ws->current_finish;
+    finish->accums = NULL;
+    finish->cancel = finish->parent ? finish->parent->cancel : NULL;
+    finish->scratch = NULL;
+    finish->workspan = NULL;
 #if HCLIB_LITECTX_STRATEGY
     finish->finish_deps = NULL;
 #endif
+    if (hclib_workspan_enabled) {
+        hclib_workspan_start_finish(finish, __builtin_return_address(0));
+    }
     check_in_finish(finish->parent); // check_in_finish performs NULL check
     ws->current_finish = finish;
     _hclib_atomic_store_release(&finish->counter, 1);
@@ -698,20 +1013,44 @@ void hclib_start_finish() {
 void hclib_end_finish() {
     finish_t *current_finish = CURRENT_WS_INTERNAL->current_finish;
 
+    // the tasks of this scope would otherwise wait on phasers created in it
+    hclib_phaser_drop_scope(current_finish);
+    struct hclib_phaser_reg_t *current_phasers =
+        CURRENT_WS_INTERNAL->current_phasers;
+
     HASSERT(_hclib_atomic_load_relaxed(&current_finish->counter) > 0);
+    hclib_workspan_t *workspan = hclib_workspan_enabled ?
+        hclib_workspan_suspend() : NULL;
+    hclib_profile_sample_t *sample = hclib_profile_enabled ?
+        profile_suspend(CURRENT_WS_INTERNAL) : NULL;
     help_finish(current_finish);
     HASSERT(_hclib_atomic_load_relaxed(&current_finish->counter) == 0);
+    if (hclib_profile_enabled) {
+        profile_resume(CURRENT_WS_INTERNAL, sample);
+    }
+    if (current_finish->workspan) {
+        hclib_workspan_end_finish(current_finish, workspan);
+    }
+    // unless the last task to check out already did it
+    if (current_finish->accums) {
+        hclib_accum_combine_all(current_finish);
+    }
+    if (current_finish->scratch) {
+        hclib_scratch_release(current_finish);
+    }
 
     check_out_finish(current_finish->parent); // NULL check in check_out_finish
 
     // Don't reuse worker-state! (we might not be on the same worker anymore)
     CURRENT_WS_INTERNAL->current_finish = current_finish->parent;
+    CURRENT_WS_INTERNAL->current_phasers = current_phasers;
     free(current_finish);
 }
 
 // Based on help_finish
 void hclib_end_finish_nonblocking_helper(hclib_promise_t *event) {
     finish_t *current_finish = CURRENT_WS_INTERNAL->current_finish;
+    hclib_phaser_drop_scope(current_finish);
 
     HASSERT(_hclib_atomic_load_relaxed(&current_finish->counter) > 0);
 
@@ -728,6 +1067,10 @@ void hclib_end_finish_nonblocking_helper(hclib_promise_t *event) {
     HASSERT(event->datum == NULL && UNINITIALIZED_PROMISE_DATA_PTR == NULL &&
             "ad-hoc null terminator must have value NULL");
     current_finish->finish_deps = finish_deps;
+    hclib_promise_retain(event); // released once put
+    if (current_finish->workspan) {
+        hclib_workspan_end_finish_nonblocking(current_finish);
+    }
 
     // Check out this "task" from the current finish
     check_out_finish(current_finish);
@@ -747,18 +1090,6 @@ int hclib_num_workers() {
     return hclib_context->nworkers;
 }
 
-void hclib_gather_comm_worker_stats(int *push_outd, int *push_ind,
-                                    int *steal_ind) {
-    int asyncPush=0, steals=0, asyncCommPush=total_push_outd;
-    for(int i=0; i<hclib_num_workers(); i++) {
-        asyncPush += total_push_ind[i];
-        steals += total_steals[i];
-    }
-    *push_outd = asyncCommPush;
-    *push_ind = asyncPush;
-    *steal_ind = steals;
-}
-
 static double mysecond() {
     struct timeval tv;
     gettimeofday(&tv, 0);
@@ -766,7 +1097,7 @@ static double mysecond() {
 }
 
 void runtime_statistics(double duration) {
-    int asyncPush=0, steals=0, asyncCommPush=total_push_outd;
+    int asyncPush=0, steals=0;
     for(int i=0; i<hclib_num_workers(); i++) {
         asyncPush += total_push_ind[i];
         steals += total_steals[i];
@@ -778,9 +1109,9 @@ void runtime_statistics(double duration) {
     double total_duration = user_specified_timer>0 ? user_specified_timer :
                             duration;
     printf("============================ MMTk Statistics Totals ============================\n");
-    printf("time.mu\ttotalPushOutDeq\ttotalPushInDeq\ttotalStealsInDeq\ttWork\ttOverhead\ttSearch\n");
-    printf("%.3f\t%d\t%d\t%d\t%.4f\t%.4f\t%.5f\n",total_duration,asyncCommPush,
-           asyncPush,steals,tWork,tOvh,tSearch);
+    printf("time.mu\ttotalPushInDeq\ttotalStealsInDeq\ttWork\ttOverhead\ttSearch\n");
+    printf("%.3f\t%d\t%d\t%.4f\t%.4f\t%.5f\n",total_duration,asyncPush,
+           steals,tWork,tOvh,tSearch);
     printf("Total time: %.3f ms\n",total_duration);
     printf("------------------------------ End MMTk Statistics -----------------------------\n");
     printf("===== TEST PASSED in %.3f msec =====\n",duration);
@@ -847,6 +1178,12 @@ static void hclib_finalize() {
     if (hclib_stats) {
         showStatsFooter();
     }
+    if (hclib_workspan_enabled) {
+        hclib_workspan_report();
+    }
+    if (hclib_profile_enabled) {
+        hclib_profile_report();
+    }
 
     hclib_join(hclib_context->nworkers);
     hclib_cleanup();
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hclib-internal.h"
+#include "hclib-scratch.h"
+
+#define SCRATCH_BLOCK_SIZE (1024 * 1024)
+// larger allocations get a block of their own, which is not kept
+#define SCRATCH_MAX_SHARED (SCRATCH_BLOCK_SIZE / 4)
+#define SCRATCH_ALIGN 16
+// free blocks kept by each worker
+#define SCRATCH_MAX_FREE 8
+
+typedef struct hclib_scratch_block_st {
+    struct hclib_scratch_block_st *next;
+    size_t size;
+    size_t used;
+    _Alignas(SCRATCH_ALIGN) char data[];
+} hclib_scratch_block_t;
+
+typedef struct {
+    hclib_scratch_block_t *blocks;
+    int nblocks;
+    // arenas of a released scope, cleared for the next one
+    hclib_scratch_block_t **arenas;
+    char pad[HCLIB_CACHE_LINE_SIZE];
+} scratch_free_list_t;
+
+static scratch_free_list_t *free_lists = NULL;
+
+void hclib_scratch_init() {
+    free_lists = calloc(hclib_num_workers(), sizeof(scratch_free_list_t));
+    HASSERT(free_lists);
+}
+
+void hclib_scratch_cleanup() {
+    for (int w = 0; w < hclib_num_workers(); w++) {
+        hclib_scratch_block_t *block = free_lists[w].blocks;
+        while (block) {
+            hclib_scratch_block_t *next = block->next;
+            free(block);
+            block = next;
+        }
+        free(free_lists[w].arenas);
+    }
+    free(free_lists);
+    free_lists = NULL;
+}
+
+static hclib_scratch_block_t *block_create(size_t size) {
+    hclib_scratch_block_t *block = malloc(sizeof(hclib_scratch_block_t) +
+            size);
+    HASSERT(block);
+    block->size = size;
+    return block;
+}
+
+/*
+ * Arenas of a finish scope, one chain of blocks per worker with the block
+ * being bumped first. Created by the first allocation.
+ */
+static hclib_scratch_block_t **scope_arenas(finish_t *finish,
+        scratch_free_list_t *free_list) {
+    hclib_scratch_block_t **arenas = _hclib_atomic_load_ptr_acquire(
+            &finish->scratch);
+    if (!arenas) {
+        hclib_scratch_block_t **created = free_list->arenas;
+        if (created) {
+            free_list->arenas = NULL;
+        } else {
+            created = calloc(hclib_num_workers(),
+                    sizeof(hclib_scratch_block_t *));
+            HASSERT(created);
+        }
+        if (_hclib_atomic_cas_ptr_acq_rel(&finish->scratch, NULL, created)) {
+            arenas = created;
+        } else {
+            free_list->arenas = created;
+            arenas = _hclib_atomic_load_ptr_acquire(&finish->scratch);
+        }
+    }
+    return arenas;
+}
+
+void *hclib_scratch_alloc(size_t nbytes) {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    HASSERT(ws->current_finish && "scratch memory needs a finish scope");
+    scratch_free_list_t *free_list = &free_lists[ws->id];
+    hclib_scratch_block_t **arena = &scope_arenas(ws->current_finish,
+            free_list)[ws->id];
+    nbytes = (nbytes + SCRATCH_ALIGN - 1) & ~(size_t) (SCRATCH_ALIGN - 1);
+
+    hclib_scratch_block_t *block = *arena;
+    if (block && block->size - block->used >= nbytes) {
+        void *ptr = block->data + block->used;
+        block->used += nbytes;
+        return ptr;
+    }
+
+    if (nbytes > SCRATCH_MAX_SHARED) {
+        // behind the block being bumped, which may still have room
+        block = block_create(nbytes);
+        block->used = nbytes;
+        if (*arena) {
+            block->next = (*arena)->next;
+            (*arena)->next = block;
+        } else {
+            block->next = NULL;
+            *arena = block;
+        }
+        return block->data;
+    }
+
+    if (free_list->blocks) {
+        block = free_list->blocks;
+        free_list->blocks = block->next;
+        free_list->nblocks--;
+    } else {
+        block = block_create(SCRATCH_BLOCK_SIZE);
+    }
+    block->used = nbytes;
+    block->next = *arena;
+    *arena = block;
+    return block->data;
+}
+
+/*
+ * Free the arenas of a finish scope whose tasks are all done, keeping blocks
+ * and the cleared array of arenas for the current worker.
+ */
+void hclib_scratch_release(finish_t *finish) {
+    hclib_scratch_block_t **arenas = finish->scratch;
+    finish->scratch = NULL;
+    scratch_free_list_t *free_list = &free_lists[CURRENT_WS_INTERNAL->id];
+    for (int w = 0; w < hclib_num_workers(); w++) {
+        hclib_scratch_block_t *block = arenas[w];
+        arenas[w] = NULL;
+        while (block) {
+            hclib_scratch_block_t *next = block->next;
+            if (block->size == SCRATCH_BLOCK_SIZE &&
+                    free_list->nblocks < SCRATCH_MAX_FREE) {
+                block->next = free_list->blocks;
+                free_list->blocks = block;
+                free_list->nblocks++;
+            } else {
+                free(block);
+            }
+            block = next;
+        }
+    }
+    if (free_list->arenas) {
+        free(arenas);
+    } else {
+        free_list->arenas = arenas;
+    }
+}
@@ -0,0 +1,348 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include <time.h>
+
+#include "hclib-internal.h"
+#include "hclib-timer-wheel.h"
+
+/*
+ * WHEEL_LEVELS levels of WHEEL_SIZE slots, level l holding the timers expiring
+ * between WHEEL_SIZE^l and WHEEL_SIZE^(l+1) ticks from now, in the slot given
+ * by the matching bits of their expiry tick. Whenever the level below wraps
+ * around, the next slot of a level is cascaded down.
+ */
+#define TICK_SHIFT 16 // ticks of about 65us
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1ULL << (WHEEL_BITS * WHEEL_LEVELS))
+
+// Expired timers scheduled together
+#define TIMER_READY_BATCH 64
+
+typedef enum {
+    TIMER_PENDING, // in the wheel
+    TIMER_FIRED, // task scheduled
+    TIMER_RUNNING,
+    TIMER_CANCELLED,
+    TIMER_DONE
+} hclib_timer_state_t;
+
+typedef struct hclib_timer_t {
+    hclib_promise_t promise;
+    hclib_task_t task; // reused by every run of a periodic timer
+    generic_frame_ptr fp;
+    void *arg;
+    uint64_t expiry; // in ns
+    uint64_t period; // 0 for a delayed task
+    long nruns;
+    hclib_timer_state_t state;
+    struct hclib_timer_t *next;
+    struct hclib_timer_t **pprev; // NULL once out of the wheel
+} hclib_timer_t;
+
+_Atomic int hclib_timers_pending = 0;
+
+static _Atomic int wheel_lock = 0;
+static uint64_t wheel_tick; // last tick processed
+static hclib_timer_t *wheel[WHEEL_LEVELS][WHEEL_SIZE];
+
+static inline void lock_wheel() {
+    while (!_hclib_atomic_cas_acq_rel(&wheel_lock, 0, 1)) { }
+}
+
+static inline int trylock_wheel() {
+    return _hclib_atomic_cas_acq_rel(&wheel_lock, 0, 1);
+}
+
+static inline void unlock_wheel() {
+    _hclib_atomic_store_release(&wheel_lock, 0);
+}
+
+static inline uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// first tick at or after t, so that timers never fire early
+static inline uint64_t tick_of(uint64_t t) {
+    return (t + (1ULL << TICK_SHIFT) - 1) >> TICK_SHIFT;
+}
+
+void hclib_timer_wheel_init() {
+    wheel_tick = now_ns() >> TICK_SHIFT;
+}
+
+static void wheel_link(hclib_timer_t *timer, hclib_timer_t **slot) {
+    timer->next = *slot;
+    if (timer->next) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = slot;
+    *slot = timer;
+}
+
+static void wheel_unlink(hclib_timer_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->pprev = NULL;
+}
+
+/*
+ * Put the timer in the wheel, or on the expired list if it is due by the
+ * current tick. Called with the wheel locked.
+ */
+static void wheel_insert(hclib_timer_t *timer, hclib_timer_t **expired) {
+    const uint64_t tick = tick_of(timer->expiry);
+    if (tick <= wheel_tick) {
+        timer->state = TIMER_FIRED;
+        timer->next = *expired;
+        *expired = timer;
+        return;
+    }
+    uint64_t delta = tick - wheel_tick;
+    // timers beyond the range of the wheel are cascaded again until in range
+    uint64_t slot_tick = delta < WHEEL_RANGE ? tick :
+        wheel_tick + WHEEL_RANGE - 1;
+    int level = 0;
+    while (delta >= WHEEL_SIZE && level < WHEEL_LEVELS - 1) {
+        delta >>= WHEEL_BITS;
+        level++;
+    }
+    const int slot = (slot_tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    timer->state = TIMER_PENDING;
+    wheel_link(timer, &wheel[level][slot]);
+}
+
+/*
+ * Skip the ticks that went by while the wheel was empty, which the next poll
+ * would otherwise walk through one by one with the wheel locked. Called with
+ * the wheel locked, where no timer is in the wheel if none is pending.
+ */
+static void wheel_catch_up() {
+    if (_hclib_atomic_load_relaxed(&hclib_timers_pending) == 0) {
+        const uint64_t now = now_ns() >> TICK_SHIFT;
+        if (wheel_tick < now) {
+            wheel_tick = now;
+        }
+    }
+}
+
+// Advance the wheel by one tick, collecting the timers that expired
+static void wheel_advance(hclib_timer_t **expired) {
+    wheel_tick++;
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if ((wheel_tick >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK) {
+            break;
+        }
+        const int slot = (wheel_tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+        hclib_timer_t *timer = wheel[level][slot];
+        wheel[level][slot] = NULL;
+        while (timer) {
+            hclib_timer_t *next = timer->next;
+            wheel_insert(timer, expired);
+            timer = next;
+        }
+    }
+
+    hclib_timer_t **slot = &wheel[0][wheel_tick & WHEEL_MASK];
+    hclib_timer_t *timer = *slot;
+    *slot = NULL;
+    while (timer) {
+        hclib_timer_t *next = timer->next;
+        timer->pprev = NULL;
+        timer->state = TIMER_FIRED;
+        timer->next = *expired;
+        *expired = timer;
+        timer = next;
+    }
+}
+
+static void schedule_expired(hclib_timer_t *timer) {
+    hclib_task_t *ready[TIMER_READY_BATCH];
+    int nready = 0;
+    while (timer) {
+        hclib_timer_t *next = timer->next;
+        timer->pprev = NULL;
+        ready[nready++] = &timer->task;
+        if (nready == TIMER_READY_BATCH) {
+            schedule_ready_tasks(ready, nready);
+            nready = 0;
+        }
+        timer = next;
+    }
+    if (nready > 0) {
+        schedule_ready_tasks(ready, nready);
+    }
+}
+
+/*
+ * Runs the timer's function, unless it or the finish scope it was started in
+ * was cancelled while queued, then either puts the timer back in the wheel or
+ * satisfies its future.
+ */
+static void timer_run(void *arg) {
+    hclib_timer_t *timer = (hclib_timer_t *) arg;
+    finish_t *finish = timer->task.current_finish;
+    lock_wheel();
+    if (finish && _hclib_cancel_token_is_cancelled(finish->cancel)) {
+        timer->state = TIMER_CANCELLED;
+    }
+    const int cancelled = timer->state == TIMER_CANCELLED;
+    if (!cancelled) {
+        timer->state = TIMER_RUNNING;
+    }
+    unlock_wheel();
+    if (!cancelled) {
+        (timer->fp)(timer->arg);
+        timer->nruns++;
+    }
+
+    lock_wheel();
+    if (timer->state == TIMER_RUNNING && timer->period) {
+        // skip the periods that went by while running
+        const uint64_t now = now_ns();
+        uint64_t next = timer->expiry + timer->period;
+        if (next <= now) {
+            next += (now - next) / timer->period * timer->period +
+                timer->period;
+        }
+        timer->expiry = next;
+        // this run is checked out of the finish once it returns
+        if (timer->task.current_finish) {
+            _hclib_atomic_inc_acquire(&timer->task.current_finish->counter);
+        }
+        hclib_timer_t *expired = NULL;
+        wheel_catch_up();
+        wheel_insert(timer, &expired);
+        if (!expired) {
+            _hclib_atomic_inc_relaxed(&hclib_timers_pending);
+        }
+        unlock_wheel();
+        schedule_expired(expired);
+        return;
+    }
+    if (timer->state == TIMER_RUNNING) {
+        timer->state = TIMER_DONE;
+    }
+    unlock_wheel();
+    hclib_promise_put(&timer->promise, (void *) timer->nruns);
+    hclib_promise_release(&timer->promise);
+}
+
+static hclib_future_t *timer_start(uint64_t delay_ns, uint64_t period_ns,
+        generic_frame_ptr fp, void *arg) {
+    hclib_timer_t *timer = (hclib_timer_t *) calloc(1, sizeof(hclib_timer_t));
+    HASSERT(timer);
+    hclib_promise_init(&timer->promise);
+    timer->promise.destructor = hclib_promise_free;
+    // the runtime holds a reference on the promise until it has put on it
+    hclib_promise_retain(&timer->promise);
+    timer->fp = fp;
+    timer->arg = arg;
+    timer->period = period_ns;
+    timer->expiry = now_ns() + delay_ns;
+
+    timer->task._fp = timer_run;
+    timer->task.args = timer;
+    timer->task.property = PERSISTENT_TASK;
+    finish_t *finish = CURRENT_WS_INTERNAL->current_finish;
+    if (finish) {
+        _hclib_atomic_inc_acquire(&finish->counter);
+    }
+    timer->task.current_finish = finish;
+
+    hclib_timer_t *expired = NULL;
+    lock_wheel();
+    wheel_catch_up();
+    wheel_insert(timer, &expired);
+    if (!expired) {
+        _hclib_atomic_inc_relaxed(&hclib_timers_pending);
+    }
+    unlock_wheel();
+    schedule_expired(expired);
+    return &timer->promise.future;
+}
+
+hclib_future_t *hclib_async_after(uint64_t delay_ns, generic_frame_ptr fp,
+        void *arg) {
+    return timer_start(delay_ns, 0, fp, arg);
+}
+
+hclib_future_t *hclib_async_every(uint64_t period_ns, generic_frame_ptr fp,
+        void *arg) {
+    HASSERT(period_ns > 0);
+    return timer_start(period_ns, period_ns, fp, arg);
+}
+
+int hclib_timer_cancel(hclib_future_t *future) {
+    hclib_timer_t *timer = (hclib_timer_t *) future->owner;
+    int cancelled = 0;
+    int unlinked = 0;
+    lock_wheel();
+    if (timer->state == TIMER_PENDING) {
+        wheel_unlink(timer);
+        unlinked = 1;
+        cancelled = 1;
+    } else if (timer->state == TIMER_FIRED ||
+            (timer->state == TIMER_RUNNING && timer->period)) {
+        cancelled = 1;
+    }
+    if (cancelled) {
+        timer->state = TIMER_CANCELLED;
+    }
+    unlock_wheel();
+
+    if (unlinked) {
+        _hclib_atomic_dec_relaxed(&hclib_timers_pending);
+        hclib_check_out_finish(timer->task.current_finish);
+        hclib_promise_put(&timer->promise, (void *) timer->nruns);
+        hclib_promise_release(&timer->promise);
+    }
+    return cancelled;
+}
+
+/*
+ * Called by idle workers while timers are pending, to schedule the tasks of
+ * those that expired. Returns how many were scheduled.
+ */
+int hclib_timer_wheel_poll() {
+    if (!trylock_wheel()) {
+        return 0;
+    }
+    const uint64_t now = now_ns() >> TICK_SHIFT;
+    hclib_timer_t *expired = NULL;
+    while (wheel_tick < now) {
+        wheel_advance(&expired);
+    }
+    unlock_wheel();
+
+    int nexpired = 0;
+    for (hclib_timer_t *timer = expired; timer; timer = timer->next) {
+        nexpired++;
+    }
+    if (nexpired > 0) {
+        _hclib_atomic_add_acquire(&hclib_timers_pending, -nexpired);
+        schedule_expired(expired);
+    }
+    return nexpired;
+}
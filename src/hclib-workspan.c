@@ -0,0 +1,564 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE // dladdr
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hclib-internal.h"
+
+// cost of a steal assumed by the burdened span, as in Cilkview
+#define WORKSPAN_DEFAULT_BURDEN 15000
+// finish scope call sites kept by each worker, further ones are lumped together
+#define WORKSPAN_MAX_SITES 64
+// largest number of workers the speedup bounds of the program are given for
+#define WORKSPAN_MAX_REPORTED_WORKERS 64
+// buckets of the table of the spans of puts
+#define WORKSPAN_PUT_BUCKETS 4096
+
+typedef struct hclib_workspan_scope_st {
+    // of the tasks checked out of the scope so far
+    _Atomic uint64_t work;
+    _Atomic uint64_t span;
+    _Atomic uint64_t burdened_span;
+    // of the task that started the scope, when it did
+    hclib_workspan_t start;
+    void *site;
+    int nonblocking;
+    // in a scope of the same site, which the totals go to
+    int recursive;
+} hclib_workspan_scope_t;
+
+typedef struct {
+    void *site; // NULL for the lumped sites
+    uint64_t instances;
+    // of the instances that are not recursive
+    hclib_workspan_t totals;
+} workspan_site_t;
+
+typedef struct {
+    // of the task whose strand is running on this worker, if any
+    hclib_workspan_t *frame;
+    uint64_t strand_start;
+    uint64_t work;
+    workspan_site_t sites[WORKSPAN_MAX_SITES + 1];
+    char pad[HCLIB_CACHE_LINE_SIZE];
+} workspan_worker_t;
+
+/*
+ * Spans of the put on a promise, kept in a table rather than in the promise
+ * so that promises do not grow for profiling. Entries are dropped when a
+ * promise at the same address is initialized.
+ */
+typedef struct workspan_put_st {
+    hclib_promise_t *promise;
+    uint64_t span;
+    uint64_t burdened_span;
+    struct workspan_put_st *next;
+} workspan_put_t;
+
+typedef struct {
+    _Atomic int lock;
+    workspan_put_t *head;
+} workspan_bucket_t;
+
+int hclib_workspan_enabled = 0;
+static uint64_t burden = WORKSPAN_DEFAULT_BURDEN;
+static workspan_worker_t *workers = NULL;
+static workspan_bucket_t *put_table = NULL;
+// of the whole program, as of the last report
+static hclib_workspan_t program;
+static int program_profiled = 0;
+
+// nanoseconds rather than cycles where there is no cycle counter
+static inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static inline uint64_t max_u64(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+void hclib_workspan_init() {
+    hclib_workspan_enabled = (getenv("HCLIB_WORKSPAN") != NULL);
+    if (!hclib_workspan_enabled) {
+        return;
+    }
+    const char *burden_str = getenv("HCLIB_WORKSPAN_BURDEN");
+    burden = burden_str ? strtoull(burden_str, NULL, 10) :
+        WORKSPAN_DEFAULT_BURDEN;
+    workers = calloc(hclib_num_workers(), sizeof(workspan_worker_t));
+    HASSERT(workers);
+    put_table = calloc(WORKSPAN_PUT_BUCKETS, sizeof(workspan_bucket_t));
+    HASSERT(put_table);
+    memset(&program, 0, sizeof(program));
+    program_profiled = 0;
+}
+
+void hclib_workspan_cleanup() {
+    free(workers);
+    workers = NULL;
+    if (put_table) {
+        for (int i = 0; i < WORKSPAN_PUT_BUCKETS; i++) {
+            workspan_put_t *entry = put_table[i].head;
+            while (entry) {
+                workspan_put_t *next = entry->next;
+                free(entry);
+                entry = next;
+            }
+        }
+        free(put_table);
+        put_table = NULL;
+    }
+    hclib_workspan_enabled = 0;
+}
+
+int hclib_workspan_get(hclib_workspan_t *totals) {
+    if (program_profiled) {
+        *totals = program;
+    }
+    return program_profiled;
+}
+
+// NULL outside of the worker threads
+static inline workspan_worker_t *current_worker() {
+    hclib_worker_state *ws = CURRENT_WS_INTERNAL;
+    return ws ? &workers[ws->id] : NULL;
+}
+
+static inline void strand_end(workspan_worker_t *w, uint64_t now) {
+    hclib_workspan_t *frame = w->frame;
+    if (frame) {
+        const uint64_t length = now - w->strand_start;
+        frame->work += length;
+        frame->span += length;
+        frame->burdened_span += length;
+        w->work += length;
+    }
+}
+
+// Charges the running strand to its task, which goes on with a new strand.
+static inline hclib_workspan_t *strand_split(workspan_worker_t *w) {
+    const uint64_t now = cycles();
+    strand_end(w, now);
+    w->strand_start = now;
+    return w->frame;
+}
+
+static inline void strand_resume(workspan_worker_t *w,
+        hclib_workspan_t *frame) {
+    w->frame = frame;
+    w->strand_start = cycles();
+}
+
+static inline workspan_bucket_t *lock_bucket(hclib_promise_t *promise) {
+    const uint64_t hash = (uintptr_t) promise * 0x9e3779b97f4a7c15ULL;
+    workspan_bucket_t *bucket =
+        &put_table[(hash >> 32) % WORKSPAN_PUT_BUCKETS];
+    while (!_hclib_atomic_cas_acq_rel(&bucket->lock, 0, 1)) { }
+    return bucket;
+}
+
+static inline void unlock_bucket(workspan_bucket_t *bucket) {
+    _hclib_atomic_store_release(&bucket->lock, 0);
+}
+
+// Called with the bucket locked, NULL if nothing was put on the promise.
+static inline workspan_put_t **find_put(workspan_bucket_t *bucket,
+        hclib_promise_t *promise) {
+    workspan_put_t **entry = &bucket->head;
+    while (*entry && (*entry)->promise != promise) {
+        entry = &(*entry)->next;
+    }
+    return entry;
+}
+
+// The spans of the put on the promise are at least the given ones.
+static void put_spans(hclib_promise_t *promise, uint64_t span,
+        uint64_t burdened_span) {
+    workspan_bucket_t *bucket = lock_bucket(promise);
+    workspan_put_t **found = find_put(bucket, promise);
+    workspan_put_t *entry = *found;
+    if (entry == NULL) {
+        entry = calloc(1, sizeof(*entry));
+        HASSERT(entry);
+        entry->promise = promise;
+        *found = entry;
+    }
+    entry->span = max_u64(entry->span, span);
+    entry->burdened_span = max_u64(entry->burdened_span, burdened_span);
+    unlock_bucket(bucket);
+}
+
+static void get_put_spans(hclib_promise_t *promise, uint64_t *span,
+        uint64_t *burdened_span) {
+    workspan_bucket_t *bucket = lock_bucket(promise);
+    const workspan_put_t *entry = *find_put(bucket, promise);
+    *span = entry ? entry->span : 0;
+    *burdened_span = entry ? entry->burdened_span : 0;
+    unlock_bucket(bucket);
+}
+
+void hclib_workspan_forget(hclib_promise_t *promise) {
+    workspan_bucket_t *bucket = lock_bucket(promise);
+    workspan_put_t **found = find_put(bucket, promise);
+    workspan_put_t *entry = *found;
+    if (entry) {
+        *found = entry->next;
+    }
+    unlock_bucket(bucket);
+    free(entry);
+}
+
+// The task with the frame waited for the put on the promise.
+static inline void join_put(hclib_workspan_t *frame,
+        hclib_promise_t *promise) {
+    uint64_t span, burdened_span;
+    get_put_spans(promise, &span, &burdened_span);
+    frame->span = max_u64(frame->span, span);
+    frame->burdened_span = max_u64(frame->burdened_span,
+            burdened_span + burden);
+}
+
+static void record_scope(workspan_worker_t *w,
+        const hclib_workspan_scope_t *scope, const hclib_workspan_t *totals) {
+    void *site = scope->site;
+    workspan_site_t *entry = &w->sites[WORKSPAN_MAX_SITES];
+    size_t i = ((uintptr_t) site >> 4) % WORKSPAN_MAX_SITES;
+    for (int n = 0; n < WORKSPAN_MAX_SITES; n++) {
+        workspan_site_t *probed = &w->sites[i];
+        if (probed->instances == 0 || probed->site == site) {
+            entry = probed;
+            entry->site = site;
+            break;
+        }
+        i = (i + 1) % WORKSPAN_MAX_SITES;
+    }
+    entry->instances++;
+    if (scope->recursive) {
+        return;
+    }
+    entry->totals.work += totals->work;
+    entry->totals.span += totals->span;
+    entry->totals.burdened_span += totals->burdened_span;
+}
+
+void hclib_workspan_spawn(hclib_task_t *task) {
+    hclib_workspan_t *frame = strand_split(current_worker());
+    if (task->workspan == NULL) {
+        task->workspan = malloc(sizeof(hclib_workspan_t));
+        HASSERT(task->workspan);
+    }
+    task->workspan->work = 0;
+    if (frame) {
+        task->workspan->span = frame->span;
+        task->workspan->burdened_span = frame->burdened_span + burden;
+    } else {
+        task->workspan->span = 0;
+        task->workspan->burdened_span = 0;
+    }
+}
+
+hclib_workspan_t *hclib_workspan_begin_task(hclib_task_t *task) {
+    workspan_worker_t *w = current_worker();
+    const uint64_t now = cycles();
+    strand_end(w, now);
+    hclib_workspan_t *caller = w->frame;
+
+    if (task->workspan == NULL) {
+        // not spawned, as continuations run from a full deque
+        task->workspan = calloc(1, sizeof(hclib_workspan_t));
+        HASSERT(task->workspan);
+    }
+    if (task->future_list) {
+        for (hclib_future_t **future = task->future_list; *future; future++) {
+            join_put(task->workspan, (*future)->owner);
+        }
+    }
+    w->frame = task->workspan;
+    w->strand_start = now;
+    return caller;
+}
+
+void hclib_workspan_end_task(hclib_task_t *task, hclib_workspan_t *caller) {
+    workspan_worker_t *w = current_worker();
+    const uint64_t now = cycles();
+    strand_end(w, now);
+
+    hclib_workspan_scope_t *scope = task->current_finish ?
+        task->current_finish->workspan : NULL;
+    if (scope) {
+        _hclib_atomic_add_u64_relaxed(&scope->work, task->workspan->work);
+        _hclib_atomic_max_u64_relaxed(&scope->span, task->workspan->span);
+        _hclib_atomic_max_u64_relaxed(&scope->burdened_span,
+                task->workspan->burdened_span);
+    }
+    free(task->workspan);
+    task->workspan = NULL;
+    w->frame = caller;
+    w->strand_start = now;
+}
+
+hclib_workspan_t *hclib_workspan_suspend() {
+    workspan_worker_t *w = current_worker();
+    strand_end(w, cycles());
+    hclib_workspan_t *frame = w->frame;
+    w->frame = NULL;
+    return frame;
+}
+
+void hclib_workspan_join(hclib_workspan_t *frame, hclib_promise_t *promise) {
+    if (frame) {
+        join_put(frame, promise);
+    }
+    strand_resume(current_worker(), frame);
+}
+
+void hclib_workspan_start_finish(finish_t *finish, void *site) {
+    hclib_workspan_scope_t *scope = malloc(sizeof(*scope));
+    HASSERT(scope);
+    hclib_workspan_t *frame = strand_split(current_worker());
+    if (frame) {
+        scope->start = *frame;
+    } else {
+        memset(&scope->start, 0, sizeof(scope->start));
+    }
+    scope->work = 0;
+    scope->span = 0;
+    scope->burdened_span = 0;
+    scope->site = site;
+    scope->nonblocking = 0;
+    scope->recursive = 0;
+    for (finish_t *outer = finish->parent; outer; outer = outer->parent) {
+        if (outer->workspan && outer->workspan->site == site) {
+            scope->recursive = 1;
+            break;
+        }
+    }
+    finish->workspan = scope;
+}
+
+void hclib_workspan_end_finish(finish_t *finish, hclib_workspan_t *frame) {
+    hclib_workspan_scope_t *scope = finish->workspan;
+    workspan_worker_t *w = current_worker();
+
+    hclib_workspan_t end = { 0, 0, 0 };
+    if (frame) {
+        end = *frame;
+    }
+    end.work += scope->work;
+    end.span = max_u64(end.span, scope->span);
+    if (scope->work > 0) {
+        end.burdened_span = max_u64(end.burdened_span,
+                scope->burdened_span + burden);
+    }
+    if (frame) {
+        *frame = end;
+    }
+
+    const hclib_workspan_t totals = {
+        end.work - scope->start.work,
+        end.span - scope->start.span,
+        end.burdened_span - scope->start.burdened_span,
+    };
+    if (finish->parent) {
+        record_scope(w, scope, &totals);
+    } else {
+        program = totals;
+    }
+    free(scope);
+    finish->workspan = NULL;
+    strand_resume(w, frame);
+}
+
+void hclib_workspan_end_finish_nonblocking(finish_t *finish) {
+    hclib_workspan_scope_t *scope = finish->workspan;
+    hclib_workspan_t *frame = strand_split(current_worker());
+    if (frame) {
+        // the task goes on outside of the scope
+        _hclib_atomic_add_u64_relaxed(&scope->work,
+                frame->work - scope->start.work);
+        _hclib_atomic_max_u64_relaxed(&scope->span, frame->span);
+        _hclib_atomic_max_u64_relaxed(&scope->burdened_span,
+                frame->burdened_span);
+    }
+    scope->nonblocking = 1;
+}
+
+void hclib_workspan_check_out(finish_t *finish, hclib_promise_t *promise) {
+    // the tasks that updated the scope are done with it
+    _hclib_atomic_fence_acquire();
+    hclib_workspan_scope_t *scope = finish->workspan;
+    if (!scope->nonblocking) {
+        // hclib_end_finish joins the scope
+        return;
+    }
+
+    put_spans(promise, scope->span, scope->burdened_span);
+    const hclib_workspan_t totals = {
+        scope->work,
+        scope->span - scope->start.span,
+        scope->burdened_span - scope->start.burdened_span,
+    };
+    workspan_worker_t *w = current_worker();
+    if (w) {
+        record_scope(w, scope, &totals);
+    }
+    free(scope);
+    finish->workspan = NULL;
+}
+
+void hclib_workspan_put(hclib_promise_t *promise) {
+    workspan_worker_t *w = current_worker();
+    hclib_workspan_t *frame = w ? strand_split(w) : NULL;
+    if (frame) {
+        put_spans(promise, frame->span, frame->burdened_span);
+    }
+}
+
+void hclib_workspan_gather(hclib_promise_t *promise, hclib_promise_t *input) {
+    uint64_t span, burdened_span;
+    get_put_spans(input, &span, &burdened_span);
+    put_spans(promise, span, burdened_span);
+}
+
+/*
+ * Bounds on the speedup of a computation with the given work and spans on
+ * nworkers workers. No schedule can do better than the parallelism, and a
+ * greedy one paying the burden on each edge of the critical path takes at
+ * most (work - span) / nworkers + burdened span.
+ */
+static void print_speedup(FILE *f, int width, const hclib_workspan_t *totals,
+        int nworkers) {
+    const double work = totals->work;
+    double upper = nworkers;
+    if (totals->span > 0 && work / totals->span < upper) {
+        upper = work / totals->span;
+    }
+    double lower = work / ((work - totals->span) / nworkers +
+            totals->burdened_span);
+    if (lower > upper) {
+        lower = upper;
+    }
+    char bounds[32];
+    snprintf(bounds, sizeof(bounds), "%.2f-%.2f", lower, upper);
+    fprintf(f, "%*s", width, bounds);
+}
+
+static void print_site(FILE *f, void *site) {
+    Dl_info info;
+    if (site == NULL) {
+        fprintf(f, "(other sites)");
+    } else if (dladdr(site, &info) && info.dli_sname) {
+        fprintf(f, "%s+0x%lx (%s)", info.dli_sname,
+                (unsigned long) ((char *) site - (char *) info.dli_saddr),
+                info.dli_fname);
+    } else if (dladdr(site, &info) && info.dli_fname) {
+        // for addr2line
+        fprintf(f, "%s+0x%lx", info.dli_fname,
+                (unsigned long) ((char *) site - (char *) info.dli_fbase));
+    } else {
+        fprintf(f, "%p", site);
+    }
+}
+
+static int compare_sites_by_work(const void *a, const void *b) {
+    const uint64_t work_a = ((const workspan_site_t *) a)->totals.work;
+    const uint64_t work_b = ((const workspan_site_t *) b)->totals.work;
+    return work_a < work_b ? 1 : (work_a > work_b ? -1 : 0);
+}
+
+static double ratio(uint64_t work, uint64_t span) {
+    return span > 0 ? (double) work / span : 0.0;
+}
+
+void hclib_workspan_report() {
+    const int nworkers = hclib_num_workers();
+    program.work = 0;
+    for (int w = 0; w < nworkers; w++) {
+        program.work += workers[w].work;
+    }
+    program_profiled = 1;
+
+    // the sites of all the workers, merged
+    const size_t max_sites = (size_t) nworkers * (WORKSPAN_MAX_SITES + 1);
+    workspan_site_t *sites = calloc(max_sites, sizeof(workspan_site_t));
+    HASSERT(sites);
+    int nsites = 0;
+    for (int w = 0; w < nworkers; w++) {
+        for (int i = 0; i <= WORKSPAN_MAX_SITES; i++) {
+            const workspan_site_t *entry = &workers[w].sites[i];
+            if (entry->instances == 0) {
+                continue;
+            }
+            int j = 0;
+            while (j < nsites && sites[j].site != entry->site) {
+                j++;
+            }
+            if (j == nsites) {
+                sites[nsites++].site = entry->site;
+            }
+            sites[j].instances += entry->instances;
+            sites[j].totals.work += entry->totals.work;
+            sites[j].totals.span += entry->totals.span;
+            sites[j].totals.burdened_span += entry->totals.burdened_span;
+        }
+    }
+    qsort(sites, nsites, sizeof(workspan_site_t), compare_sites_by_work);
+
+    FILE *f = stderr;
+    fprintf(f, "============================ Work/Span Profile "
+            "============================\n");
+    fprintf(f, "work %" PRIu64 " cycles, span %" PRIu64 " cycles, burdened "
+            "span %" PRIu64 " cycles\n", program.work, program.span,
+            program.burdened_span);
+    fprintf(f, "parallelism %.2f, burdened parallelism %.2f\n",
+            ratio(program.work, program.span),
+            ratio(program.work, program.burdened_span));
+    fprintf(f, "workers  speedup bounds\n");
+    for (int p = 1; p <= WORKSPAN_MAX_REPORTED_WORKERS; p *= 2) {
+        fprintf(f, "%7d  ", p);
+        print_speedup(f, 0, &program, p);
+        fprintf(f, "\n");
+    }
+    fprintf(f, "finish scopes by work, with the speedup bounds on %d "
+            "workers:\n", nworkers);
+    fprintf(f, "%16s %16s %11s %9s %13s %10s  %s\n", "work", "span",
+            "parallelism", "burdened", "speedup", "instances", "site");
+    for (int i = 0; i < nsites; i++) {
+        const hclib_workspan_t *totals = &sites[i].totals;
+        fprintf(f, "%16" PRIu64 " %16" PRIu64 " %11.2f %9.2f ", totals->work,
+                totals->span, ratio(totals->work, totals->span),
+                ratio(totals->work, totals->burdened_span));
+        print_speedup(f, 13, totals, nworkers);
+        fprintf(f, " %10" PRIu64 "  ", sites[i].instances);
+        print_site(f, sites[i].site);
+        fprintf(f, "\n");
+    }
+    fprintf(f, "------------------------------ End Work/Span Profile "
+            "-----------------------------\n");
+    free(sites);
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <stddef.h>
 #include <string.h>
 
 #include "hclib.h"
@@ -21,6 +22,7 @@
 #include "hclib-task.h"
 #include "hclib-async-struct.h"
 #include "hclib-finish.h"
+#include "hclib-internal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,8 +32,13 @@ extern "C" {
 
 void hclib_async(generic_frame_ptr fp, void *arg, hclib_future_t **future_list,
                  struct _phased_t *phased_clause, place_t *place, int property) {
-//   HASSERT(property == 0);
-    HASSERT(phased_clause == NULL);
+    if (_hclib_atomic_load_relaxed(&hclib_ncaptures) > 0 &&
+            CURRENT_WS_INTERNAL->capture) {
+        check_log_die(phased_clause,
+                "phased tasks cannot be recorded in a graph");
+        hclib_graph_record(fp, NULL, arg, future_list, place, property);
+        return;
+    }
 
     hclib_task_t *task = malloc(sizeof(*task));
     HASSERT(task);
@@ -40,11 +47,15 @@ void hclib_async(generic_frame_ptr fp, void *arg, hclib_future_t **future_list,
         .args = arg,
         .future_list = future_list,
         .place = place,
+        .property = property,
         // any field not explicitly initialized gets zeroed
         // but not next_waiter since it's a flexible array,
         // but that's OK since it isn't read until after written
         // NOTE: .current_finish is set in "spawn_handler"
     };
+    if (phased_clause || (property & PHASER_TRANSMIT_ALL)) {
+        task->phasers = hclib_phased_register(phased_clause, property);
+    }
 
     if (future_list) {
 
@@ -60,7 +71,8 @@ void hclib_async(generic_frame_ptr fp, void *arg, hclib_future_t **future_list,
         if (place) {
             spawn_at_hpt(place, task);
         } else {
-            HASSERT(property == 0);
+            HASSERT((property & ~(INLINE_ASYNC | PHASER_TRANSMIT_ALL |
+                            UNCANCELLABLE_ASYNC)) == 0);
             spawn(task);
         }
     }
@@ -74,19 +86,37 @@ typedef struct _future_args_wrapper {
 
 static void future_caller(void *in) {
     future_args_wrapper *args = in;
-    void *user_result = (args->fp)(args->actual_in);
+    // the future of a cancelled task is satisfied with NULL
+    void *user_result = hclib_is_cancelled() ? NULL :
+        (args->fp)(args->actual_in);
     hclib_promise_put(&args->event, user_result);
 }
 
+void *hclib_task_function(hclib_task_t *task) {
+    if (task->_fp == future_caller) {
+        return (void *) ((future_args_wrapper *) task->args)->fp;
+    }
+    return (void *) task->_fp;
+}
+
 hclib_future_t *hclib_async_future(futureFct_t fp, void *arg,
                                    hclib_future_t **future_list, struct _phased_t *phased_clause,
                                    place_t *place, int property) {
+    if (_hclib_atomic_load_relaxed(&hclib_ncaptures) > 0 &&
+            CURRENT_WS_INTERNAL->capture) {
+        check_log_die(phased_clause,
+                "phased tasks cannot be recorded in a graph");
+        return hclib_graph_record(NULL, fp, arg, future_list, place,
+                property);
+    }
+
     future_args_wrapper *wrapper = malloc(sizeof(future_args_wrapper));
     hclib_promise_init(&wrapper->event);
     wrapper->fp = fp;
     wrapper->actual_in = arg;
+    // the future must be satisfied, cancelled or not (see future_caller)
     hclib_async(future_caller, wrapper, future_list, phased_clause, place,
-                property);
+                property | UNCANCELLABLE_ASYNC);
 
     return hclib_get_future_for_promise(&wrapper->event);
 }
@@ -95,380 +125,436 @@ hclib_future_t *hclib_async_future(futureFct_t fp, void *arg,
 
 /*** START FORASYNC IMPLEMENTATION ***/
 
+/*
+ * All forasyncs, whatever their dimension, go through a single N-dimensional
+ * engine working on 64-bit domains. The 1D, 2D and 3D C entry points just
+ * widen their domain and record how the user function must be called (see
+ * forasync_kind_t).
+ */
+
 #define DEBUG_FORASYNC 0
 
-forasync1D_task_t *allocate_forasync1D_task() {
-    forasync1D_task_t *forasync_task = (forasync1D_task_t *) malloc(
-                                           sizeof(forasync1D_task_t));
-    HASSERT(forasync_task && "malloc failed");
-    forasync_task->forasync_task.place = NULL;
-    return forasync_task;
+// Iterations executed between two checks of the local deque (adaptive mode)
+#define FORASYNC_ADAPTIVE_CHUNK 16
+
+static inline int64_t loop_domain_count(const loop_domain64_t *loop) {
+    if (loop->high <= loop->low) return 0;
+    return (loop->high - loop->low + loop->stride - 1) / loop->stride;
 }
 
-forasync2D_task_t *allocate_forasync2D_task() {
-    forasync2D_task_t *forasync_task = (forasync2D_task_t *) malloc(
-                                           sizeof(forasync2D_task_t));
-    HASSERT(forasync_task && "malloc failed");
-    forasync_task->forasync_task.place = NULL;
-    return forasync_task;
+static inline int64_t forasync_count(const forasyncND_t *forasync) {
+    int64_t count = 1;
+    for (int d = 0; d < forasync->dim; d++) {
+        count *= loop_domain_count(&forasync->loop[d]);
+    }
+    return count;
 }
 
-forasync3D_task_t *allocate_forasync3D_task() {
-    forasync3D_task_t *forasync_task = (forasync3D_task_t *) malloc(
-                                           sizeof(forasync3D_task_t));
-    HASSERT(forasync_task && "malloc failed");
-    forasync_task->forasync_task.place = NULL;
-    return forasync_task;
+/*
+ * Midpoint of a dimension, aligned on its stride so that both halves visit
+ * exactly the iterations of the original domain.
+ */
+static inline int64_t loop_domain_mid(const loop_domain64_t *loop) {
+    return loop->low + (loop_domain_count(loop) / 2) * loop->stride;
 }
 
-void forasync1D_runner(void *forasync_arg) {
-    forasync1D_t *forasync = (forasync1D_t *) forasync_arg;
-    hclib_task_t *user = forasync->base.user;
-    forasync1D_Fct_t user_fct_ptr = (forasync1D_Fct_t) user->_fp;
-    void *user_arg = (void *) user->args;
-    loop_domain_t loop0 = forasync->loop0;
-    int i=0;
-    for(i=loop0.low; i<loop0.high; i+=loop0.stride) {
-        (*user_fct_ptr)(user_arg, i);
+static inline size_t forasync_def_size(int dim) {
+    return offsetof(forasyncND_t, loop) + dim * sizeof(loop_domain64_t);
+}
+
+static void forasync_body_free(forasync_body_t *body) {
+    free(body);
+}
+
+/*
+ * Take a reference on the body of a forasync on behalf of a new task. A body
+ * that still lives on the stack of the forasync call is first copied to the
+ * heap, which is only ever needed if the forasync actually spawns tasks.
+ */
+static forasync_body_t *forasync_body_share(forasync_body_t *body) {
+    if (body->shared == NULL) {
+        forasync_body_t *shared = (forasync_body_t *) malloc(
+                sizeof(forasync_body_t));
+        HASSERT(shared && "malloc failed");
+        *shared = *body;
+        shared->release = forasync_body_free;
+        shared->refcount = 1; // owned by the forasync call
+        shared->shared = shared;
+        body->shared = shared;
     }
+    _hclib_atomic_inc_relaxed((_Atomic int *) &body->shared->refcount);
+    return body->shared;
 }
 
-void forasync2D_runner(void *forasync_arg) {
-    forasync2D_t *forasync = (forasync2D_t *) forasync_arg;
-    hclib_task_t *user = *((hclib_task_t **) forasync_arg);
-    forasync2D_Fct_t user_fct_ptr = (forasync2D_Fct_t) user->_fp;
-    void *user_arg = (void *) user->args;
-    loop_domain_t loop0 = forasync->loop0;
-    loop_domain_t loop1 = forasync->loop1;
-    int i=0,j=0;
-    for(i=loop0.low; i<loop0.high; i+=loop0.stride) {
-        for(j=loop1.low; j<loop1.high; j+=loop1.stride) {
-            (*user_fct_ptr)(user_arg, i, j);
-        }
+static void forasync_body_put(forasync_body_t *body) {
+    if (_hclib_atomic_dec_acq_rel((_Atomic int *) &body->refcount) == 0 &&
+            body->release) {
+        body->release(body);
     }
 }
 
-void forasync3D_runner(void *forasync_arg) {
-    forasync3D_t *forasync = (forasync3D_t *) forasync_arg;
-    hclib_task_t *user = *((hclib_task_t **) forasync_arg);
-    forasync3D_Fct_t user_fct_ptr = (forasync3D_Fct_t) user->_fp;
-    void *user_arg = (void *) user->args;
-    loop_domain_t loop0 = forasync->loop0;
-    loop_domain_t loop1 = forasync->loop1;
-    loop_domain_t loop2 = forasync->loop2;
-    int i=0,j=0,k=0;
-    for(i=loop0.low; i<loop0.high; i+=loop0.stride) {
-        for(j=loop1.low; j<loop1.high; j+=loop1.stride) {
-            for(k=loop2.low; k<loop2.high; k+=loop2.stride) {
-                (*user_fct_ptr)(user_arg, i, j, k);
+static forasyncND_task_t *allocate_forasyncND_task(const forasyncND_t *def,
+        asyncFct_t fp) {
+    forasyncND_task_t *forasync_task = (forasyncND_task_t *) malloc(
+            offsetof(forasyncND_task_t, def) + forasync_def_size(def->dim));
+    HASSERT(forasync_task && "malloc failed");
+    forasync_task->forasync_task._fp = fp;
+    forasync_task->forasync_task.args = &(forasync_task->def);
+    forasync_task->forasync_task.future_list = NULL;
+    forasync_task->forasync_task.place = NULL;
+    // releases the body, so iterations are skipped instead (forasync_runner)
+    forasync_task->forasync_task.property = UNCANCELLABLE_ASYNC;
+    forasync_task->forasync_task.phasers = NULL;
+    memcpy(&forasync_task->def, def, forasync_def_size(def->dim));
+    forasync_task->def.base.body = forasync_body_share(def->base.body);
+    return forasync_task;
+}
+
+/*
+ * Execute all iterations of a tile.
+ */
+static void forasync_runner(void *forasync_arg) {
+    if (hclib_is_cancelled()) {
+        return;
+    }
+    forasyncND_t *forasync = (forasyncND_t *) forasync_arg;
+    forasync_body_t *body = forasync->base.body;
+    void *user_arg = body->arg;
+    const loop_domain64_t *loop = forasync->loop;
+    int64_t i, j, k;
+
+    switch (body->kind) {
+    case FORASYNC_KIND_1D: {
+        forasync1D_Fct_t user_fct_ptr = (forasync1D_Fct_t) body->fct;
+        for(i=loop[0].low; i<loop[0].high; i+=loop[0].stride) {
+            (*user_fct_ptr)(user_arg, (int) i);
+        }
+        break;
+    }
+    case FORASYNC_KIND_2D: {
+        forasync2D_Fct_t user_fct_ptr = (forasync2D_Fct_t) body->fct;
+        for(i=loop[0].low; i<loop[0].high; i+=loop[0].stride) {
+            for(j=loop[1].low; j<loop[1].high; j+=loop[1].stride) {
+                (*user_fct_ptr)(user_arg, (int) i, (int) j);
             }
         }
+        break;
+    }
+    case FORASYNC_KIND_3D: {
+        forasync3D_Fct_t user_fct_ptr = (forasync3D_Fct_t) body->fct;
+        for(i=loop[0].low; i<loop[0].high; i+=loop[0].stride) {
+            for(j=loop[1].low; j<loop[1].high; j+=loop[1].stride) {
+                for(k=loop[2].low; k<loop[2].high; k+=loop[2].stride) {
+                    (*user_fct_ptr)(user_arg, (int) i, (int) j, (int) k);
+                }
+            }
+        }
+        break;
+    }
+    case FORASYNC_KIND_RANGE: {
+        loop_domain_t chunk[3];
+        for (int d = 0; d < forasync->dim; d++) {
+            chunk[d].low = (int) loop[d].low;
+            chunk[d].high = (int) loop[d].high;
+            chunk[d].stride = (int) loop[d].stride;
+            chunk[d].tile = (int) loop[d].tile;
+        }
+        ((forasync_range_Fct_t) body->fct)(user_arg, chunk);
+        break;
+    }
+    case FORASYNC_KIND_ND_RANGE:
+        ((forasyncND_range_Fct_t) body->fct)(user_arg, loop);
+        break;
+    case FORASYNC_KIND_ND: {
+        forasyncND_Fct_t user_fct_ptr = (forasyncND_Fct_t) body->fct;
+        const int dim = forasync->dim;
+        int64_t index[HCLIB_FORASYNC_MAX_DIM];
+        if (forasync_count(forasync) == 0) break;
+        for (int d = 0; d < dim; d++) {
+            index[d] = loop[d].low;
+        }
+        // odometer over all dimensions, innermost fastest
+        int d;
+        do {
+            (*user_fct_ptr)(user_arg, index);
+            for (d = dim - 1; d >= 0; d--) {
+                index[d] += loop[d].stride;
+                if (index[d] < loop[d].high) break;
+                index[d] = loop[d].low;
+            }
+        } while (d >= 0);
+        break;
+    }
     }
-#if DEBUG_FORASYNC
-    printf("forasync spawned %d\n", nb_spawn);
-#endif
 }
 
-void forasync1D_recursive(void *forasync_arg) {
-    forasync1D_t *forasync = (forasync1D_t *) forasync_arg;
-    loop_domain_t loop0 = forasync->loop0;
-    int high0 = loop0.high;
-    int low0 = loop0.low;
-    int stride0 = loop0.stride;
-    int tile0 = loop0.tile;
-
-    //split the range into two, spawn a new task for the first half and recurse on the rest
-    if((high0-low0) > tile0) {
-        int mid = (high0+low0)/2;
-        // upper-half
-        forasync1D_task_t *new_forasync_task = allocate_forasync1D_task();
-        new_forasync_task->forasync_task._fp = forasync1D_recursive;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        loop_domain_t new_loop0 = {mid, high0, stride0, tile0};
-        new_forasync_task->def.loop0 = new_loop0;
-        // update lower-half
-        forasync->loop0.high = mid;
-        // delegate scheduling to the underlying runtime
+/*
+ * Entry point of a forasync tile task: run it, then drop the task's reference
+ * on the loop body.
+ */
+static void forasync_runner_task(void *forasync_arg) {
+    forasync_body_t *body = ((forasyncND_t *) forasync_arg)->base.body;
+    forasync_runner(forasync_arg);
+    forasync_body_put(body);
+}
 
-        spawn((hclib_task_t *)new_forasync_task);
-        //continue to work on the half task
-        forasync1D_recursive(forasync_arg);
-    } else {
-        //compute the tile
-        forasync1D_runner(forasync_arg);
-    }
+static void forasync_recursive(void *forasync_arg);
+
+static void forasync_recursive_task(void *forasync_arg) {
+    forasync_body_t *body = ((forasyncND_t *) forasync_arg)->base.body;
+    forasync_recursive(forasync_arg);
+    forasync_body_put(body);
 }
 
-void forasync2D_recursive(void *forasync_arg) {
-    forasync2D_t *forasync = (forasync2D_t *) forasync_arg;
-    loop_domain_t loop0 = forasync->loop0;
-    int high0 = loop0.high;
-    int low0 = loop0.low;
-    int stride0 = loop0.stride;
-    int tile0 = loop0.tile;
-    loop_domain_t loop1 = forasync->loop1;
-    int high1 = loop1.high;
-    int low1 = loop1.low;
-    int stride1 = loop1.stride;
-    int tile1 = loop1.tile;
-
-    //split the range into two, spawn a new task for the first half and recurse on the rest
-    forasync2D_task_t *new_forasync_task = NULL;
-    if((high0-low0) > tile0) {
-        int mid = (high0+low0)/2;
-        // upper-half
-        new_forasync_task = allocate_forasync2D_task();
-        new_forasync_task->forasync_task._fp = forasync2D_recursive;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        loop_domain_t new_loop0 = {mid, high0, stride0, tile0};;
-        new_forasync_task->def.loop0 = new_loop0;
-        new_forasync_task->def.loop1 = loop1;
-        // update lower-half
-        forasync->loop0.high = mid;
-    } else if((high1-low1) > tile1) {
-        int mid = (high1+low1)/2;
-        // upper-half
-        new_forasync_task = allocate_forasync2D_task();
-        new_forasync_task->forasync_task._fp = forasync2D_recursive;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        new_forasync_task->def.loop0 = loop0;
-        loop_domain_t new_loop1 = {mid, high1, stride1, tile1};
-        new_forasync_task->def.loop1 = new_loop1;
-        // update lower-half
-        forasync->loop1.high = mid;
-    }
-    // recurse
-    if(new_forasync_task != NULL) {
+/*
+ * Recursively split the longest dimension that is still larger than its tile,
+ * handing the upper half to the runtime and keeping the lower half.
+ */
+static void forasync_recursive(void *forasync_arg) {
+    forasyncND_t *forasync = (forasyncND_t *) forasync_arg;
+
+    while (1) {
+        int split = -1;
+        int64_t longest = 0;
+        for (int d = 0; d < forasync->dim; d++) {
+            const loop_domain64_t *loop = &forasync->loop[d];
+            const int64_t extent = loop->high - loop->low;
+            if (extent > loop->tile && extent > longest &&
+                    loop_domain_count(loop) > 1) {
+                split = d;
+                longest = extent;
+            }
+        }
+        if (split < 0) break;
+
+        const int64_t mid = loop_domain_mid(&forasync->loop[split]);
+        forasyncND_task_t *new_forasync_task = allocate_forasyncND_task(
+                forasync, forasync_recursive_task);
+        new_forasync_task->def.loop[split].low = mid;
+        forasync->loop[split].high = mid;
         // delegate scheduling to the underlying runtime
-        //TODO can we make this a special async to avoid a get_current_async ?
         spawn((hclib_task_t *)new_forasync_task);
-        //continue to work on the half task
-        forasync2D_recursive(forasync_arg);
-    } else { //compute the tile
-        forasync2D_runner(forasync_arg);
     }
+
+    //compute the tile
+    forasync_runner(forasync_arg);
 }
 
-void forasync3D_recursive(void *forasync_arg) {
-    forasync3D_t *forasync = (forasync3D_t *) forasync_arg;
-    loop_domain_t loop0 = forasync->loop0;
-    int high0 = loop0.high;
-    int low0 = loop0.low;
-    int stride0 = loop0.stride;
-    int tile0 = loop0.tile;
-    loop_domain_t loop1 = forasync->loop1;
-    int high1 = loop1.high;
-    int low1 = loop1.low;
-    int stride1 = loop1.stride;
-    int tile1 = loop1.tile;
-    loop_domain_t loop2 = forasync->loop2;
-    int high2 = loop2.high;
-    int low2 = loop2.low;
-    int stride2 = loop2.stride;
-    int tile2 = loop2.tile;
-
-    //split the range into two, spawn a new task for the first half and recurse on the rest
-    forasync3D_task_t *new_forasync_task = NULL;
-    if((high0-low0) > tile0) {
-        int mid = (high0+low0)/2;
-        // upper-half
-        new_forasync_task = allocate_forasync3D_task();
-        new_forasync_task->forasync_task._fp = forasync3D_recursive;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        loop_domain_t new_loop0 = {mid, high0, stride0, tile0};
-        new_forasync_task->def.loop0 = new_loop0;
-        new_forasync_task->def.loop1 = loop1;
-        new_forasync_task->def.loop2 = loop2;
-        // update lower-half
-        forasync->loop0.high = mid;
-    } else if((high1-low1) > tile1) {
-        int mid = (high1+low1)/2;
-        // upper-half
-        new_forasync_task = allocate_forasync3D_task();
-        new_forasync_task->forasync_task._fp = forasync3D_recursive;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        new_forasync_task->def.loop0 = loop0;
-        loop_domain_t new_loop1 = {mid, high1, stride1, tile1};
-        new_forasync_task->def.loop1 = new_loop1;
-        new_forasync_task->def.loop2 = loop2;
-        // update lower-half
-        forasync->loop1.high = mid;
-    } else if((high2-low2) > tile2) {
-        int mid = (high2+low2)/2;
-        // upper-half
-        new_forasync_task = allocate_forasync3D_task();
-        new_forasync_task->forasync_task._fp = forasync3D_recursive;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        new_forasync_task->def.loop0 = loop0;
-        new_forasync_task->def.loop1 = loop1;
-        loop_domain_t new_loop2 = {mid, high2, stride2, tile2};
-        new_forasync_task->def.loop2 = new_loop2;
-        // update lower-half
-        forasync->loop2.high = mid;
-    }
-    // recurse
-    if(new_forasync_task != NULL) {
-        // delegate scheduling to the underlying runtime
-        //TODO can we make this a special async to avoid a get_current_async ?
-        spawn((hclib_task_t *)new_forasync_task);
-        //continue to work on the half task
-        forasync3D_recursive(forasync_arg);
-    } else { //compute the tile
-        forasync3D_runner(forasync_arg);
+/*
+ * Spawn one task per tile up front.
+ */
+static void forasync_flat(forasyncND_t *forasync) {
+    const int dim = forasync->dim;
+    const loop_domain64_t *loop = forasync->loop;
+    int64_t step[HCLIB_FORASYNC_MAX_DIM];
+    forasyncND_t tile;
+
+    if (forasync_count(forasync) == 0) return;
+
+    memcpy(&tile, forasync, forasync_def_size(dim));
+    for (int d = 0; d < dim; d++) {
+        // tiles are rounded up to a whole number of strides
+        const int64_t size = loop[d].tile > 0 ? loop[d].tile :
+            loop[d].high - loop[d].low;
+        step[d] = ((size + loop[d].stride - 1) / loop[d].stride) *
+            loop[d].stride;
     }
-}
 
-void forasync1D_flat(void *forasync_arg) {
-    forasync1D_t *forasync = (forasync1D_t *) forasync_arg;
-    loop_domain_t loop0 = forasync->loop0;
-    int high0 = loop0.high;
-    int stride0 = loop0.stride;
-    int tile0 = loop0.tile;
-    int nb_chunks = (int) (high0/tile0);
-    int size = tile0*nb_chunks;
-    int low0;
-    for(low0 = loop0.low; low0<size; low0+=tile0) {
+    int d;
+    do {
+        for (d = 0; d < dim; d++) {
+            const int64_t high = tile.loop[d].low + step[d];
+            tile.loop[d].high = high > loop[d].high ? loop[d].high : high;
+        }
 #if DEBUG_FORASYNC
-        printf("Scheduling Task %d %d\n",low0,(low0+tile0));
+        printf("Scheduling Task %ld %ld\n", (long) tile.loop[0].low,
+                (long) tile.loop[0].high);
 #endif
         //TODO block allocation ?
-        forasync1D_task_t *new_forasync_task = allocate_forasync1D_task();
-        new_forasync_task->forasync_task._fp = forasync1D_runner;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        loop_domain_t new_loop0 = {low0, low0+tile0, stride0, tile0};
-        new_forasync_task->def.loop0 = new_loop0;
-        spawn((hclib_task_t *)new_forasync_task);
-    }
-    // handling leftover
-    if (size < high0) {
-#if DEBUG_FORASYNC
-        printf("Scheduling Task %d %d\n",low0,high0);
-#endif
-        forasync1D_task_t *new_forasync_task = allocate_forasync1D_task();
-        new_forasync_task->forasync_task._fp = forasync1D_runner;
-        new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-        new_forasync_task->forasync_task.future_list = NULL;
-        new_forasync_task->def.base.user = forasync->base.user;
-        loop_domain_t new_loop0 = {low0, high0, loop0.stride, loop0.tile};
-        new_forasync_task->def.loop0 = new_loop0;
-        spawn((hclib_task_t *)new_forasync_task);
-    }
+        spawn((hclib_task_t *)allocate_forasyncND_task(&tile,
+                    forasync_runner_task));
+
+        // odometer over the tile origins, innermost fastest
+        for (d = dim - 1; d >= 0; d--) {
+            tile.loop[d].low += step[d];
+            if (tile.loop[d].low < loop[d].high) break;
+            tile.loop[d].low = loop[d].low;
+        }
+    } while (d >= 0);
 }
 
-void forasync2D_flat(void *forasync_arg) {
-    forasync2D_t *forasync = (forasync2D_t *) forasync_arg;
-    loop_domain_t loop0 = forasync->loop0;
-    loop_domain_t loop1 = forasync->loop1;
-    int low0, low1;
-    for(low0=loop0.low; low0<loop0.high; low0+=loop0.tile) {
-        int high0 = (low0+loop0.tile)>loop0.high?loop0.high:(low0+loop0.tile);
-#if DEBUG_FORASYNC
-        printf("Scheduling Task Loop1 %d %d\n",low0,high0);
-#endif
-        for(low1=loop1.low; low1<loop1.high; low1+=loop1.tile) {
-            int high1 = (low1+loop1.tile)>loop1.high?loop1.high:(low1+loop1.tile);
-#if DEBUG_FORASYNC
-            printf("Scheduling Task %d %d\n",low1,high1);
-#endif
-            forasync2D_task_t *new_forasync_task = allocate_forasync2D_task();
-            new_forasync_task->forasync_task._fp = forasync2D_runner;
-            new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-            new_forasync_task->forasync_task.future_list = NULL;
-            new_forasync_task->def.base.user = forasync->base.user;
-            loop_domain_t new_loop0 = {low0, high0, loop0.stride, loop0.tile};
-            new_forasync_task->def.loop0 = new_loop0;
-            loop_domain_t new_loop1 = {low1, high1, loop1.stride, loop1.tile};
-            new_forasync_task->def.loop1 = new_loop1;
-            spawn((hclib_task_t *)new_forasync_task);
+/*
+ * Adaptive forasync, based on lazy binary splitting: a task works through its
+ * domain a few iterations at a time and only splits off half of what remains
+ * as a new task when the local deque has run dry (i.e. when there is nothing
+ * left locally for thieves to steal). No user-provided tile size is needed.
+ */
+
+static inline int local_deque_is_empty() {
+    return deque_size(&CURRENT_WS_INTERNAL->current->deque) <= 0;
+}
+
+static void forasync_adaptive(void *forasync_arg);
+
+static void forasync_adaptive_task(void *forasync_arg) {
+    forasync_body_t *body = ((forasyncND_t *) forasync_arg)->base.body;
+    forasync_adaptive(forasync_arg);
+    forasync_body_put(body);
+}
+
+/*
+ * Split the longest dimension in half, hand the upper half to the runtime and
+ * keep the lower half.
+ */
+static void forasync_adaptive_split(forasyncND_t *forasync) {
+    int longest = 0;
+    for (int d = 1; d < forasync->dim; d++) {
+        if (loop_domain_count(&forasync->loop[d]) >
+                loop_domain_count(&forasync->loop[longest])) {
+            longest = d;
         }
     }
+    loop_domain64_t *split = &forasync->loop[longest];
+    const int64_t mid = loop_domain_mid(split);
+
+    forasyncND_task_t *new_forasync_task = allocate_forasyncND_task(forasync,
+            forasync_adaptive_task);
+    new_forasync_task->def.loop[longest].low = mid;
+    split->high = mid;
+    spawn((hclib_task_t *)new_forasync_task);
 }
 
-void forasync3D_flat(void *forasync_arg) {
-    forasync3D_t *forasync = (forasync3D_t *) forasync_arg;
-    loop_domain_t loop0 = forasync->loop0;
-    loop_domain_t loop1 = forasync->loop1;
-    loop_domain_t loop2 = forasync->loop2;
-    int low0, low1, low2;
-    for(low0=loop0.low; low0<loop0.high; low0+=loop0.tile) {
-        int high0 = (low0+loop0.tile)>loop0.high?loop0.high:(low0+loop0.tile);
-#if DEBUG_FORASYNC
-        printf("Scheduling Task Loop1 %d %d\n",low0,high0);
-#endif
-        for(low1=loop1.low; low1<loop1.high; low1+=loop1.tile) {
-            int high1 = (low1+loop1.tile)>loop1.high?loop1.high:(low1+loop1.tile);
-#if DEBUG_FORASYNC
-            printf("Scheduling Task Loop2 %d %d\n",low1,high1);
-#endif
-            for(low2=loop2.low; low2<loop2.high; low2+=loop2.tile) {
-                int high2 = (low2+loop2.tile)>loop2.high?loop2.high:(low2+loop2.tile);
-#if DEBUG_FORASYNC
-                printf("Scheduling Task %d %d\n",low2,high2);
-#endif
-                forasync3D_task_t *new_forasync_task = allocate_forasync3D_task();
-                new_forasync_task->forasync_task._fp = forasync3D_runner;
-                new_forasync_task->forasync_task.args = &(new_forasync_task->def);
-                new_forasync_task->forasync_task.future_list = NULL;
-                new_forasync_task->def.base.user = forasync->base.user;
-                loop_domain_t new_loop0 = {low0, high0, loop0.stride, loop0.tile};
-                new_forasync_task->def.loop0 = new_loop0;
-                loop_domain_t new_loop1 = {low1, high1, loop1.stride, loop1.tile};
-                new_forasync_task->def.loop1 = new_loop1;
-                loop_domain_t new_loop2 = {low2, high2, loop2.stride, loop2.tile};
-                new_forasync_task->def.loop2 = new_loop2;
-                spawn((hclib_task_t *)new_forasync_task);
-            }
+static void forasync_adaptive(void *forasync_arg) {
+    forasyncND_t *forasync = (forasyncND_t *) forasync_arg;
+
+    while (forasync_count(forasync) > FORASYNC_ADAPTIVE_CHUNK) {
+        if (local_deque_is_empty()) {
+            forasync_adaptive_split(forasync);
+            continue;
         }
+
+        /*
+         * Peel a slab of about FORASYNC_ADAPTIVE_CHUNK iterations off the
+         * front of the outermost dimension that has more than one iteration
+         * left. If a single step of that dimension is already too large, the
+         * slab is itself processed adaptively.
+         */
+        int d = 0;
+        while (loop_domain_count(&forasync->loop[d]) == 1) d++;
+        int64_t inner = 1;
+        for (int e = d + 1; e < forasync->dim; e++) {
+            inner *= loop_domain_count(&forasync->loop[e]);
+        }
+        int64_t steps = FORASYNC_ADAPTIVE_CHUNK / inner;
+        if (steps < 1) steps = 1;
+
+        forasyncND_t slab;
+        memcpy(&slab, forasync, forasync_def_size(forasync->dim));
+        loop_domain64_t *peel = &forasync->loop[d];
+        slab.loop[d].high = peel->low + steps * peel->stride;
+        if (slab.loop[d].high > peel->high) slab.loop[d].high = peel->high;
+        peel->low = slab.loop[d].high;
+
+        if (inner > FORASYNC_ADAPTIVE_CHUNK) {
+            forasync_adaptive(&slab);
+        } else {
+            forasync_runner(&slab);
+        }
+    }
+
+    if (forasync_count(forasync) > 0) {
+        forasync_runner(forasync);
+    }
+}
+
+static void forasync_run(forasync_body_t *body, int dim,
+                         const loop_domain64_t *loop_domain,
+                         forasync_mode_t mode) {
+    HASSERT(dim > 0 && dim <= HCLIB_FORASYNC_MAX_DIM);
+    forasyncND_t forasync;
+    forasync.base.body = body;
+    forasync.dim = dim;
+    for (int d = 0; d < dim; d++) {
+        HASSERT(loop_domain[d].stride > 0);
+        forasync.loop[d] = loop_domain[d];
+    }
+
+    if (mode == FORASYNC_MODE_ADAPTIVE) {
+        forasync_adaptive(&forasync);
+    } else if (mode == FORASYNC_MODE_RECURSIVE) {
+        forasync_recursive(&forasync);
+    } else {
+        forasync_flat(&forasync);
+    }
+
+    // drop the reference held by this call, if any task ever shared the body
+    if (body->shared) {
+        forasync_body_put(body->shared);
     }
 }
 
 static void forasync_internal(void *user_fct_ptr, void *user_arg,
-                              int dim, const loop_domain_t *loop_domain,
-                              forasync_mode_t mode) {
-    // All the sub-asyncs share async_def
-
-    // The user loop code to execute
-    hclib_task_t *user_def = (hclib_task_t *)malloc(sizeof(hclib_task_t));
-    HASSERT(user_def);
-    user_def->_fp = user_fct_ptr;
-    user_def->args = user_arg;
-    user_def->future_list = NULL;
-    user_def->place = NULL;
+                              int dim, const loop_domain64_t *loop_domain,
+                              forasync_mode_t mode, forasync_kind_t kind) {
+    // The user loop code to execute, shared by all the sub-asyncs. It stays
+    // on the stack unless some of them are spawned.
+    forasync_body_t body;
+    body.fct = user_fct_ptr;
+    body.arg = user_arg;
+    body.kind = kind;
+    body.release = NULL;
+    body.refcount = 1;
+    body.shared = NULL;
+    forasync_run(&body, dim, loop_domain, mode);
+}
 
+/*
+ * Whether a body of this kind can iterate over dim dimensions: the 1D, 2D and
+ * 3D kinds take exactly that many indices, and a range body is handed at most
+ * three dimensions of a 32-bit tile.
+ */
+static int forasync_kind_fits(forasync_kind_t kind, int dim) {
+    switch (kind) {
+    case FORASYNC_KIND_1D:
+    case FORASYNC_KIND_2D:
+    case FORASYNC_KIND_3D:
+        return dim == kind - FORASYNC_KIND_1D + 1;
+    case FORASYNC_KIND_RANGE:
+        return dim >= 1 && dim <= 3;
+    case FORASYNC_KIND_ND:
+    case FORASYNC_KIND_ND_RANGE:
+        return dim >= 1 && dim <= HCLIB_FORASYNC_MAX_DIM;
+    default:
+        return 0;
+    }
+}
+
+void hclib_forasync_body(forasync_body_t *body, int dim,
+                         const loop_domain64_t *domain,
+                         forasync_mode_t mode) {
+    check_log_die(!forasync_kind_fits(body->kind, dim),
+                  "forasync body of kind %d cannot iterate over %d dimensions",
+                  (int) body->kind, dim);
+    body->refcount = 1;
+    body->shared = body;
+    forasync_run(body, dim, domain, mode);
+}
+
+/*
+ * Shim from the 32-bit, 1 to 3 dimensional interface to the generic engine.
+ */
+static void forasync_internal_3D(void *user_fct_ptr, void *user_arg,
+                                 int dim, const loop_domain_t *loop_domain,
+                                 forasync_mode_t mode, forasync_kind_t kind) {
     HASSERT(dim>0 && dim<4);
-    // TODO put those somewhere as static
-    asyncFct_t fct_ptr_rec[3] = { forasync1D_recursive, forasync2D_recursive,
-                                  forasync3D_recursive
-                                };
-    asyncFct_t fct_ptr_flat[3] = { forasync1D_flat, forasync2D_flat,
-                                   forasync3D_flat
-                                 };
-    asyncFct_t *fct_ptr = (mode == FORASYNC_MODE_RECURSIVE) ? fct_ptr_rec :
-                          fct_ptr_flat;
-    if (dim == 1) {
-        forasync1D_t forasync = {{user_def}, loop_domain[0]};
-        (fct_ptr[dim-1])((void *) &forasync);
-    } else if (dim == 2) {
-        forasync2D_t forasync = {{user_def}, loop_domain[0], loop_domain[1]};
-        (fct_ptr[dim-1])((void *) &forasync);
-    } else if (dim == 3) {
-        forasync3D_t forasync = {{user_def}, loop_domain[0], loop_domain[1], loop_domain[2]};
-        (fct_ptr[dim-1])((void *) &forasync);
+    loop_domain64_t domain[3];
+    for (int d = 0; d < dim; d++) {
+        domain[d].low = loop_domain[d].low;
+        domain[d].high = loop_domain[d].high;
+        domain[d].stride = loop_domain[d].stride;
+        domain[d].tile = loop_domain[d].tile;
     }
+    forasync_internal(user_fct_ptr, user_arg, dim, domain, mode, kind);
 }
 
 void hclib_forasync(void *forasync_fct, void *argv,
@@ -478,7 +564,8 @@ void hclib_forasync(void *forasync_fct, void *argv,
     HASSERT(future_list == NULL &&
             "Limitation: forasync does not support futures yet");
 
-    forasync_internal(forasync_fct, argv, dim, domain, mode);
+    forasync_internal_3D(forasync_fct, argv, dim, domain, mode,
+                         (forasync_kind_t) (FORASYNC_KIND_1D + dim - 1));
 }
 
 hclib_future_t *hclib_forasync_future(void *forasync_fct, void *argv,
@@ -491,6 +578,68 @@ hclib_future_t *hclib_forasync_future(void *forasync_fct, void *argv,
     return hclib_end_finish_nonblocking();
 }
 
+void hclib_forasync_range(forasync_range_Fct_t forasync_fct, void *argv,
+                          hclib_future_t **future_list, int dim,
+                          const loop_domain_t *domain,
+                          forasync_mode_t mode) {
+    HASSERT(future_list == NULL &&
+            "Limitation: forasync does not support futures yet");
+
+    forasync_internal_3D((void *) forasync_fct, argv, dim, domain, mode,
+                         FORASYNC_KIND_RANGE);
+}
+
+hclib_future_t *hclib_forasync_range_future(forasync_range_Fct_t forasync_fct,
+        void *argv, hclib_future_t **future_list, int dim,
+        const loop_domain_t *domain, forasync_mode_t mode) {
+
+    hclib_start_finish();
+    hclib_forasync_range(forasync_fct, argv, future_list, dim, domain, mode);
+    return hclib_end_finish_nonblocking();
+}
+
+void hclib_forasync_nd(forasyncND_Fct_t forasync_fct, void *argv,
+                       hclib_future_t **future_list, int dim,
+                       const loop_domain64_t *domain,
+                       forasync_mode_t mode) {
+    HASSERT(future_list == NULL &&
+            "Limitation: forasync does not support futures yet");
+
+    forasync_internal((void *) forasync_fct, argv, dim, domain, mode,
+                      FORASYNC_KIND_ND);
+}
+
+hclib_future_t *hclib_forasync_nd_future(forasyncND_Fct_t forasync_fct,
+        void *argv, hclib_future_t **future_list, int dim,
+        const loop_domain64_t *domain, forasync_mode_t mode) {
+
+    hclib_start_finish();
+    hclib_forasync_nd(forasync_fct, argv, future_list, dim, domain, mode);
+    return hclib_end_finish_nonblocking();
+}
+
+void hclib_forasync_nd_range(forasyncND_range_Fct_t forasync_fct, void *argv,
+                             hclib_future_t **future_list, int dim,
+                             const loop_domain64_t *domain,
+                             forasync_mode_t mode) {
+    HASSERT(future_list == NULL &&
+            "Limitation: forasync does not support futures yet");
+
+    forasync_internal((void *) forasync_fct, argv, dim, domain, mode,
+                      FORASYNC_KIND_ND_RANGE);
+}
+
+hclib_future_t *hclib_forasync_nd_range_future(
+        forasyncND_range_Fct_t forasync_fct, void *argv,
+        hclib_future_t **future_list, int dim, const loop_domain64_t *domain,
+        forasync_mode_t mode) {
+
+    hclib_start_finish();
+    hclib_forasync_nd_range(forasync_fct, argv, future_list, dim, domain,
+                            mode);
+    return hclib_end_finish_nonblocking();
+}
+
 
 /*** END FORASYNC IMPLEMENTATION ***/
 
@@ -14,8 +14,15 @@
  * limitations under the License.
  */
 
+#include <cxxabi.h>
+
 #include "hclib.hpp"
 
+extern "C" char *hclib_demangle(const char *name) {
+    int status;
+    return abi::__cxa_demangle(name, nullptr, nullptr, &status);
+}
+
 hclib_worker_state *hclib::current_ws() {
     return CURRENT_WS_INTERNAL;
 }
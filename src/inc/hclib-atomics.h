@@ -18,6 +18,7 @@
 #define HCLIB_ATOMICS_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef HAVE_C11_STDATOMIC
 
@@ -55,6 +56,11 @@ static inline int _hclib_atomic_inc_acq_rel(_Atomic int *target) {
     return atomic_fetch_add_explicit(target, 1, memory_order_acq_rel) + 1;
 }
 
+static inline int _hclib_atomic_add_acquire(_Atomic int *target, int value) {
+    return atomic_fetch_add_explicit(target, value, memory_order_acquire) +
+        value;
+}
+
 static inline int _hclib_atomic_dec_relaxed(_Atomic int *target) {
     return atomic_fetch_sub_explicit(target, 1, memory_order_relaxed) - 1;
 }
@@ -72,6 +78,37 @@ static inline bool _hclib_atomic_cas_acq_rel(_Atomic int *target, int expected,
             memory_order_acq_rel, memory_order_relaxed);
 }
 
+static inline void *_hclib_atomic_load_ptr_acquire(void * _Atomic *target) {
+    return atomic_load_explicit(target, memory_order_acquire);
+}
+
+static inline void *_hclib_atomic_exchange_ptr_acq_rel(void * _Atomic *target,
+        void *value) {
+    return atomic_exchange_explicit(target, value, memory_order_acq_rel);
+}
+
+static inline bool _hclib_atomic_cas_ptr_acq_rel(void * _Atomic *target,
+        void *expected, void *desired) {
+    return atomic_compare_exchange_strong_explicit(target, &expected, desired,
+            memory_order_acq_rel, memory_order_relaxed);
+}
+
+static inline void _hclib_atomic_fence_acquire() {
+    atomic_thread_fence(memory_order_acquire);
+}
+
+static inline void _hclib_atomic_add_u64_relaxed(_Atomic uint64_t *target,
+        uint64_t value) {
+    atomic_fetch_add_explicit(target, value, memory_order_relaxed);
+}
+
+static inline void _hclib_atomic_max_u64_relaxed(_Atomic uint64_t *target,
+        uint64_t value) {
+    uint64_t current = atomic_load_explicit(target, memory_order_relaxed);
+    while (current < value && !atomic_compare_exchange_weak_explicit(target,
+                &current, value, memory_order_relaxed, memory_order_relaxed));
+}
+
 #else /* !HAVE_C11_STDATOMIC */
 
 #warning "Missing C11 atomics support, falling back to gcc atomics."
@@ -115,6 +152,10 @@ static inline int _hclib_atomic_inc_acq_rel(_Atomic int *target) {
     return __sync_add_and_fetch(target, 1);
 }
 
+static inline int _hclib_atomic_add_acquire(_Atomic int *target, int value) {
+    return __sync_add_and_fetch(target, value);
+}
+
 static inline int _hclib_atomic_dec_relaxed(_Atomic int *target) {
     return __sync_sub_and_fetch(target, 1);
 }
@@ -133,6 +174,45 @@ static inline bool _hclib_atomic_cas_acq_rel(_Atomic int *target, int expected,
     return __sync_val_compare_and_swap(target, expected, desired) == expected;
 }
 
+static inline void *_hclib_atomic_load_ptr_acquire(void * _Atomic *target) {
+    void *res = *target;
+    __sync_synchronize(); // acquire after read
+    return res;
+}
+
+static inline void *_hclib_atomic_exchange_ptr_acq_rel(void * _Atomic *target,
+        void *value) {
+    __sync_synchronize(); // __sync_lock_test_and_set is only an acquire
+    return __sync_lock_test_and_set(target, value);
+}
+
+static inline bool _hclib_atomic_cas_ptr_acq_rel(void * _Atomic *target,
+        void *expected, void *desired) {
+    return __sync_val_compare_and_swap(target, expected, desired) == expected;
+}
+
+static inline void _hclib_atomic_fence_acquire() {
+    __sync_synchronize();
+}
+
+static inline void _hclib_atomic_add_u64_relaxed(_Atomic uint64_t *target,
+        uint64_t value) {
+    __sync_fetch_and_add(target, value);
+}
+
+static inline void _hclib_atomic_max_u64_relaxed(_Atomic uint64_t *target,
+        uint64_t value) {
+    uint64_t current = *target;
+    while (current < value) {
+        const uint64_t seen = __sync_val_compare_and_swap(target, current,
+                value);
+        if (seen == current) {
+            break;
+        }
+        current = seen;
+    }
+}
+
 #endif /* HAVE_C11_STDATOMIC */
 
 #endif /* HCLIB_ATOMICS_H_ */
@@ -33,7 +33,9 @@ typedef struct deque_t {
 } deque_t;
 
 int deque_push(deque_t *deq, hclib_task_t *entry);
+int deque_push_n(deque_t *deq, hclib_task_t **entries, int n);
 hclib_task_t* deque_pop(deque_t *deq);
 hclib_task_t* deque_steal(deque_t *deq);
+int deque_size(deque_t *deq);
 
 #endif /* HCLIB_DEQUE_H_ */
@@ -23,6 +23,10 @@
 typedef struct finish_t {
     struct finish_t* parent;
     _Atomic int counter;
+    struct hclib_accum_st *accums; // combined once counter reaches zero
+    struct hclib_cancel_token_st *cancel; // inherited by nested finishes
+    void * _Atomic scratch; // per-worker arenas, freed once counter reaches zero
+    struct hclib_workspan_scope_st *workspan; // only while profiling
 #if HCLIB_LITECTX_STRATEGY
     hclib_future_t ** finish_deps;
 #endif /* HCLIB_LITECTX_STRATEGY */
@@ -54,6 +54,19 @@
 // Default value of a promise datum
 #define UNINITIALIZED_PROMISE_DATA_PTR NULL
 
+/*
+ * Task property for tasks whose memory is not owned by the runtime (e.g. the
+ * tasks of a graph), and which are not freed once run.
+ */
+#define PERSISTENT_TASK ((int) 0x100)
+// Task property for tasks sampled by the task profiler, see hclib-profile.c
+#define SAMPLED_TASK ((int) 0x200)
+
+// Bound on the nesting of INLINE_ASYNC tasks run in place on a worker
+#ifndef HCLIB_MAX_INLINE_DEPTH
+#define HCLIB_MAX_INLINE_DEPTH 16
+#endif
+
 // For waiting frontier (last element of the list)
 #define SATISFIED_FUTURE_WAITLIST_PTR NULL
 #define SENTINEL_FUTURE_WAITLIST_PTR ((void*) -1)
@@ -108,9 +121,122 @@ int get_current_worker();
 // promise
 int register_on_all_promise_dependencies(hclib_task_t *task);
 void try_schedule_async(hclib_task_t * async_task, hclib_worker_state *ws);
+void schedule_ready_tasks(hclib_task_t **tasks, int ntasks);
+
+// for work checked in to a finish outside of any task
+void hclib_check_out_finish(struct finish_t *finish);
+
+// phasers
+struct hclib_phaser_reg_t *hclib_phased_register(hclib_phased_t *phased_clause,
+        int property);
+void hclib_phaser_drop_all(struct hclib_phaser_reg_t *regs);
+void hclib_phaser_drop_scope(struct finish_t *finish);
+
+// accumulators
+void hclib_accum_combine_all(struct finish_t *finish);
+
+// task graphs
+extern _Atomic int hclib_ncaptures; // graphs being captured
+// owner of the handles of recorded tasks, which can not be waited on
+extern hclib_promise_t hclib_graph_handle_owner;
+hclib_future_t *hclib_graph_record(generic_frame_ptr fp, futureFct_t future_fp,
+        void *arg, hclib_future_t **future_list, place_t *place, int property);
+
+// asynchronous I/O
+extern _Atomic int hclib_io_pending; // operations not completed yet
+void hclib_io_init();
+void hclib_io_cleanup();
+int hclib_io_poll();
+
+// scratch memory
+void hclib_scratch_init();
+void hclib_scratch_cleanup();
+void hclib_scratch_release(struct finish_t *finish);
+
+// work/span profiling, see hclib-workspan.h
+extern int hclib_workspan_enabled;
+void hclib_workspan_init();
+void hclib_workspan_cleanup();
+void hclib_workspan_report();
+void hclib_workspan_spawn(hclib_task_t *task);
+// returns the frame of the task the new one runs nested in, if any
+hclib_workspan_t *hclib_workspan_begin_task(hclib_task_t *task);
+void hclib_workspan_end_task(hclib_task_t *task, hclib_workspan_t *caller);
+// the task running on this worker is about to block, returns its frame
+hclib_workspan_t *hclib_workspan_suspend();
+// and resumes here after the put on promise
+void hclib_workspan_join(hclib_workspan_t *frame, hclib_promise_t *promise);
+void hclib_workspan_start_finish(struct finish_t *finish, void *site);
+void hclib_workspan_end_finish(struct finish_t *finish,
+        hclib_workspan_t *frame);
+void hclib_workspan_end_finish_nonblocking(struct finish_t *finish);
+void hclib_workspan_check_out(struct finish_t *finish,
+        hclib_promise_t *promise);
+void hclib_workspan_put(hclib_promise_t *promise);
+// the put on promise must come after the one on input
+void hclib_workspan_gather(hclib_promise_t *promise, hclib_promise_t *input);
+void hclib_workspan_forget(hclib_promise_t *promise);
+
+// task profiling, see hclib-profile.h
+typedef struct hclib_profile_sample_st {
+    void *fn; // see hclib_task_function
+    uint64_t start;
+    uint64_t queued;
+    int stolen;
+    // running nested tasks or blocked, which is not counted
+    uint64_t excluded;
+    uint64_t suspended_at;
+} hclib_profile_sample_t;
+
+extern int hclib_profile_enabled;
+void hclib_profile_init();
+void hclib_profile_cleanup();
+void hclib_profile_report();
+uint64_t hclib_profile_now();
+// a task made ready by the worker is sampled
+void hclib_profile_sample(hclib_worker_state *ws, hclib_task_t *task);
+// returns the worker that sampled the task and when, -1 if none did
+int hclib_profile_claim(hclib_worker_state *ws, hclib_task_t *task,
+        uint64_t *ready_at);
+void hclib_profile_record(hclib_worker_state *ws,
+        const hclib_profile_sample_t *sample, uint64_t end);
+// the user function run by the task, rather than a wrapper of the runtime
+void *hclib_task_function(hclib_task_t *task);
+// of a C++ symbol or type name, to be freed, NULL if it is not one
+char *hclib_demangle(const char *name);
+
+// cancellation
+struct hclib_cancel_token_st {
+    _Atomic int cancelled;
+    struct hclib_cancel_token_st *parent; // of the enclosing finish, if any
+};
+
+static inline int _hclib_cancel_token_is_cancelled(
+        struct hclib_cancel_token_st *token) {
+    for (; token; token = token->parent) {
+        if (_hclib_atomic_load_relaxed(&token->cancelled)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// delayed and periodic tasks
+extern _Atomic int hclib_timers_pending; // timers in the wheel
+void hclib_timer_wheel_init();
+int hclib_timer_wheel_poll();
+
+/*
+ * The fields of hclib_promise_t are declared volatile in the public header,
+ * which is shared with C++, and are accessed atomically through these casts.
+ */
+static inline void * _Atomic *_hclib_promise_wait_list(hclib_promise_t *p) {
+    return (void * _Atomic *) &p->wait_list_head;
+}
 
 int static inline _hclib_promise_is_satisfied(hclib_promise_t *p) {
-    return p->wait_list_head == SATISFIED_FUTURE_WAITLIST_PTR;
+    return _hclib_atomic_load_ptr_acquire(_hclib_promise_wait_list(p)) ==
+        SATISFIED_FUTURE_WAITLIST_PTR;
 }
 
 #endif /* HCLIB_INTERNAL_H_ */
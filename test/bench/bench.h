@@ -0,0 +1,49 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hclib.h"
+
+static inline double bench_now_ns() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*
+ * Iteration count of a benchmark, scaled by the optional first argument.
+ */
+static inline long bench_iterations(int argc, char **argv, long iterations) {
+    const double scale = argc > 1 ? atof(argv[1]) : 1.0;
+    return iterations * scale > 1 ? (long) (iterations * scale) : 1;
+}
+
+/*
+ * One CSV row of results: benchmark,workers,parameter,value,unit
+ */
+static inline void bench_report(const char *benchmark, const char *parameter,
+        double value, const char *unit) {
+    printf("%s,%d,%s,%.3f,%s\n", benchmark, hclib_num_workers(), parameter,
+            value, unit);
+}
+
+#endif /* BENCH_H_ */
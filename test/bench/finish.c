@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * Overhead of a finish scope around fan-out empty tasks, per scope.
+ */
+
+#include "bench.h"
+
+static long nscopes;
+
+static void empty(void *arg) {
+}
+
+void entrypoint(void *arg) {
+    const int fanouts[] = { 0, 1, 4, 16, 64, 256 };
+    for (int f = 0; f < sizeof(fanouts) / sizeof(fanouts[0]); f++) {
+        const long n = nscopes / (fanouts[f] + 1) + 1;
+        const double start = bench_now_ns();
+        for (long s = 0; s < n; s++) {
+            hclib_start_finish();
+            for (int i = 0; i < fanouts[f]; i++) {
+                hclib_async(empty, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+                        NO_PROP);
+            }
+            hclib_end_finish();
+        }
+        char parameter[32];
+        snprintf(parameter, sizeof(parameter), "fanout-%d", fanouts[f]);
+        bench_report("finish", parameter, (bench_now_ns() - start) / n,
+                "ns/finish");
+    }
+}
+
+int main(int argc, char **argv) {
+    nscopes = bench_iterations(argc, argv, 1 << 20);
+    hclib_launch(entrypoint, NULL);
+    return 0;
+}
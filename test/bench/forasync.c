@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * Overhead of 1D forasync per iteration with an empty body, for each mode.
+ */
+
+#include "bench.h"
+
+static long niterations;
+
+static void empty(void *arg, int i) {
+}
+
+static void run(const char *parameter, int tile, forasync_mode_t mode) {
+    loop_domain_t loop = { 0, (int) niterations, 1, tile };
+    const double start = bench_now_ns();
+    hclib_start_finish();
+    hclib_forasync(empty, NULL, NULL, 1, &loop, mode);
+    hclib_end_finish();
+    bench_report("forasync", parameter,
+            (bench_now_ns() - start) / niterations, "ns/iteration");
+}
+
+void entrypoint(void *arg) {
+    run("recursive-1", 1, FORASYNC_MODE_RECURSIVE);
+    run("recursive-64", 64, FORASYNC_MODE_RECURSIVE);
+    // all tiles of a flat forasync are spawned at once, and must fit the deque
+    run("flat-4096-tiles", (int) (niterations + 4095) / 4096,
+            FORASYNC_MODE_FLAT);
+    run("adaptive", 1, FORASYNC_MODE_ADAPTIVE);
+}
+
+int main(int argc, char **argv) {
+    niterations = bench_iterations(argc, argv, 1 << 22);
+    hclib_launch(entrypoint, NULL);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * Promise put to await latency along a chain of tasks, each awaiting the
+ * promise put by the previous one, and fan-in of tasks awaiting many promises.
+ */
+
+#include <stdint.h>
+
+#include "bench.h"
+
+#define CHAIN 4096
+
+static long nhops;
+static hclib_promise_t **promises;
+static hclib_future_t **futures;
+
+static void hop(void *arg) {
+    const intptr_t i = (intptr_t) arg;
+    hclib_promise_put(promises[i + 1], NULL);
+}
+
+static void put(void *arg) {
+    hclib_promise_put((hclib_promise_t *) arg, NULL);
+}
+
+static void empty(void *arg) {
+}
+
+void entrypoint(void *arg) {
+    // futures[2 * i] is awaited by the hop putting promises[i + 1]
+    futures = malloc(2 * CHAIN * sizeof(*futures));
+    const long nchains = nhops / CHAIN + 1;
+    double start = bench_now_ns();
+    for (long c = 0; c < nchains; c++) {
+        promises = hclib_promise_create_n(CHAIN + 1, 0);
+        hclib_start_finish();
+        for (int i = 0; i < CHAIN; i++) {
+            futures[2 * i] = hclib_get_future_for_promise(promises[i]);
+            futures[2 * i + 1] = NULL;
+            hclib_async(hop, (void *) (intptr_t) i, &futures[2 * i],
+                    NO_PHASER, ANY_PLACE, NO_PROP);
+        }
+        hclib_promise_put(promises[0], NULL);
+        hclib_end_finish();
+        hclib_promise_free_n(promises, CHAIN + 1, 0);
+    }
+    bench_report("promise", "chain",
+            (bench_now_ns() - start) / (nchains * CHAIN), "ns/hop");
+    free(futures);
+
+    const int fanins[] = { 1, 16, 256 };
+    for (int f = 0; f < sizeof(fanins) / sizeof(fanins[0]); f++) {
+        const int k = fanins[f];
+        const long n = nhops / k + 1;
+        hclib_future_t **deps = malloc((k + 1) * sizeof(*deps));
+        start = bench_now_ns();
+        for (long r = 0; r < n; r++) {
+            promises = hclib_promise_create_n(k, 0);
+            hclib_start_finish();
+            for (int i = 0; i < k; i++) {
+                deps[i] = hclib_get_future_for_promise(promises[i]);
+            }
+            deps[k] = NULL;
+            hclib_async(empty, NULL, deps, NO_PHASER, ANY_PLACE, NO_PROP);
+            for (int i = 0; i < k; i++) {
+                hclib_async(put, promises[i], NO_FUTURE, NO_PHASER, ANY_PLACE,
+                        NO_PROP);
+            }
+            hclib_end_finish();
+            hclib_promise_free_n(promises, k, 0);
+        }
+        char parameter[32];
+        snprintf(parameter, sizeof(parameter), "fanin-%d", k);
+        bench_report("promise", parameter, (bench_now_ns() - start) / n,
+                "ns/fanin");
+        free(deps);
+    }
+}
+
+int main(int argc, char **argv) {
+    nhops = bench_iterations(argc, argv, 1 << 18);
+    hclib_launch(entrypoint, NULL);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+# Runs each benchmark with 1, 2, 4, ... and MAX_WORKERS workers, printing one
+# CSV row per measurement or a JSON array of them.
+
+if [ $# -lt 1 ]; then
+	echo "USAGE: ./run.sh <MAX_WORKERS> [csv|json] [SCALE]"
+	echo "SCALE multiplies the iterations of every benchmark"
+	exit 1
+fi
+
+MAX_WORKERS=$1
+FORMAT=${2:-csv}
+SCALE=${3:-1}
+BENCHMARKS="spawn steal finish promise wait forasync"
+
+WORKERS=""
+for ((w = 1; w < MAX_WORKERS; w *= 2)); do
+	WORKERS="$WORKERS $w"
+done
+WORKERS="$WORKERS $MAX_WORKERS"
+
+rows() {
+	for w in $WORKERS; do
+		for b in $BENCHMARKS; do
+			HCLIB_WORKERS=$w ./$b $SCALE 2> /dev/null || \
+				echo "$b failed with $w workers" >&2
+		done
+	done
+}
+
+if [ "$FORMAT" == "json" ]; then
+	rows | awk -F, '
+		BEGIN { print "[" }
+		{
+			printf "%s  {\"benchmark\": \"%s\", \"workers\": %d, ",
+				(NR > 1 ? ",\n" : ""), $1, $2
+			printf "\"parameter\": \"%s\", \"value\": %s, \"unit\": \"%s\"}",
+				$3, $4, $5
+		}
+		END { print "\n]" }'
+else
+	echo "benchmark,workers,parameter,value,unit"
+	rows
+fi
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * Spawn+execute throughput of empty tasks, spawned in batches from a single
+ * task and as a binary tree.
+ */
+
+#include <stdint.h>
+
+#include "bench.h"
+
+#define BATCH 4096
+#define DEPTH 16
+
+static long ntasks;
+
+static void empty(void *arg) {
+}
+
+static void tree(void *arg) {
+    const intptr_t depth = (intptr_t) arg;
+    if (depth > 0) {
+        hclib_async(tree, (void *) (depth - 1), NO_FUTURE, NO_PHASER,
+                ANY_PLACE, NO_PROP);
+        hclib_async(tree, (void *) (depth - 1), NO_FUTURE, NO_PHASER,
+                ANY_PLACE, NO_PROP);
+    }
+}
+
+void entrypoint(void *arg) {
+    double start = bench_now_ns();
+    for (long spawned = 0; spawned < ntasks; spawned += BATCH) {
+        // more would not fit in the deque
+        hclib_start_finish();
+        for (int i = 0; i < BATCH; i++) {
+            hclib_async(empty, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+                    NO_PROP);
+        }
+        hclib_end_finish();
+    }
+    const long nflat = (ntasks + BATCH - 1) / BATCH * BATCH;
+    bench_report("spawn", "flat", nflat / (bench_now_ns() - start) * 1e9,
+            "tasks/s");
+
+    const long ntrees = (ntasks >> (DEPTH + 1)) + 1;
+    start = bench_now_ns();
+    for (long t = 0; t < ntrees; t++) {
+        hclib_start_finish();
+        tree((void *) (intptr_t) DEPTH);
+        hclib_end_finish();
+    }
+    const long ntree = ntrees * ((2L << DEPTH) - 1);
+    bench_report("spawn", "tree", ntree / (bench_now_ns() - start) * 1e9,
+            "tasks/s");
+}
+
+int main(int argc, char **argv) {
+    ntasks = bench_iterations(argc, argv, 1 << 20);
+    hclib_launch(entrypoint, NULL);
+    return 0;
+}
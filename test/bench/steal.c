@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * Steal latency, as the round trip of a task that its spawner spins on
+ * without running it, until another worker steals and runs it.
+ */
+
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "bench.h"
+
+static long nrounds;
+static _Atomic int ran;
+
+static void pong(void *arg) {
+    atomic_store_explicit(&ran, 1, memory_order_release);
+}
+
+void entrypoint(void *arg) {
+    if (hclib_num_workers() < 2) return;
+
+    hclib_start_finish();
+    const double start = bench_now_ns();
+    for (long r = 0; r < nrounds; r++) {
+        atomic_store_explicit(&ran, 0, memory_order_relaxed);
+        hclib_async(pong, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+        for (int spins = 1; !atomic_load_explicit(&ran, memory_order_acquire);
+                spins++) {
+            // thieves may be sharing our core
+            if (spins % 1024 == 0) sched_yield();
+        }
+    }
+    bench_report("steal", "ping-pong", (bench_now_ns() - start) / nrounds,
+            "ns/steal");
+    hclib_end_finish();
+}
+
+int main(int argc, char **argv) {
+    nrounds = bench_iterations(argc, argv, 10000);
+    hclib_launch(entrypoint, NULL);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * Cost of hclib_future_wait, on a satisfied future and on one that is put by
+ * a task spawned just before, which suspends the waiting task.
+ */
+
+#include "bench.h"
+
+static long nwaits;
+
+static void put(void *arg) {
+    hclib_promise_put((hclib_promise_t *) arg, NULL);
+}
+
+void entrypoint(void *arg) {
+    hclib_promise_t *satisfied = hclib_promise_create();
+    hclib_promise_put(satisfied, NULL);
+    double start = bench_now_ns();
+    for (long w = 0; w < nwaits; w++) {
+        hclib_future_wait(hclib_get_future_for_promise(satisfied));
+    }
+    bench_report("wait", "satisfied", (bench_now_ns() - start) / nwaits,
+            "ns/wait");
+    hclib_promise_free(satisfied);
+
+    hclib_promise_t **promises = hclib_promise_create_n(nwaits, 0);
+    start = bench_now_ns();
+    hclib_start_finish();
+    for (long w = 0; w < nwaits; w++) {
+        hclib_async(put, promises[w], NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+        hclib_future_wait(hclib_get_future_for_promise(promises[w]));
+    }
+    hclib_end_finish();
+    bench_report("wait", "suspend", (bench_now_ns() - start) / nwaits,
+            "ns/wait");
+    hclib_promise_free_n(promises, nwaits, 0);
+}
+
+int main(int argc, char **argv) {
+    nwaits = bench_iterations(argc, argv, 1 << 17);
+    hclib_launch(entrypoint, NULL);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "hclib.h"
+
+#define N_TASKS 1000
+
+static _Atomic int nran;
+static hclib_cancel_token_t *token;
+
+void count(void *arg) {
+    nran++;
+}
+
+void *produce(void *arg) {
+    nran++;
+    return arg;
+}
+
+void loop_body(void *arg, int i) {
+    nran++;
+}
+
+void cancel(void *arg) {
+    hclib_cancel(token);
+}
+
+void cancel_and_spawn(void *arg) {
+    hclib_cancel(token);
+    assert(hclib_is_cancelled());
+    for (int i = 0; i < N_TASKS; i++) {
+        hclib_async(count, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    }
+}
+
+void entrypoint(void *arg) {
+    assert(!hclib_is_cancelled());
+
+    // queued tasks are dropped once cancelled
+    token = hclib_cancel_token_create();
+    hclib_start_finish_cancellable(token);
+    hclib_async(cancel_and_spawn, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+            NO_PROP);
+    hclib_end_finish();
+    assert(nran == 0);
+    assert(hclib_cancel_token_is_cancelled(token));
+    assert(!hclib_is_cancelled());
+    hclib_cancel_token_free(token);
+
+    token = hclib_cancel_token_create();
+    hclib_start_finish_cancellable(token);
+    hclib_cancel(token);
+    // nested finishes inherit the token
+    hclib_start_finish();
+    assert(hclib_is_cancelled());
+    hclib_async(count, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    assert(nran == 0);
+
+    // except for uncancellable tasks
+    hclib_async(count, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+            UNCANCELLABLE_ASYNC);
+    // futures are still satisfied, without calling their function
+    hclib_future_t *future = hclib_async_future(produce, (void *) 42,
+            NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    // forasync tasks run, but skip their iterations
+    loop_domain_t loop = { 0, N_TASKS, 1, 10 };
+    hclib_forasync(loop_body, NULL, NULL, 1, &loop, FORASYNC_MODE_RECURSIVE);
+    hclib_end_finish();
+    assert(nran == 1);
+    assert(hclib_future_wait(future) == NULL);
+    hclib_cancel_token_free(token);
+
+    // cancelling a nested scope leaves its parent alone
+    hclib_cancel_token_t *outer = hclib_cancel_token_create();
+    hclib_start_finish_cancellable(outer);
+    token = hclib_cancel_token_create();
+    hclib_start_finish_cancellable(token);
+    hclib_cancel(token);
+    hclib_async(count, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    assert(!hclib_is_cancelled());
+    hclib_async(count, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    assert(nran == 2);
+    hclib_cancel_token_free(token);
+    hclib_cancel_token_free(outer);
+
+    // the nodes of a graph skip their function, but the launch completes
+    nran = 0;
+    hclib_graph_capture_begin();
+    hclib_future_t *first = hclib_async_future(produce, NULL, NO_FUTURE,
+            NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_future_t *first_list[] = { first, NULL };
+    hclib_async_future(produce, NULL, first_list, NO_PHASER, ANY_PLACE,
+            NO_PROP);
+    hclib_graph_t *graph = hclib_graph_capture_end();
+    token = hclib_cancel_token_create();
+    hclib_start_finish_cancellable(token);
+    hclib_cancel(token);
+    hclib_graph_launch(graph);
+    hclib_end_finish();
+    assert(nran == 0);
+    hclib_start_finish();
+    hclib_graph_launch(graph);
+    hclib_end_finish();
+    assert(nran == 2);
+    hclib_graph_free(graph);
+    hclib_cancel_token_free(token);
+
+    // periodic timers stop once their scope is cancelled
+    nran = 0;
+    token = hclib_cancel_token_create();
+    hclib_start_finish_cancellable(token);
+    hclib_future_t *every = hclib_async_every(1000000, count, NULL);
+    hclib_future_release(hclib_async_after(5000000, cancel, NULL));
+    hclib_end_finish();
+    const long nruns = (long) hclib_future_wait(every);
+    hclib_future_release(every);
+    assert(nruns == nran);
+    hclib_cancel_token_free(token);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "hclib.h"
+
+#define N_PRODUCERS 4
+#define N_CONSUMERS 3
+#define N_VALUES 10000
+
+static hclib_channel_t *channel;
+static long sums[N_CONSUMERS];
+
+void producer(void *arg) {
+    const intptr_t id = (intptr_t) arg;
+    for (intptr_t i = 1; i <= N_VALUES; i++) {
+        int sent = hclib_channel_send(channel, (void *) (id * N_VALUES + i));
+        assert(sent);
+    }
+}
+
+void producers(void *arg) {
+    hclib_start_finish();
+    for (intptr_t p = 0; p < N_PRODUCERS; p++) {
+        hclib_async(producer, (void *) p, NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+    }
+    hclib_end_finish();
+    hclib_channel_close(channel);
+}
+
+void consumer(void *arg) {
+    long *sum = (long *) arg;
+    void *value;
+    while (hclib_channel_recv(channel, &value)) {
+        *sum += (intptr_t) value;
+    }
+}
+
+void entrypoint(void *arg) {
+    // many producers and consumers on a small channel
+    channel = hclib_channel_create(4);
+    hclib_start_finish();
+    for (int c = 0; c < N_CONSUMERS; c++) {
+        hclib_async(consumer, &sums[c], NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+    }
+    hclib_async(producers, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+
+    long total = 0;
+    for (int c = 0; c < N_CONSUMERS; c++) {
+        total += sums[c];
+    }
+    const long n = (long) N_PRODUCERS * N_VALUES;
+    assert(total == n * (n + 1) / 2);
+    assert(hclib_channel_send(channel, (void *) 1) == 0);
+    hclib_channel_free(channel);
+
+    // rendezvous channel, and receives that complete later
+    channel = hclib_channel_create(0);
+    void *first, *second;
+    hclib_future_t *received = hclib_channel_recv_async(channel, &first);
+    hclib_future_t *closed = hclib_channel_recv_async(channel, &second);
+    assert(hclib_channel_send(channel, (void *) 42) == 1);
+    assert(hclib_future_wait(received) == (void *) 1 && first == (void *) 42);
+    hclib_channel_close(channel);
+    assert(hclib_future_wait(closed) == NULL);
+    hclib_future_release(received);
+    hclib_future_release(closed);
+    hclib_channel_free(channel);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Repeated forasyncs do not grow memory usage (10^6 iterations)
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <sys/resource.h>
+
+#include "hclib.h"
+
+#define NITERS 1000000
+#define WARMUP 100000
+#define H1 4
+
+// Maximum growth of the resident set allowed after the warmup, in KB
+#define MAX_GROWTH_KB 4096
+
+static const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT,
+    FORASYNC_MODE_ADAPTIVE };
+
+long max_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+//user written code
+void forasync_fct1(void *argv, int idx) {
+    int *ran = (int *)argv;
+    __sync_fetch_and_add(&ran[idx], 1);
+}
+
+void entrypoint(void *arg) {
+    int *ran = (int *)arg;
+    loop_domain_t loop = {0, H1, 1, 1};
+    long warm_rss = 0;
+
+    for (int iter = 0; iter < NITERS; iter++) {
+        if (iter == WARMUP) warm_rss = max_rss_kb();
+        hclib_start_finish();
+        hclib_forasync(forasync_fct1, (void*)(ran), NULL, 1, &loop,
+                modes[iter % 3]);
+        hclib_end_finish();
+    }
+
+    printf("Max RSS after %d forasyncs: %ld KB, after %d: %ld KB\n", WARMUP,
+            warm_rss, NITERS, max_rss_kb());
+    assert(max_rss_kb() - warm_rss < MAX_GROWTH_KB);
+}
+
+int main (int argc, char ** argv) {
+    int *ran = (int *)calloc(H1, sizeof(int));
+    hclib_launch(entrypoint, ran);
+    printf("Check results: ");
+    for (int i = 0; i < H1; i++) assert(ran[i] == NITERS);
+    free(ran);
+    printf("OK\n");
+    return 0;
+}
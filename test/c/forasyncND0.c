@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: N-dimensional forasync over a 4D strided domain, all modes
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.h"
+
+#define DIM 4
+#define H0 9
+#define H1 7
+#define H2 12
+#define H3 10
+#define SIZE (H0*H1*H2*H3)
+
+static const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT,
+    FORASYNC_MODE_ADAPTIVE };
+
+static int linearize(const int64_t *index) {
+    return ((index[0]*H1 + index[1])*H2 + index[2])*H3 + index[3];
+}
+
+//user written code
+void forasync_fct4(void *argv, const int64_t *index) {
+    int *ran = (int *)argv;
+    const int idx = linearize(index);
+    assert(ran[idx] == 0);
+    ran[idx] = 1;
+}
+
+void init_ran(int *ran, int size) {
+    while (size > 0) {
+        ran[size-1] = 0;
+        size--;
+    }
+}
+
+/*
+ * Dimensions 1 and 3 start at 1 and have a stride of 2, only odd indices
+ * there are visited.
+ */
+void check_ran(int *ran) {
+    for (int64_t i = 0; i < H0; i++) {
+        for (int64_t j = 0; j < H1; j++) {
+            for (int64_t k = 0; k < H2; k++) {
+                for (int64_t l = 0; l < H3; l++) {
+                    const int64_t index[DIM] = {i, j, k, l};
+                    assert(ran[linearize(index)] == (j % 2 == 1 && l % 2 == 1));
+                }
+            }
+        }
+    }
+}
+
+void entrypoint(void *arg) {
+    int *ran = (int *)arg;
+    loop_domain64_t loop[DIM] = {{0, H0, 1, 2}, {1, H1, 2, 3},
+        {0, H2, 1, 5}, {1, H3, 2, 4}};
+
+    for (int m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+        init_ran(ran, SIZE);
+        hclib_start_finish();
+        hclib_forasync_nd(forasync_fct4, (void*)(ran), NULL, DIM, loop,
+                modes[m]);
+        hclib_end_finish();
+        check_ran(ran);
+    }
+
+    init_ran(ran, SIZE);
+    hclib_future_t *done = hclib_forasync_nd_future(forasync_fct4,
+            (void*)(ran), NULL, DIM, loop, FORASYNC_MODE_FLAT);
+    hclib_future_wait(done);
+
+    printf("Call Finalize\n");
+}
+
+int main (int argc, char ** argv) {
+    printf("Call Init\n");
+    int *ran=(int *)malloc(SIZE*sizeof(int));
+    hclib_launch(entrypoint, ran);
+    printf("Check results: ");
+    check_ran(ran);
+    free(ran);
+    printf("OK\n");
+    return 0;
+}
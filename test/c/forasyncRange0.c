@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Range-based forasync over a 2D domain, one call per tile
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.h"
+
+#define H1 1024
+#define H2 512
+#define T1 33
+#define T2 217
+
+//user written code
+void forasync_range_fct2(void *argv, const loop_domain_t *chunk) {
+    int *ran = (int *)argv;
+    assert(chunk[0].high - chunk[0].low <= T1);
+    assert(chunk[1].high - chunk[1].low <= T2);
+    for (int i = chunk[0].low; i < chunk[0].high; i += chunk[0].stride) {
+        for (int j = chunk[1].low; j < chunk[1].high; j += chunk[1].stride) {
+            assert(ran[i*H2+j] == -1);
+            ran[i*H2+j] = i*H2+j;
+        }
+    }
+}
+
+void init_ran(int *ran, int size) {
+    while (size > 0) {
+        ran[size-1] = -1;
+        size--;
+    }
+}
+
+void entrypoint(void *arg) {
+    int *ran = (int *)arg;
+    loop_domain_t loop0 = {0,H1,1,T1};
+    loop_domain_t loop1 = {0,H2,1,T2};
+    loop_domain_t loop[2] = {loop0, loop1};
+
+    init_ran(ran, H1*H2);
+    hclib_start_finish();
+    hclib_forasync_range(forasync_range_fct2, (void*)(ran), NULL, 2, loop,
+            FORASYNC_MODE_RECURSIVE);
+    hclib_end_finish();
+
+    int i = 0;
+    while(i < H1*H2) {
+        assert(ran[i] == i);
+        i++;
+    }
+
+    init_ran(ran, H1*H2);
+    hclib_future_t *done = hclib_forasync_range_future(forasync_range_fct2,
+            (void*)(ran), NULL, 2, loop, FORASYNC_MODE_FLAT);
+    hclib_future_wait(done);
+
+    printf("Call Finalize\n");
+}
+
+int main (int argc, char ** argv) {
+    printf("Call Init\n");
+    int *ran=(int *)malloc(H1*H2*sizeof(int));
+    hclib_launch(entrypoint, ran);
+    printf("Check results: ");
+    int i = 0;
+    while(i < H1*H2) {
+        assert(ran[i] == i);
+        i++;
+    }
+    free(ran);
+    printf("OK\n");
+    return 0;
+}
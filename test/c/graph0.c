@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "hclib.h"
+
+#define N_LAUNCHES 5
+#define WIDTH 100
+
+/*
+ * A diamond of WIDTH tasks between a source and a sink, followed by a chain.
+ * Every task checks that its predecessors have run in the same launch.
+ */
+static volatile int launch;
+static volatile int source_done, middle_done[WIDTH], sink_done, chain_done[3];
+static volatile int external_done;
+
+void source(void *arg) {
+    assert(external_done == launch);
+    source_done = launch;
+}
+
+void *middle(void *arg) {
+    const intptr_t i = (intptr_t) arg;
+    assert(source_done == launch);
+    middle_done[i] = launch;
+    return NULL; // discarded
+}
+
+void sink(void *arg) {
+    for (int i = 0; i < WIDTH; i++) {
+        assert(middle_done[i] == launch);
+    }
+    sink_done = launch;
+}
+
+void *chain(void *arg) {
+    const intptr_t i = (intptr_t) arg;
+    assert(i == 0 ? sink_done == launch : chain_done[i - 1] == launch);
+    chain_done[i] = launch;
+    return NULL;
+}
+
+void put_external(void *arg) {
+    external_done = launch;
+    hclib_promise_put((hclib_promise_t *) arg, NULL);
+}
+
+void entrypoint(void *arg) {
+    hclib_promise_t *external = hclib_promise_create();
+    hclib_future_t *external_list[] = { &external->future, NULL };
+
+    hclib_graph_capture_begin();
+    hclib_future_t *s = hclib_async_future((futureFct_t) source, NULL,
+            external_list, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_future_t *deps[WIDTH + 1] = { NULL };
+    hclib_future_t *source_list[] = { s, NULL };
+    for (intptr_t i = 0; i < WIDTH; i++) {
+        deps[i] = hclib_async_future(middle, (void *) i, source_list,
+                NO_PHASER, ANY_PLACE, NO_PROP);
+    }
+    hclib_future_t *prev = hclib_async_future((futureFct_t) sink, NULL, deps,
+            NO_PHASER, ANY_PLACE, NO_PROP);
+    for (intptr_t i = 0; i < 3; i++) {
+        hclib_future_t *prev_list[] = { prev, NULL };
+        prev = hclib_async_future(chain, (void *) i, prev_list, NO_PHASER,
+                ANY_PLACE, NO_PROP);
+    }
+    hclib_graph_t *graph = hclib_graph_capture_end();
+    assert(hclib_graph_size(graph) == WIDTH + 5);
+    // nothing ran during the capture
+    assert(source_done == 0 && sink_done == 0);
+
+    launch = 1;
+    hclib_async(put_external, external, NO_FUTURE, NO_PHASER, ANY_PLACE,
+            NO_PROP);
+    hclib_start_finish();
+    hclib_graph_launch(graph);
+    hclib_end_finish();
+    assert(chain_done[2] == 1);
+
+    for (launch = 2; launch <= N_LAUNCHES; launch++) {
+        external_done = launch; // already put
+        hclib_start_finish();
+        hclib_graph_launch(graph);
+        hclib_end_finish();
+        assert(chain_done[2] == launch);
+    }
+    hclib_graph_free(graph);
+    hclib_promise_release(external);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
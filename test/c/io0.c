@@ -0,0 +1,217 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "hclib.h"
+
+#define N_MESSAGES 1000
+#define MSG_SIZE 64
+
+static long io_wait(hclib_future_t *future) {
+    const long ret = (long) (intptr_t) hclib_future_wait(future);
+    hclib_future_release(future);
+    return ret;
+}
+
+static void read_all(int fd, char *buf, size_t n) {
+    while (n > 0) {
+        const long got = io_wait(hclib_async_read(fd, buf, n));
+        assert(got > 0);
+        buf += got;
+        n -= got;
+    }
+}
+
+static void write_all(int fd, const char *buf, size_t n) {
+    while (n > 0) {
+        const long put = io_wait(hclib_async_write(fd, buf, n));
+        assert(put > 0);
+        buf += put;
+        n -= put;
+    }
+}
+
+// echo messages back until the peer hangs up
+void echo(void *arg) {
+    const int fd = (int) (intptr_t) arg;
+    char buf[MSG_SIZE];
+    long got;
+    while ((got = io_wait(hclib_async_read(fd, buf, sizeof(buf)))) > 0) {
+        write_all(fd, buf, got);
+    }
+    assert(got == 0);
+    close(fd);
+}
+
+void client(void *arg) {
+    const int fd = (int) (intptr_t) arg;
+    char out[MSG_SIZE], in[MSG_SIZE];
+    for (int i = 0; i < N_MESSAGES; i++) {
+        memset(out, 'a' + i % 26, sizeof(out));
+        write_all(fd, out, sizeof(out));
+        read_all(fd, in, sizeof(in));
+        assert(memcmp(in, out, sizeof(out)) == 0);
+    }
+    close(fd);
+}
+
+void server(void *arg) {
+    const int listener = (int) (intptr_t) arg;
+    const long fd = io_wait(hclib_async_accept(listener, NULL, NULL));
+    assert(fd >= 0);
+    echo((void *) (intptr_t) fd);
+}
+
+#define BULK_SIZE (4 * 1024 * 1024)
+
+static char *bulk;
+static int duplex[2];
+
+// reads on duplex[0] while bulk_writer writes on it
+void duplex_reader(void *arg) {
+    char in[MSG_SIZE];
+    read_all(duplex[0], in, sizeof(in));
+    assert(in[0] == 'z');
+}
+
+// fills the socket buffers, so that it waits for the peer to drain them
+void bulk_writer(void *arg) {
+    write_all(duplex[0], bulk, BULK_SIZE);
+}
+
+void bulk_reader(void *arg) {
+    char *in = malloc(BULK_SIZE);
+    assert(in);
+    read_all(duplex[1], in, BULK_SIZE);
+    assert(memcmp(in, bulk, BULK_SIZE) == 0);
+    free(in);
+    char out[MSG_SIZE];
+    memset(out, 'z', sizeof(out));
+    write_all(duplex[1], out, sizeof(out));
+}
+
+void pipe_writer(void *arg) {
+    const int fd = (int) (intptr_t) arg;
+    const char out = 'p';
+    write_all(fd, &out, 1);
+}
+
+void entrypoint(void *arg) {
+    // the echoing task waits on its read before anything was written
+    int pair[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    hclib_start_finish();
+    hclib_async(echo, (void *) (intptr_t) pair[0], NO_FUTURE, NO_PHASER,
+            ANY_PLACE, NO_PROP);
+    hclib_async(client, (void *) (intptr_t) pair[1], NO_FUTURE, NO_PHASER,
+            ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+
+    // the same over TCP on the loopback interface, accepting asynchronously
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    assert(listener >= 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrlen = sizeof(addr);
+    assert(bind(listener, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+    assert(listen(listener, 1) == 0);
+    assert(getsockname(listener, (struct sockaddr *) &addr, &addrlen) == 0);
+    hclib_start_finish();
+    hclib_async(server, (void *) (intptr_t) listener, NO_FUTURE, NO_PHASER,
+            ANY_PLACE, NO_PROP);
+    const int conn = socket(AF_INET, SOCK_STREAM, 0);
+    assert(conn >= 0);
+    assert(connect(conn, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+    hclib_async(client, (void *) (intptr_t) conn, NO_FUTURE, NO_PHASER,
+            ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    assert(!(fcntl(listener, F_GETFL) & O_NONBLOCK));
+    close(listener);
+
+    // one task reading and one writing on the same socket
+    bulk = malloc(BULK_SIZE);
+    assert(bulk);
+    for (size_t i = 0; i < BULK_SIZE; i++) {
+        bulk[i] = (char) (i * 7);
+    }
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, duplex) == 0);
+    hclib_start_finish();
+    hclib_async(duplex_reader, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_async(bulk_writer, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_async(bulk_reader, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    assert(!(fcntl(duplex[0], F_GETFL) & O_NONBLOCK));
+    assert(!(fcntl(duplex[1], F_GETFL) & O_NONBLOCK));
+    close(duplex[0]);
+    close(duplex[1]);
+    free(bulk);
+
+    // pipes are left blocking once nothing waits on them
+    int fds[2];
+    assert(pipe(fds) == 0);
+    char c;
+    hclib_future_t *read = hclib_async_read(fds[0], &c, 1);
+    hclib_start_finish();
+    hclib_async(pipe_writer, (void *) (intptr_t) fds[1], NO_FUTURE, NO_PHASER,
+            ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    assert(io_wait(read) == 1 && c == 'p');
+    assert(!(fcntl(fds[0], F_GETFL) & O_NONBLOCK));
+    assert(!(fcntl(fds[1], F_GETFL) & O_NONBLOCK));
+    close(fds[0]);
+    close(fds[1]);
+
+    // regular files
+    char path[] = "/tmp/hclib-io0-XXXXXX";
+    const int fd = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+    char out[4096], in[4096];
+    for (size_t i = 0; i < sizeof(out); i++) {
+        out[i] = (char) i;
+    }
+    write_all(fd, out, sizeof(out));
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    read_all(fd, in, sizeof(in));
+    assert(memcmp(in, out, sizeof(out)) == 0);
+    assert(io_wait(hclib_async_read(fd, in, sizeof(in))) == 0);
+    close(fd);
+
+    // errors come back as -errno
+    assert(io_wait(hclib_async_read(fd, in, sizeof(in))) == -EBADF);
+    assert(io_wait(hclib_async_read(-1, in, sizeof(in))) == -EBADF);
+    assert(io_wait(hclib_async_write(-1, out, sizeof(out))) == -EBADF);
+    assert(io_wait(hclib_async_accept(-1, NULL, NULL)) == -EBADF);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
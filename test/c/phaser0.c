@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "hclib.h"
+
+#define N_TASKS 8
+#define N_PHASES 50
+
+static hclib_phaser_t *phaser;
+static volatile int stage[N_TASKS + 1];
+
+static void check_stage(int phase) {
+    for (int i = 0; i < N_TASKS; i++) {
+        assert(stage[i] >= phase);
+    }
+}
+
+void barrier_task(void *arg) {
+    const intptr_t id = (intptr_t) arg;
+    for (int phase = stage[id] + 1; phase <= N_PHASES; phase++) {
+        stage[id] = phase;
+        if (id % 2) {
+            // split-phase: nothing to wait for before the next write
+            hclib_phaser_signal(phaser);
+        }
+        hclib_phaser_next(phaser);
+        check_stage(phase);
+    }
+}
+
+void producer(void *arg) {
+    for (int phase = 1; phase <= N_PHASES; phase++) {
+        stage[N_TASKS] = phase;
+        hclib_phaser_next(phaser);
+    }
+}
+
+void consumer(void *arg) {
+    for (int phase = 1; phase <= N_PHASES; phase++) {
+        hclib_phaser_next(phaser);
+        assert(stage[N_TASKS] >= phase);
+    }
+}
+
+void spawner(void *arg) {
+    // register more signalers half-way through
+    for (int phase = 1; phase <= N_PHASES; phase++) {
+        if (phase == N_PHASES / 2) {
+            for (intptr_t i = N_TASKS / 2; i < N_TASKS; i++) {
+                hclib_async(barrier_task, (void *) i, NO_FUTURE, NO_PHASER,
+                        ANY_PLACE, PHASER_TRANSMIT_ALL);
+            }
+        }
+        hclib_phaser_next(phaser);
+    }
+}
+
+void entrypoint(void *arg) {
+    hclib_phaser_mode_t mode = PHASER_SIG_WAIT;
+
+    // barrier between all tasks, created in a finish scope
+    hclib_start_finish();
+    phaser = hclib_phaser_create(PHASER_SIG_WAIT);
+    hclib_phased_t phased = { 1, &phaser, &mode };
+    for (intptr_t i = 0; i < N_TASKS; i++) {
+        hclib_async(barrier_task, (void *) i, NO_FUTURE, &phased, ANY_PLACE,
+                NO_PROP);
+    }
+    hclib_end_finish();
+    check_stage(N_PHASES);
+
+    // a signal-only producer ahead of wait-only consumers
+    hclib_start_finish();
+    phaser = hclib_phaser_create(PHASER_SIG_WAIT);
+    mode = PHASER_SIG;
+    hclib_async(producer, NULL, NO_FUTURE, &phased, ANY_PLACE, NO_PROP);
+    mode = PHASER_WAIT;
+    for (int i = 0; i < N_TASKS; i++) {
+        hclib_async(consumer, NULL, NO_FUTURE, &phased, ANY_PLACE, NO_PROP);
+    }
+    hclib_phaser_drop(phaser);
+    hclib_end_finish();
+
+    // signalers joining while the others are running
+    for (int i = 0; i < N_TASKS; i++) {
+        stage[i] = i < N_TASKS / 2 ? 0 : N_PHASES / 2 - 1;
+    }
+    hclib_start_finish();
+    phaser = hclib_phaser_create(PHASER_SIG_WAIT);
+    mode = PHASER_SIG_WAIT;
+    for (intptr_t i = 0; i < N_TASKS / 2; i++) {
+        hclib_async(barrier_task, (void *) i, NO_FUTURE, &phased, ANY_PLACE,
+                NO_PROP);
+    }
+    hclib_async(spawner, NULL, NO_FUTURE, &phased, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hclib.h"
+
+#define SPIN_NS 1000000ULL
+#define N_COUNTED 1000
+#define N_WAITING 10
+
+/*
+ * Named here, as the profile only finds the functions of an executable by name
+ * if it exports them, e.g. when linked with -rdynamic.
+ */
+static hclib_task_name_t names[3];
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void spin(uint64_t ns) {
+    const uint64_t start = now_ns();
+    while (now_ns() - start < ns);
+}
+
+static void counted_task(void *arg) { }
+
+static void spinning_task(void *arg) {
+    spin(SPIN_NS);
+}
+
+static void waiting_task(void *arg) {
+    hclib_start_finish();
+    hclib_async(spinning_task, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+            NO_PROP);
+    hclib_end_finish();
+}
+
+void entrypoint(void *arg) {
+    hclib_start_finish();
+    for (int i = 0; i < N_COUNTED; i++) {
+        hclib_async(counted_task, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+    }
+    for (int i = 0; i < N_WAITING; i++) {
+        hclib_async(waiting_task, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+    }
+    hclib_end_finish();
+}
+
+/*
+ * Returns the line of the profile for the given function, giving its number of
+ * tasks and mean time in us.
+ */
+static int find(const char *profile, const char *function, unsigned long *tasks,
+        double *mean) {
+    for (const char *line = profile; line; line = strchr(line, '\n')) {
+        line += (*line == '\n');
+        const char *end = strchr(line, '\n');
+        const size_t length = end ? (size_t) (end - line) : strlen(line);
+        const size_t n = strlen(function);
+        if (length > n && strncmp(line + length - n, function, n) == 0 &&
+                line[length - n - 1] == ' ') {
+            double time;
+            return sscanf(line, "%lu %lf %lf", tasks, &time, mean) == 3;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char ** argv) {
+    setenv("HCLIB_PROFILE", "1", 1);
+    setenv("HCLIB_PROFILE_PERIOD", "1", 1);
+    const generic_frame_ptr fns[] = { counted_task, spinning_task,
+            waiting_task };
+    const char *types[] = { "counted", "spinning", "waiting" };
+    for (int i = 0; i < 3; i++) {
+        names[i].fn = fns[i];
+        assert(hclib_profile_name_task(&names[i], types[i]) == 0);
+    }
+
+    // the profile is printed on stderr
+    fflush(stderr);
+    FILE *captured = tmpfile();
+    assert(captured);
+    const int saved_stderr = dup(STDERR_FILENO);
+    dup2(fileno(captured), STDERR_FILENO);
+    hclib_launch(entrypoint, NULL);
+    fflush(stderr);
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+
+    static char profile[1 << 16];
+    rewind(captured);
+    const size_t length = fread(profile, 1, sizeof(profile) - 1, captured);
+    profile[length] = '\0';
+    fclose(captured);
+    fputs(profile, stderr);
+
+    unsigned long tasks;
+    double mean;
+    assert(find(profile, "counted", &tasks, &mean));
+    assert(tasks == N_COUNTED);
+
+    double spinning_mean, waiting_mean;
+    assert(find(profile, "spinning", &tasks, &spinning_mean));
+    assert(tasks == N_WAITING);
+    assert(spinning_mean >= SPIN_NS / 1e3);
+    // blocked in its finish while its spinning task runs
+    assert(find(profile, "waiting", &tasks, &waiting_mean));
+    assert(tasks == N_WAITING);
+    assert(waiting_mean < spinning_mean / 2);
+    printf("Exiting...\n");
+    return 0;
+}
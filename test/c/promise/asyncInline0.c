@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: INLINE_ASYNC tasks run within the put that satisfies their future, and
+ * may block there, resuming on another worker
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.h"
+
+#define N 100
+
+static hclib_promise_t *go, *later;
+static int ran[N];
+
+void blocking_fct(void *arg) {
+    const int index = (int) (intptr_t) arg;
+    int *value = (int *) hclib_future_wait(
+            hclib_get_future_for_promise(later));
+    ran[index] = *value;
+}
+
+void put_fct(void *arg) {
+    static int value = 42;
+    hclib_promise_put((hclib_promise_t *) arg, &value);
+}
+
+void entrypoint(void *arg) {
+    go = hclib_promise_create();
+    later = hclib_promise_create();
+    hclib_future_t *deps[] = { hclib_get_future_for_promise(go), NULL };
+
+    hclib_start_finish();
+    for (int i = 0; i < N; i++) {
+        hclib_async(blocking_fct, (void *) (intptr_t) i, deps, NO_PHASER,
+                ANY_PLACE, INLINE_ASYNC);
+    }
+    hclib_async(put_fct, go, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_async(put_fct, later, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+
+    for (int i = 0; i < N; i++) {
+        assert(ran[i] == 42);
+    }
+    hclib_promise_free(go);
+    hclib_promise_free(later);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hclib.h"
+
+#define N_TASKS 1000
+#define ROW 100
+
+static int *rows[N_TASKS];
+static hclib_promise_t *go;
+
+static void fill_row(void *arg) {
+    const int i = (int) (intptr_t) arg;
+    int *row = hclib_scratch_alloc(ROW * sizeof(int));
+    assert(((uintptr_t) row & 15) == 0);
+    for (int j = 0; j < ROW; j++) row[j] = i + j;
+    rows[i] = row;
+}
+
+static void *fill_row_future(void *arg) {
+    fill_row(arg);
+    return NULL;
+}
+
+static void check_rows() {
+    for (int i = 0; i < N_TASKS; i++) {
+        for (int j = 0; j < ROW; j++) assert(rows[i][j] == i + j);
+    }
+}
+
+static void suspend_between(void *arg) {
+    char *before = hclib_scratch_alloc(3);
+    memcpy(before, "ab", 3);
+    // may resume on another worker
+    hclib_future_wait(hclib_get_future_for_promise(go));
+    char *after = hclib_scratch_alloc(3);
+    memcpy(after, "cd", 3);
+    assert(strcmp(before, "ab") == 0 && strcmp(after, "cd") == 0);
+}
+
+static void put_go(void *arg) {
+    hclib_promise_put(go, NULL);
+}
+
+void entrypoint(void *arg) {
+    // valid until the end of the scope, whichever task reads it
+    hclib_future_t *filled[N_TASKS];
+    hclib_start_finish();
+    for (int i = 0; i < N_TASKS; i++) {
+        filled[i] = hclib_async_future(fill_row_future, (void *) (intptr_t) i,
+                NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    }
+    for (int i = 0; i < N_TASKS; i++) hclib_future_wait(filled[i]);
+    check_rows();
+    hclib_end_finish();
+
+    // larger than a block, and many blocks
+    hclib_start_finish();
+    char *big = hclib_scratch_alloc(4 << 20);
+    memset(big, 1, 4 << 20);
+    char *small = hclib_scratch_alloc(1);
+    *small = 2;
+    for (int i = 0; i < 10000; i++) {
+        char *chunk = hclib_scratch_alloc(1000);
+        memset(chunk, 3, 1000);
+    }
+    assert(big[0] == 1 && big[(4 << 20) - 1] == 1 && *small == 2);
+    hclib_end_finish();
+
+    // scratch memory survives suspensions
+    go = hclib_promise_create();
+    hclib_start_finish();
+    for (int i = 0; i < 10; i++) {
+        hclib_async(suspend_between, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+    }
+    hclib_async(put_go, NULL, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_end_finish();
+    hclib_promise_free(go);
+
+    // and is freed once a nonblocking finish completes
+    hclib_start_finish();
+    for (int i = 0; i < N_TASKS; i++) {
+        hclib_async(fill_row, (void *) (intptr_t) i, NO_FUTURE, NO_PHASER,
+                ANY_PLACE, NO_PROP);
+    }
+    hclib_future_t *done = hclib_end_finish_nonblocking();
+    hclib_future_wait(done);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
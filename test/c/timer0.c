@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "hclib.h"
+
+#define MS 1000000ULL
+#define N_TIMERS 1000
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t due[N_TIMERS];
+static _Atomic int nfired;
+
+void check_due(void *arg) {
+    const uint64_t *when = (const uint64_t *) arg;
+    assert(now_ns() >= *when);
+    nfired++;
+}
+
+void never(void *arg) {
+    assert(0);
+}
+
+static _Atomic int nticks;
+static hclib_future_t *ticker;
+
+void tick(void *arg) {
+    nticks++;
+}
+
+void stop_ticker(void *arg) {
+    assert(hclib_timer_cancel(ticker) == 1);
+}
+
+void entrypoint(void *arg) {
+    // a delayed task runs once, and no earlier than asked
+    uint64_t when = now_ns() + 2 * MS;
+    hclib_future_t *timer = hclib_async_after(2 * MS, check_due, &when);
+    assert((intptr_t) hclib_future_wait(timer) == 1);
+    assert(nfired == 1);
+    assert(hclib_timer_cancel(timer) == 0);
+    hclib_future_release(timer);
+
+    // the enclosing finish ends once the cancelled timer is checked out
+    const uint64_t start = now_ns();
+    hclib_start_finish();
+    timer = hclib_async_after(10000 * MS, never, NULL);
+    assert(hclib_timer_cancel(timer) == 1);
+    hclib_end_finish();
+    assert(now_ns() - start < 1000 * MS);
+    assert((intptr_t) hclib_future_wait(timer) == 0);
+    hclib_future_release(timer);
+
+    // a periodic task runs until cancelled, and its finish waits for that
+    hclib_start_finish();
+    ticker = hclib_async_every(1 * MS, tick, NULL);
+    hclib_future_release(hclib_async_after(20 * MS, stop_ticker, NULL));
+    hclib_end_finish();
+    assert(nticks > 0);
+    assert((intptr_t) hclib_future_wait(ticker) == nticks);
+    hclib_future_release(ticker);
+
+    // many timers, spread over all levels of the wheel
+    nfired = 0;
+    hclib_start_finish();
+    for (int i = 0; i < N_TIMERS; i++) {
+        const uint64_t delay = i % 2 ? (uint64_t) i * 50000 :
+            (uint64_t) (i % 64) * 1000;
+        due[i] = now_ns() + delay;
+        hclib_future_release(hclib_async_after(delay, check_due, &due[i]));
+    }
+    hclib_end_finish();
+    assert(nfired == N_TIMERS);
+}
+
+int main(int argc, char ** argv) {
+    hclib_launch(entrypoint, NULL);
+    printf("Exiting...\n");
+    return 0;
+}
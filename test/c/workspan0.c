@@ -0,0 +1,129 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "hclib.h"
+
+#define SPIN_NS 2000000ULL
+#define N_INDEPENDENT 8
+#define N_CHAIN 4
+
+/*
+ * Spin lengths as measured here, which the profiled work and span are checked
+ * against.
+ */
+static uint64_t independent[N_INDEPENDENT];
+static uint64_t chain[N_CHAIN];
+static uint64_t after_finish, waited, after_wait;
+
+static hclib_promise_t *links[N_CHAIN];
+static hclib_future_t *awaited[N_CHAIN][2];
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t spin(uint64_t ns) {
+    const uint64_t start = now_ns();
+    uint64_t end;
+    while ((end = now_ns()) - start < ns);
+    return end - start;
+}
+
+static void independent_task(void *arg) {
+    independent[(intptr_t) arg] = spin(SPIN_NS);
+}
+
+static void chain_task(void *arg) {
+    const int i = (int) (intptr_t) arg;
+    chain[i] = spin(SPIN_NS);
+    hclib_promise_put(links[i], NULL);
+}
+
+static void waited_task(void *arg) {
+    waited = spin(3 * SPIN_NS);
+    hclib_promise_put((hclib_promise_t *) arg, NULL);
+}
+
+void entrypoint(void *arg) {
+    hclib_start_finish();
+    for (int i = 0; i < N_CHAIN; i++) {
+        links[i] = hclib_promise_create();
+        awaited[i][0] = i > 0 ? hclib_get_future_for_promise(links[i - 1]) :
+            NULL;
+        awaited[i][1] = NULL;
+    }
+    // spawned last to first, so that they do not just run in order
+    for (int i = N_CHAIN - 1; i >= 0; i--) {
+        hclib_async(chain_task, (void *) (intptr_t) i,
+                i > 0 ? awaited[i] : NO_FUTURE, NO_PHASER, ANY_PLACE,
+                NO_PROP);
+    }
+    for (int i = 0; i < N_INDEPENDENT; i++) {
+        hclib_async(independent_task, (void *) (intptr_t) i, NO_FUTURE,
+                NO_PHASER, ANY_PLACE, NO_PROP);
+    }
+    hclib_end_finish();
+    after_finish = spin(SPIN_NS);
+
+    hclib_promise_t *done = hclib_promise_create();
+    hclib_async(waited_task, done, NO_FUTURE, NO_PHASER, ANY_PLACE, NO_PROP);
+    hclib_future_wait(hclib_get_future_for_promise(done));
+    after_wait = spin(SPIN_NS);
+
+    for (int i = 0; i < N_CHAIN; i++) {
+        hclib_promise_free(links[i]);
+    }
+    hclib_promise_free(done);
+}
+
+int main(int argc, char ** argv) {
+    setenv("HCLIB_WORKSPAN", "1", 1);
+    hclib_launch(entrypoint, NULL);
+
+    hclib_workspan_t profiled;
+    assert(hclib_workspan_get(&profiled));
+    assert(profiled.work > 0 && profiled.span > 0);
+    assert(profiled.burdened_span > profiled.span);
+
+    uint64_t work = after_finish + waited + after_wait;
+    uint64_t longest = 0, chained = 0;
+    for (int i = 0; i < N_INDEPENDENT; i++) {
+        work += independent[i];
+        if (independent[i] > longest) longest = independent[i];
+    }
+    for (int i = 0; i < N_CHAIN; i++) {
+        work += chain[i];
+        chained += chain[i];
+    }
+    if (chained > longest) longest = chained;
+    const uint64_t span = longest + after_finish + waited + after_wait;
+
+    const double expected = (double) work / span;
+    const double parallelism = (double) profiled.work / profiled.span;
+    printf("parallelism %.2f, expected %.2f\n", parallelism, expected);
+    assert(parallelism > 0.9 * expected && parallelism < 1.1 * expected);
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Tiled Cholesky factorization as a DAG of tile tasks, repeated over several
+ * iterations: either building the DAG of futures again for every iteration,
+ * or capturing it once into a task graph and replaying it.
+ */
+
+#include "header.h"
+#include <vector>
+
+struct fresh_spawner {
+    template <typename T, typename... future_list_t>
+    hclib::shared_future<void> operator()(T lambda,
+            future_list_t... futures) {
+        return hclib::async_future_await(lambda, futures...);
+    }
+};
+
+struct graph_spawner {
+    template <typename T, typename... future_list_t>
+    hclib_future_t *operator()(T lambda, future_list_t... futures) {
+        return hclib::graph_async(lambda, futures...);
+    }
+};
+
+/*
+ * Spawn the tasks of the factorization. fut[(i * numTiles + j) * (numTiles + 1)
+ * + k] stands for version k of tile (i, j), and initial is version 0.
+ */
+template <typename F, typename S>
+void spawn_tasks(TileBlock ****lkji, int numTiles, int tileSize, F initial,
+        S spawn) {
+    std::vector<F> fut(numTiles * numTiles * (numTiles + 1), initial);
+    auto at = [numTiles](int i, int j, int k) {
+        return (i * numTiles + j) * (numTiles + 1) + k;
+    };
+
+    for (int k = 0; k < numTiles; ++k) {
+        TileBlock *prevPivotTile = lkji[k][k][k];
+        TileBlock *currPivotTile = lkji[k][k][k+1];
+        fut[at(k, k, k + 1)] = spawn([=]() {
+                sequential_cholesky(k, tileSize, prevPivotTile, currPivotTile);
+            }, fut[at(k, k, k)]);
+
+        for (int j = k + 1; j < numTiles; ++j) {
+            TileBlock *prevPivotColumnTile = lkji[j][k][k];
+            TileBlock *currPivotColumnTile = lkji[j][k][k+1];
+            fut[at(j, k, k + 1)] = spawn([=]() {
+                    trisolve(k, j, tileSize, prevPivotColumnTile,
+                        currPivotTile, currPivotColumnTile);
+                }, fut[at(j, k, k)], fut[at(k, k, k + 1)]);
+        }
+
+        for (int j = k + 1; j < numTiles; ++j) {
+            TileBlock *currPivotColumnTile = lkji[j][k][k+1];
+            for (int i = k + 1; i < j; ++i) {
+                TileBlock *prevTileForUpdate = lkji[j][i][k];
+                TileBlock *currTileForUpdate = lkji[j][i][k+1];
+                TileBlock *currPivotColumnOtherTile = lkji[i][k][k+1];
+                fut[at(j, i, k + 1)] = spawn([=]() {
+                        update_nondiagonal(k, j, i, tileSize,
+                            prevTileForUpdate, currPivotColumnOtherTile,
+                            currPivotColumnTile, currTileForUpdate);
+                    }, fut[at(j, i, k)], fut[at(i, k, k + 1)],
+                    fut[at(j, k, k + 1)]);
+            }
+            TileBlock *prevDiagonalTileForUpdate = lkji[j][j][k];
+            TileBlock *currDiagonalTileForUpdate = lkji[j][j][k+1];
+            fut[at(j, j, k + 1)] = spawn([=]() {
+                    update_diagonal(k, j, j, tileSize,
+                        prevDiagonalTileForUpdate, currPivotColumnTile,
+                        currDiagonalTileForUpdate);
+                }, fut[at(j, j, k)], fut[at(j, k, k + 1)]);
+        }
+    }
+}
+
+// Load the input matrix back into the tiles
+void reset_tiles(TileBlock ****lkji, double **A, int numTiles, int tileSize) {
+    for (int i = 0; i < numTiles; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            double **temp = lkji[i][j][0]->matrixBlock;
+            for (int T_i = 0; T_i < tileSize; ++T_i) {
+                for (int T_j = 0; T_j < tileSize; ++T_j) {
+                    temp[T_i][T_j] = A[i * tileSize + T_i][j * tileSize + T_j];
+                }
+            }
+        }
+        // allocated by sequential_cholesky
+        TileBlock *pivot = lkji[i][i][i + 1];
+        if (pivot->matrixBlock) {
+            for (int T_i = 0; T_i < tileSize; ++T_i) {
+                delete[] pivot->matrixBlock[T_i];
+            }
+            delete[] pivot->matrixBlock;
+            pivot->matrixBlock = NULL;
+        }
+    }
+}
+
+long get_usecs() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec * 1000000 + t.tv_usec;
+}
+
+int main(int argc, char** argv) {
+  hclib::launch([argc, argv]() {
+    if (argc < 4) {
+        printf("Usage: ./cholesky_graph matrixSize tileSize fileName "
+                "[iterations]\n");
+        exit(1);
+    }
+    const int matrixSize = atoi(argv[1]);
+    const int tileSize = atoi(argv[2]);
+    const int iterations = argc > 4 ? atoi(argv[4]) : 10;
+    if (matrixSize % tileSize != 0) {
+        printf("Incorrect tile size %d for the matrix of size %d \n", tileSize,
+                matrixSize);
+        exit(1);
+    }
+    const int numTiles = matrixSize / tileSize;
+
+    FILE *in = fopen(argv[3], "r");
+    if (!in) {
+        printf("Cannot find file: %s\n", argv[3]);
+        exit(1);
+    }
+    double **A = new double*[matrixSize];
+    for (int i = 0; i < matrixSize; ++i) {
+        A[i] = new double[matrixSize];
+        for (int j = 0; j < matrixSize; ++j) {
+            fscanf(in, "%lf", &A[i][j]);
+        }
+    }
+    fclose(in);
+
+    TileBlock ****lkji = new TileBlock***[numTiles];
+    for (int i = 0; i < numTiles; ++i) {
+        lkji[i] = new TileBlock**[i + 1];
+        for (int j = 0; j <= i; ++j) {
+            lkji[i][j] = new TileBlock*[numTiles + 1];
+            for (int k = 0; k <= numTiles; ++k) {
+                lkji[i][j][k] = new TileBlock;
+                lkji[i][j][k]->matrixBlock = NULL;
+            }
+            lkji[i][j][0]->matrixBlock = new double*[tileSize];
+            for (int ii = 0; ii < tileSize; ++ii) {
+                lkji[i][j][0]->matrixBlock[ii] = new double[tileSize];
+            }
+            // written by trisolve
+            if (i != j) {
+                lkji[i][j][j + 1]->matrixBlock = new double*[tileSize];
+                for (int ii = 0; ii < tileSize; ++ii) {
+                    lkji[i][j][j + 1]->matrixBlock[ii] = new double[tileSize];
+                }
+            }
+        }
+    }
+
+    long fresh = 0;
+    for (int it = 0; it < iterations; it++) {
+        reset_tiles(lkji, A, numTiles, tileSize);
+        long start = get_usecs();
+        hclib::promise_t<void> *ready = new hclib::promise_t<void>();
+        ready->put();
+        HCLIB_FINISH {
+            spawn_tasks(lkji, numTiles, tileSize,
+                    hclib::shared_future<void>(ready), fresh_spawner());
+        }
+        fresh += get_usecs() - start;
+    }
+
+    long start = get_usecs();
+    hclib::graph graph([=]() {
+            spawn_tasks(lkji, numTiles, tileSize, (hclib_future_t *) NULL,
+                    graph_spawner());
+        });
+    const long capture = get_usecs() - start;
+    long replay = 0;
+    for (int it = 0; it < iterations; it++) {
+        reset_tiles(lkji, A, numTiles, tileSize);
+        long start = get_usecs();
+        graph.run();
+        replay += get_usecs() - start;
+    }
+
+    printf("%d tasks per iteration, %d iterations\n", graph.size(),
+            iterations);
+    printf("futures rebuilt per iteration: %.3f ms per iteration\n",
+            fresh / 1000.0 / iterations);
+    printf("graph replay: %.3f ms per iteration (capture %.3f ms)\n",
+            replay / 1000.0 / iterations, capture / 1000.0);
+
+    FILE *out = fopen("cholesky.out", "w");
+    for (int i = 0; i < numTiles; ++i) {
+        for (int i_b = 0; i_b < tileSize; ++i_b) {
+            for (int j = 0; j <= i; ++j) {
+                double **temp = lkji[i][j][j + 1]->matrixBlock;
+                for (int j_b = 0; j_b < (i != j ? tileSize : i_b + 1); ++j_b) {
+                    fprintf(out, "%lf ", temp[i_b][j_b]);
+                }
+            }
+        }
+    }
+    fclose(out);
+  });
+}
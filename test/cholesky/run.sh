@@ -10,4 +10,14 @@ if ! cmp -s cholesky.out input/cholesky_out_500.txt; then
     exit 1
 fi
 
+make cholesky_graph
+rm -f cholesky.out
+
+./cholesky_graph 500 20 ./input/m_500.in 5
+
+if ! cmp -s cholesky.out input/cholesky_out_500.txt; then
+    echo "Test=Fail"
+    exit 1
+fi
+
 echo "Test=Success"
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Finish-scoped accumulators, put from nested asyncs
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.hpp"
+
+#define N 1000
+
+struct range_t {
+    long lo, hi;
+};
+
+void spawn(int depth, hclib::accumulator<long> &sum,
+        hclib::accumulator<int, hclib::max_of<int>> &deepest) {
+    sum.put(1);
+    deepest.put(depth);
+    if (depth < 10) {
+        hclib::async([depth, &sum, &deepest]() {
+                spawn(depth + 1, sum, deepest);
+            });
+        // nested scopes still count for the accumulators
+        hclib::finish([depth, &sum, &deepest]() {
+                hclib::async([depth, &sum, &deepest]() {
+                        spawn(depth + 1, sum, deepest);
+                    });
+            });
+    }
+}
+
+int main (int argc, char ** argv) {
+    hclib::launch([]() {
+        hclib::accumulator<long> sum;
+        hclib::accumulator<int, hclib::max_of<int>> deepest(-1);
+        hclib::finish([&]() {
+                spawn(0, sum, deepest);
+            }, sum, deepest);
+        assert(sum.get() == (1L << 11) - 1);
+        assert(deepest.get() == 10);
+
+        // declared again on a new scope, with a non-commutative operator
+        auto concat = [](range_t a, range_t b) {
+            assert(a.hi == b.lo || a.lo == a.hi || b.lo == b.hi);
+            return range_t { a.lo == a.hi ? b.lo : a.lo,
+                b.lo == b.hi ? a.hi : b.hi };
+        };
+        hclib::accumulator<range_t, decltype(concat)> ranges(range_t { 0, 0 },
+                concat);
+        hclib::finish([&]() {
+                for (long i = 0; i < N; i++) {
+                    hclib::async([&sum]() {
+                            sum.local() += 2;
+                        });
+                }
+                ranges.put(range_t { 0, N });
+            }, sum, ranges);
+        assert(sum.get() == 2 * N);
+        assert(ranges.get().lo == 0 && ranges.get().hi == N);
+
+        // completed by the last task to check out
+        hclib_accum_t *handles[] = { sum.handle() };
+        hclib_start_finish_accum(handles, 1);
+        for (int i = 0; i < N; i++) {
+            hclib::async([&sum]() {
+                    sum.put(3);
+                });
+        }
+        hclib_future_t *done = hclib_end_finish_nonblocking();
+        hclib_future_wait(done);
+        hclib_future_release(done);
+        assert(sum.get() == 3 * N);
+    });
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <atomic>
+
+#include "hclib.hpp"
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        constexpr int n = 10000;
+
+        // two stages, with values stored in and out of the channel
+        hclib::channel<int> numbers(8);
+        hclib::channel<std::string> strings(8);
+        std::atomic<long> sum(0);
+        HCLIB_FINISH {
+            hclib::async([&]() {
+                    for (int i = 1; i <= n; i++) {
+                        assert(numbers.send(i));
+                    }
+                    numbers.close();
+                });
+            hclib::async([&]() {
+                    int i;
+                    while (numbers.recv(i)) {
+                        assert(strings.send(std::to_string(i)));
+                    }
+                    strings.close();
+                });
+            for (int c = 0; c < 2; c++) {
+                hclib::async([&]() {
+                        std::string s;
+                        while (strings.recv(s)) {
+                            sum += std::stol(s);
+                        }
+                    });
+            }
+        }
+        assert(sum == (long) n * (n + 1) / 2);
+        assert(!strings.send("closed"));
+
+        // asynchronous receives, satisfied by later sends or by close
+        hclib::channel<std::string> rendezvous(0);
+        std::string first, second;
+        hclib::shared_future<bool> received = rendezvous.recv_async(first);
+        hclib::shared_future<bool> closed = rendezvous.recv_async(second);
+        hclib::async([&]() { rendezvous.send("hello"); });
+        assert(received.wait() && first == "hello");
+        rendezvous.close();
+        assert(!closed.wait() && second.empty());
+
+        // values still in the channel are freed along with it
+        hclib::channel<std::string> leftover(4);
+        leftover.send("a");
+        leftover.send("b");
+    });
+    printf("Exiting...\n");
+    return 0;
+}
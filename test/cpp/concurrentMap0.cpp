@@ -0,0 +1,99 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Concurrent inserts, lookups and erases in a concurrent_map, across
+ * resizes, and buffered inserts flushed at the end of a finish scope
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string>
+
+#include "hclib.hpp"
+
+#define N 100000
+#define NTASKS 64
+
+int main (int argc, char ** argv) {
+    hclib::launch([]() {
+        // starts small, so that it is resized while tasks insert
+        hclib::concurrent_map<int, long> map;
+
+        // every key is inserted by two tasks, only the first one wins
+        hclib::finish([&]() {
+            for (int t = 0; t < NTASKS; t++) {
+                hclib::async([&, t]() {
+                    for (int i = t; i < N; i += NTASKS / 2) {
+                        assert(map.insert(i, i * 10L) || map.contains(i));
+                        long value;
+                        assert(map.find(i, value) && value == i * 10L);
+                    }
+                });
+            }
+        });
+        assert(map.size() == N);
+        for (int i = 0; i < N; i++) {
+            long value;
+            assert(map.find(i, value) && value == i * 10L);
+        }
+        assert(!map.contains(N) && !map.contains(-1));
+
+        // erase the odd keys while updating the even ones
+        hclib::finish([&]() {
+            for (int t = 0; t < NTASKS; t++) {
+                hclib::async([&, t]() {
+                    for (int i = t; i < N; i += NTASKS) {
+                        if (i % 2) {
+                            assert(map.erase(i));
+                            assert(!map.erase(i));
+                        } else {
+                            map.insert_or_assign(i, -i);
+                        }
+                    }
+                });
+            }
+        });
+        assert(map.size() == N / 2);
+        for (int i = 0; i < N; i++) {
+            long value;
+            assert(map.find(i, value) == !(i % 2));
+            if (!(i % 2)) assert(value == -i);
+        }
+        // erased keys can be inserted again
+        assert(map.insert(1, 1));
+        assert(map.size() == N / 2 + 1);
+
+        // buffered inserts are all visible once the scope ends
+        hclib::concurrent_map<std::string, int> words(16);
+        hclib::finish([&]() {
+            for (int t = 0; t < NTASKS; t++) {
+                hclib::async([&, t]() {
+                    for (int i = t; i < N; i += NTASKS) {
+                        words.buffer_insert(std::to_string(i), i);
+                    }
+                });
+            }
+        }, words);
+        assert(words.size() == N);
+        for (int i = 0; i < N; i++) {
+            int value;
+            assert(words.find(std::to_string(i), value) && value == i);
+        }
+    });
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <atomic>
+
+#include "hclib.hpp"
+
+#ifdef HCLIB_COROUTINES
+
+hclib::task<int> add(hclib::future_t<int> *a, hclib::shared_future<int> b) {
+    int x = co_await a;
+    int y = co_await b;
+    co_return x + y;
+}
+
+hclib::task<std::string> describe(hclib::future_t<int> *a,
+        hclib::shared_future<int> b) {
+    // nested coroutines start in place
+    int sum = co_await add(a, b);
+    co_return "sum " + std::to_string(sum);
+}
+
+hclib::task<> count(hclib_future_t *go, std::atomic<int> *counter) {
+    void *datum = co_await go;
+    assert(datum == (void *) 7);
+    counter->fetch_add(1);
+}
+
+hclib::task<> check_length(hclib::shared_future<std::string> s,
+        std::atomic<int> *counter) {
+    std::string value = co_await s;
+    assert(value.size() == 64);
+    counter->fetch_add(1);
+}
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        // suspended until both promises are put by other tasks
+        hclib::promise_t<int> *a = new hclib::promise_t<int>();
+        hclib::promise_t<int> *b = new hclib::promise_t<int>();
+        hclib::shared_future<std::string> s = hclib::co_spawn(
+                describe(a->get_future(), hclib::shared_future<int>(b)));
+        hclib::async([=]() { a->put(1); });
+        hclib::async([=]() { b->put(2); });
+        // coroutines and fibers can wait on each other
+        assert(s.wait() == "sum 3");
+        delete a;
+
+        // the finish scope waits for suspended coroutines
+        constexpr int n = 1000;
+        std::atomic<int> counter(0);
+        hclib_promise_t *go = hclib_promise_create();
+        HCLIB_FINISH {
+            for (int i = 0; i < n; i++) {
+                hclib::co_spawn(count(hclib_get_future_for_promise(go),
+                            &counter));
+            }
+            hclib::async([=]() { hclib_promise_put(go, (void *) 7); });
+        }
+        assert(counter == n);
+
+        // already satisfied futures do not suspend
+        HCLIB_FINISH {
+            hclib::co_spawn(count(hclib_get_future_for_promise(go),
+                        &counter));
+        }
+        assert(counter == n + 1);
+        hclib_promise_free(go);
+
+        // coroutines awaiting the same shared future all read its value
+        counter = 0;
+        HCLIB_FINISH {
+            hclib::promise_t<std::string> *p =
+                new hclib::promise_t<std::string>();
+            hclib::shared_future<std::string> s(p);
+            for (int i = 0; i < 10; i++) {
+                hclib::co_spawn(check_length(s, &counter));
+            }
+            hclib::async([=]() { p->put(std::string(64, 'x')); });
+        }
+        assert(counter == 10);
+    });
+    printf("Exiting...\n");
+    return 0;
+}
+
+#else
+
+int main(int argc, char ** argv) {
+    printf("C++20 coroutines not supported, skipping\n");
+    printf("Exiting...\n");
+    return 0;
+}
+
+#endif
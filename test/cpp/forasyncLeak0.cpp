@@ -0,0 +1,76 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Repeated forasyncs release their loop bodies (10^6 iterations)
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <atomic>
+
+#include "hclib.hpp"
+
+#define NITERS 1000000
+#define H1 4
+
+static std::atomic<long> live(0);
+
+/*
+ * Loop body that keeps track of how many copies of itself are alive.
+ */
+class counted_body {
+    int *ran;
+
+  public:
+    explicit counted_body(int *ran) : ran(ran) { live++; }
+    counted_body(const counted_body &other) : ran(other.ran) { live++; }
+    ~counted_body() { live--; }
+
+    void operator()(int i) const {
+        ran[i]++;
+    }
+};
+
+int main (int argc, char ** argv) {
+    int *ran = (int *)calloc(H1, sizeof(int));
+
+    hclib::launch([=]() {
+        const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT,
+            FORASYNC_MODE_ADAPTIVE };
+        counted_body body(ran);
+        for (int iter = 0; iter < NITERS; iter++) {
+            hclib::finish([&]() {
+                loop_domain_t loop = {0, H1, 1, 1};
+                hclib::forasync1D(&loop, body, modes[iter % 3]);
+            });
+            // only the local copy above is left once the finish is done
+            assert(live.load() == 1);
+        }
+
+        hclib::finish([&]() {
+            loop_domain_t loop = {0, H1, 1, 2};
+            hclib::forasync1D_future(&loop, body)->wait();
+        });
+        assert(live.load() == 1);
+    });
+    assert(live.load() == 0);
+
+    for (int i = 0; i < H1; i++) assert(ran[i] == NITERS + 1);
+    free(ran);
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: hclib::forasync<N> over 4D and 5D strided domains, all modes
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.hpp"
+
+#define H0 9
+#define H1 7
+#define H2 12
+#define H3 10
+#define H4 3
+
+int main (int argc, char ** argv) {
+    int *ran = (int *)malloc(H0*H1*H2*H3*H4*sizeof(int));
+
+    hclib::launch([=]() {
+        const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT,
+            FORASYNC_MODE_ADAPTIVE };
+        for (int mode : modes) {
+            for (int i = 0; i < H0*H1*H2*H3; i++) ran[i] = 0;
+            hclib::finish([=]() {
+                loop_domain64_t loop[4] = {{0, H0, 1, 2}, {1, H1, 2, 3},
+                    {0, H2, 1, 5}, {0, H3, 3, 4}};
+                hclib::forasync<4>(loop, [=](int64_t i, int64_t j, int64_t k,
+                        int64_t l) {
+                    const int idx = ((i*H1 + j)*H2 + k)*H3 + l;
+                    assert(ran[idx] == 0);
+                    ran[idx] = 1;
+                }, mode);
+            });
+            for (int i = 0; i < H0; i++) {
+                for (int j = 0; j < H1; j++) {
+                    for (int k = 0; k < H2; k++) {
+                        for (int l = 0; l < H3; l++) {
+                            const int idx = ((i*H1 + j)*H2 + k)*H3 + l;
+                            assert(ran[idx] == (j % 2 == 1 && l % 3 == 0));
+                        }
+                    }
+                }
+            }
+
+            const int size = H0*H1*H2*H3*H4;
+            for (int i = 0; i < size; i++) ran[i] = 0;
+            loop_domain64_t loop[5] = {{0, H0, 1, 4}, {0, H1, 1, 2},
+                {0, H2, 1, 5}, {0, H3, 1, 3}, {0, H4, 1, 1}};
+            hclib::future_t<void> *done = hclib::forasync_range_future<5>(loop,
+                    [=](const loop_domain64_t &c0, const loop_domain64_t &c1,
+                        const loop_domain64_t &c2, const loop_domain64_t &c3,
+                        const loop_domain64_t &c4) {
+                for (int64_t i = c0.low; i < c0.high; i += c0.stride)
+                for (int64_t j = c1.low; j < c1.high; j += c1.stride)
+                for (int64_t k = c2.low; k < c2.high; k += c2.stride)
+                for (int64_t l = c3.low; l < c3.high; l += c3.stride)
+                for (int64_t m = c4.low; m < c4.high; m += c4.stride) {
+                    const int idx = (((i*H1 + j)*H2 + k)*H3 + l)*H4 + m;
+                    assert(ran[idx] == 0);
+                    ran[idx] = 1;
+                }
+            }, mode);
+            done->wait();
+            for (int i = 0; i < size; i++) assert(ran[i] == 1);
+        }
+    });
+
+    free(ran);
+    printf("Exiting...\n");
+    return 0;
+}
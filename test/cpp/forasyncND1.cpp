@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: forasync over a 1D domain with more than 2^31 iterations
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <atomic>
+
+#include "hclib.hpp"
+
+#define HIGH ((int64_t)5 << 30)
+#define TILE ((int64_t)1 << 26)
+
+int main (int argc, char ** argv) {
+    hclib::launch([=]() {
+        const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT };
+        for (int mode : modes) {
+            std::atomic<int64_t> count(0);
+            std::atomic<int64_t> last(-1);
+            std::atomic<int64_t> *pcount = &count;
+            std::atomic<int64_t> *plast = &last;
+            hclib::finish([=]() {
+                loop_domain64_t loop = {0, HIGH, 3, TILE};
+                hclib::forasync_range<1>(&loop,
+                        [=](const loop_domain64_t &c0) {
+                    // count the tile's iterations without visiting them
+                    assert(c0.low % c0.stride == 0);
+                    const int64_t n = (c0.high - c0.low + c0.stride - 1) /
+                        c0.stride;
+                    const int64_t i = c0.low + n * c0.stride;
+                    *pcount += n;
+                    int64_t prev = plast->load();
+                    while (prev < i - c0.stride &&
+                            !plast->compare_exchange_weak(prev,
+                                i - c0.stride)) { }
+                }, mode);
+            });
+            assert(count.load() == (HIGH + 2) / 3);
+            assert(last.load() == ((HIGH - 1) / 3) * 3);
+        }
+    });
+    printf("Exiting...\n");
+    return 0;
+}
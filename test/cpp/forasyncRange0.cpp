@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Range-based forasyncs in 1D, 2D and 3D, flat and recursive
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.hpp"
+
+#define H1 64
+#define T1 7
+#define H2 32
+#define T2 5
+#define H3 16
+#define T3 3
+
+int main (int argc, char ** argv) {
+    int *ran = (int *)malloc(H1*H2*H3*sizeof(int));
+
+    hclib::launch([=]() {
+        const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT };
+        for (int mode : modes) {
+            for (int i = 0; i < H1; i++) ran[i] = -1;
+            hclib::finish([=]() {
+                loop_domain_t loop = {0, H1, 1, T1};
+                hclib::forasync1D_range(&loop, [=](const loop_domain_t &c0) {
+                    assert(c0.high - c0.low <= T1);
+                    for (int i = c0.low; i < c0.high; i += c0.stride) {
+                        assert(ran[i] == -1);
+                        ran[i] = i;
+                    }
+                }, mode);
+            });
+            for (int i = 0; i < H1; i++) assert(ran[i] == i);
+
+            for (int i = 0; i < H1*H2; i++) ran[i] = -1;
+            hclib::finish([=]() {
+                loop_domain_t loop[2] = {{0, H1, 1, T1}, {0, H2, 1, T2}};
+                hclib::forasync2D_range(loop, [=](const loop_domain_t &c0,
+                        const loop_domain_t &c1) {
+                    for (int i = c0.low; i < c0.high; i += c0.stride) {
+                        for (int j = c1.low; j < c1.high; j += c1.stride) {
+                            assert(ran[i*H2+j] == -1);
+                            ran[i*H2+j] = i*H2+j;
+                        }
+                    }
+                }, mode);
+            });
+            for (int i = 0; i < H1*H2; i++) assert(ran[i] == i);
+
+            for (int i = 0; i < H1*H2*H3; i++) ran[i] = -1;
+            loop_domain_t loop[3] = {{0, H1, 1, T1}, {0, H2, 1, T2},
+                {0, H3, 1, T3}};
+            hclib::future_t<void> *done = hclib::forasync3D_range_future(loop,
+                    [=](const loop_domain_t &c0, const loop_domain_t &c1,
+                        const loop_domain_t &c2) {
+                for (int i = c0.low; i < c0.high; i += c0.stride) {
+                    for (int j = c1.low; j < c1.high; j += c1.stride) {
+                        for (int k = c2.low; k < c2.high; k += c2.stride) {
+                            const int idx = (i*H2+j)*H3+k;
+                            assert(ran[idx] == -1);
+                            ran[idx] = idx;
+                        }
+                    }
+                }
+            }, mode);
+            done->wait();
+            for (int i = 0; i < H1*H2*H3; i++) assert(ran[i] == i);
+        }
+    });
+
+    free(ran);
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+
+#include "hclib.hpp"
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        constexpr int n_launches = 10;
+        constexpr int width = 16;
+
+        std::atomic<int> source(0), middle(0), sink(0);
+        int order_errors = 0;
+        hclib::graph graph([&]() {
+                hclib_future_t *s = hclib::graph_async([&]() { source++; });
+                hclib_future_t *done[width + 1] = { nullptr };
+                for (int i = 0; i < width; i++) {
+                    done[i] = hclib::graph_async([&]() {
+                            if (middle.load() >= source.load() * width) {
+                                order_errors++;
+                            }
+                            middle++;
+                        }, s);
+                }
+                // plain asyncs are recorded too, and run at every launch
+                hclib::async_await([&]() {
+                        if (middle.load() != source.load() * width) {
+                            order_errors++;
+                        }
+                        sink++;
+                    }, done);
+                hclib::async([&]() { sink++; });
+            });
+        // nothing ran during the capture
+        assert(source == 0 && sink == 0);
+        assert(graph.size() == width + 3);
+
+        for (int launch = 1; launch <= n_launches; launch++) {
+            graph.run();
+            assert(source == launch);
+            assert(middle == launch * width);
+            assert(sink == 2 * launch);
+        }
+        assert(order_errors == 0);
+    });
+    printf("Exiting...\n");
+    return 0;
+}
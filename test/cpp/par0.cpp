@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: hclib::par algorithms against their std:: counterparts
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "hclib.hpp"
+
+static std::vector<int> random_ints(size_t n, int max) {
+    std::vector<int> v(n);
+    for (size_t i = 0; i < n; i++) v[i] = rand() % max;
+    return v;
+}
+
+static void check(size_t n) {
+    std::vector<int> in = random_ints(n, 1000);
+
+    std::vector<int> squares(n), expected(n);
+    hclib::par::transform(in.begin(), in.end(), squares.begin(),
+            [](int x) { return x * x; });
+    std::transform(in.begin(), in.end(), expected.begin(),
+            [](int x) { return x * x; });
+    assert(squares == expected);
+
+    std::vector<int> sums(n);
+    hclib::par::transform(in.begin(), in.end(), squares.begin(), sums.begin(),
+            std::plus<int>());
+    std::transform(in.begin(), in.end(), squares.begin(), expected.begin(),
+            std::plus<int>());
+    assert(sums == expected);
+
+    std::vector<int> incremented(in);
+    hclib::par::for_each(incremented.begin(), incremented.end(),
+            [](int &x) { x++; });
+    for (size_t i = 0; i < n; i++) assert(incremented[i] == in[i] + 1);
+
+    assert(hclib::par::reduce(in.begin(), in.end(), 7L) ==
+            std::accumulate(in.begin(), in.end(), 7L));
+    assert(hclib::par::reduce(in.begin(), in.end(), -1,
+                hclib::max_of<int>()) ==
+            std::accumulate(in.begin(), in.end(), -1, hclib::max_of<int>()));
+
+    std::vector<int> scan(n);
+    hclib::par::inclusive_scan(in.begin(), in.end(), scan.begin());
+    std::partial_sum(in.begin(), in.end(), expected.begin());
+    assert(scan == expected);
+    // in place
+    scan = in;
+    hclib::par::inclusive_scan(scan.begin(), scan.end(), scan.begin(),
+            hclib::max_of<int>());
+    std::partial_sum(in.begin(), in.end(), expected.begin(),
+            hclib::max_of<int>());
+    assert(scan == expected);
+
+    std::vector<int> sorted(in);
+    hclib::par::sort(sorted.begin(), sorted.end());
+    expected = in;
+    std::sort(expected.begin(), expected.end());
+    assert(sorted == expected);
+    hclib::par::sort(sorted.begin(), sorted.end(), std::greater<int>());
+    std::reverse(expected.begin(), expected.end());
+    assert(sorted == expected);
+
+    // only movable, not default-constructible
+    std::vector<std::unique_ptr<std::string>> strings;
+    for (size_t i = 0; i < n; i++) {
+        strings.emplace_back(new std::string(std::to_string(in[i])));
+    }
+    hclib::par::sort(strings.begin(), strings.end(),
+            [](const std::unique_ptr<std::string> &a,
+                const std::unique_ptr<std::string> &b) { return *a < *b; });
+    for (size_t i = 1; i < n; i++) assert(*strings[i - 1] <= *strings[i]);
+
+    // stable
+    std::vector<int> parted(in);
+    auto is_even = [](int x) { return x % 2 == 0; };
+    std::vector<int>::iterator mid = hclib::par::partition(parted.begin(),
+            parted.end(), is_even);
+    expected = in;
+    std::vector<int>::iterator expected_mid = std::stable_partition(
+            expected.begin(), expected.end(), is_even);
+    assert(mid - parted.begin() == expected_mid - expected.begin());
+    assert(parted == expected);
+}
+
+int main (int argc, char ** argv) {
+    hclib::launch([]() {
+        const size_t sizes[] = { 0, 1, 2, 17, 2048, 2049, 10007, 300000 };
+        srand(42);
+        for (size_t n : sizes) check(n);
+    });
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "hclib.hpp"
+
+/*
+ * A value larger than a pointer, passed from future to future.
+ */
+struct counts_t {
+    long count;
+    long sum;
+    double avg;
+};
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        constexpr int n_asyncs = 5;
+        hclib::future_t<counts_t> *prev = nullptr;
+
+        HCLIB_FINISH {
+            for (int i = 0; i < n_asyncs; i++) {
+                if (prev) {
+                    auto dep = prev;
+                    prev = hclib::async_future_await([dep]() {
+                            counts_t counts = dep->get();
+                            printf("Running async with count = %ld\n",
+                                counts.count);
+                            counts.count++;
+                            counts.sum += counts.count;
+                            counts.avg = (double)counts.sum / counts.count;
+                            return counts;
+                        }, dep);
+                } else {
+                    prev = hclib::async_future([]() {
+                            printf("Running async with count = 0\n");
+                            return counts_t { 1, 1, 1.0 };
+                        });
+                }
+            }
+        }
+
+        const counts_t end_counts = prev->get();
+        assert(end_counts.count == n_asyncs);
+        assert(end_counts.sum == n_asyncs * (n_asyncs + 1) / 2);
+        assert(end_counts.avg == (n_asyncs + 1) / 2.0);
+
+        std::pair<int, double> pair = hclib::async_future([]() {
+                return std::make_pair(42, 4.2);
+            })->wait();
+        assert(pair.first == 42 && pair.second == 4.2);
+    });
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hclib.hpp"
+
+static int live = 0;
+
+/*
+ * A non-trivially-copyable value that keeps track of its live instances.
+ */
+struct tracked_t {
+    std::vector<int> vals;
+
+    tracked_t() { live++; }
+    tracked_t(const tracked_t &other) : vals(other.vals) { live++; }
+    tracked_t(tracked_t &&other) : vals(std::move(other.vals)) { live++; }
+    ~tracked_t() { live--; }
+};
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        constexpr int n_asyncs = 5;
+        hclib::future_t<std::vector<int>> *prev = nullptr;
+
+        HCLIB_FINISH {
+            for (int i = 0; i < n_asyncs; i++) {
+                if (prev) {
+                    auto dep = prev;
+                    prev = hclib::async_future_await([dep]() {
+                            std::vector<int> vals = dep->get();
+                            printf("Running async with count = %lu\n",
+                                (unsigned long)vals.size());
+                            vals.push_back(vals.size());
+                            return vals;
+                        }, dep);
+                } else {
+                    prev = hclib::async_future([]() {
+                            printf("Running async with count = 0\n");
+                            return std::vector<int>(1, 0);
+                        });
+                }
+            }
+        }
+
+        const std::vector<int> end_vals = prev->get();
+        assert(end_vals.size() == n_asyncs);
+        for (int i = 0; i < n_asyncs; i++) assert(end_vals[i] == i);
+
+        // move-only values
+        hclib::promise_t<std::unique_ptr<std::string>> str_promise;
+        HCLIB_FINISH {
+            hclib::async_await([&]() {
+                    std::unique_ptr<std::string> str =
+                        str_promise.get_future()->get();
+                    assert(*str == "hello");
+                }, str_promise.get_future());
+            str_promise.put(std::unique_ptr<std::string>(
+                        new std::string("hello")));
+        }
+
+        // values are constructed in place, and destroyed with their promise
+        hclib::promise_t<tracked_t> *tracked_promise =
+            new hclib::promise_t<tracked_t>();
+        tracked_promise->emplace();
+        assert(live == 1);
+        assert(tracked_promise->get_future()->wait().vals.empty());
+        assert(live == 1); // the moved-from value is still in the promise
+        delete tracked_promise;
+        assert(live == 0);
+
+        hclib::promise_t<tracked_t> *unput = new hclib::promise_t<tracked_t>();
+        delete unput;
+        assert(live == 0);
+    });
+    printf("Exiting...\n");
+    return 0;
+}
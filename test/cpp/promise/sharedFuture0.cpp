@@ -0,0 +1,109 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+
+#include "hclib.hpp"
+
+static std::atomic<int> live(0);
+
+/*
+ * A future value that keeps track of its live instances, which lets us check
+ * that result promises are deleted along with their last shared_future.
+ */
+struct tracked_t {
+    int val;
+
+    explicit tracked_t(int val) : val(val) { live++; }
+    tracked_t(const tracked_t &other) : val(other.val) { live++; }
+    ~tracked_t() { live--; }
+};
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        constexpr int n_asyncs = 1000;
+
+        // result discarded right away: deleted once the async has put
+        HCLIB_FINISH {
+            for (int i = 0; i < n_asyncs; i++) {
+                hclib::async_future([=]() { return tracked_t(i); });
+            }
+        }
+        assert(live == 0);
+
+        // chain of futures, each consumed by the next async
+        HCLIB_FINISH {
+            hclib::shared_future<tracked_t> prev = hclib::async_future([]() {
+                    return tracked_t(0);
+                });
+            for (int i = 1; i < n_asyncs; i++) {
+                prev = hclib::async_future_await([=]() mutable {
+                        return tracked_t(prev.get().val + 1);
+                    }, prev);
+            }
+            assert(prev.wait().val == n_asyncs - 1);
+        }
+        assert(live == 0);
+
+        // several handles on the same future
+        hclib::shared_future<tracked_t> shared;
+        HCLIB_FINISH {
+            hclib::shared_future<tracked_t> fut = hclib::async_future([]() {
+                    return tracked_t(42);
+                });
+            shared = fut;
+            for (int i = 0; i < 10; i++) {
+                hclib::async_await([=]() mutable {
+                        assert(fut->owner->datum != NULL);
+                    }, fut);
+            }
+        }
+        assert(live == 1);
+        assert(shared.get().val == 42);
+        shared = hclib::shared_future<tracked_t>();
+        assert(live == 0);
+
+        // every handle and continuation reads the value, none takes it
+        HCLIB_FINISH {
+            hclib::shared_future<std::vector<int>> fut =
+                hclib::async_future([]() { return std::vector<int>(100, 1); });
+            std::vector<hclib::shared_future<size_t>> sizes;
+            for (int i = 0; i < 10; i++) {
+                hclib::shared_future<std::vector<int>> copy = fut;
+                hclib::async_await([=]() mutable {
+                        assert(copy.get().size() == 100);
+                    }, copy);
+                sizes.push_back(fut.then([](std::vector<int> v) {
+                        return v.size();
+                    }));
+            }
+            for (auto &size : sizes) {
+                assert(size.wait() == 100);
+            }
+            assert(fut.wait().size() == 100);
+        }
+
+        hclib::shared_future<void> done = hclib::nonblocking_finish([]() {
+                hclib::async([]() { });
+            });
+        done.wait();
+    });
+    printf("Exiting...\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "hclib.hpp"
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        // chain of spawned continuations, changing the value type
+        hclib::promise_t<int> p;
+        hclib::shared_future<std::string> str = p.get_future()->then(
+                [](int x) { return x * 2; }).then([](int x) {
+                    return std::to_string(x);
+                });
+        hclib::async([&]() { p.put(21); });
+        assert(str.wait() == "42");
+
+        // inline continuations run within the put
+        hclib::promise_t<int> q;
+        int seen = 0;
+        hclib::shared_future<void> done = q.get_future()->then_inline(
+                [&](int x) { seen = x; });
+        assert(seen == 0);
+        q.put(7);
+        assert(seen == 7);
+        done.wait();
+
+        // on a satisfied future, they run right away
+        hclib::shared_future<int> now = q.get_future()->then_inline(
+                [](int x) { return x + 1; });
+        assert(now.get() == 8);
+
+        // long inline chains fall back to spawning past the depth bound
+        constexpr int chain = 1000;
+        hclib::promise_t<void> start;
+        hclib::shared_future<int> tail = start.get_future()->then_inline(
+                []() { return 0; });
+        for (int i = 0; i < chain; i++) {
+            tail = tail.then_inline([](int x) { return x + 1; });
+        }
+        start.put();
+        assert(tail.wait() == chain);
+
+        // values stored in the promise are copied to the continuation
+        hclib::shared_future<size_t> len = hclib::async_future([]() {
+                return std::vector<int>(100, 1);
+            }).then([](std::vector<int> v) { return v.size(); });
+        assert(len.wait() == 100);
+
+        // continuations belong to the finish scope they are created in
+        int count = 0;
+        HCLIB_FINISH {
+            hclib::promise_t<int> *r = new hclib::promise_t<int>();
+            hclib::shared_future<int> fut(r);
+            fut.then([&](int x) { count += x; });
+            fut.then_inline([&](int x) { count += x; });
+            hclib::async([=]() { r->put(1); });
+        }
+        assert(count == 2);
+
+        // inline continuations may block, and resume on another worker
+        for (int i = 0; i < 100; i++) {
+            hclib::promise_t<int> *a = new hclib::promise_t<int>();
+            hclib::promise_t<int> *b = new hclib::promise_t<int>();
+            hclib::shared_future<int> fa(a), fb(b);
+            hclib::shared_future<int> sum = fa.then_inline([=](int x) {
+                    return x + fb.wait();
+                });
+            hclib::async([=]() { a->put(1); });
+            hclib::async([=]() { b->put(i); });
+            assert(sum.wait() == 1 + i);
+        }
+    });
+    printf("Exiting...\n");
+    return 0;
+}
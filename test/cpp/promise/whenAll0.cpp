@@ -0,0 +1,106 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+#include <atomic>
+
+#include "hclib.hpp"
+
+int main(int argc, char ** argv) {
+    hclib::launch([]() {
+        constexpr int n_promises = 100;
+
+        // when_all over a range, with the inputs put in reverse order
+        std::vector<hclib::promise_t<int>*> promises;
+        std::vector<hclib_future_t*> futures;
+        for (int i = 0; i < n_promises; i++) {
+            promises.push_back(new hclib::promise_t<int>());
+            futures.push_back(promises[i]->get_future());
+        }
+        std::atomic<int> sum(0);
+        HCLIB_FINISH {
+            hclib::async_await([&]() {
+                    for (int i = 0; i < n_promises; i++) {
+                        sum += promises[i]->get_future()->get();
+                    }
+                }, hclib::when_all(futures.begin(), futures.end()));
+            for (int i = n_promises - 1; i >= 0; i--) {
+                hclib::async([=]() { promises[i]->put(i); });
+            }
+        }
+        assert(sum == n_promises * (n_promises - 1) / 2);
+        for (int i = 0; i < n_promises; i++) {
+            delete promises[i];
+        }
+
+        // variadic when_all on shared_futures, one already satisfied
+        hclib::shared_future<int> a = hclib::async_future([]() { return 1; });
+        a.wait();
+        hclib::shared_future<int> b = hclib::async_future([]() { return 2; });
+        hclib::shared_future<void> both = hclib::when_all(a, b);
+        both.wait();
+        assert(a.get() + b.get() == 3);
+
+        // nothing to wait for
+        hclib::when_all().wait();
+        hclib::when_all(futures.begin(), futures.begin()).wait();
+
+        // when_any gives the index of the first input to be satisfied
+        hclib::promise_t<int> never;
+        hclib::promise_t<int> soon;
+        hclib::shared_future<size_t> any = hclib::when_any(
+                never.get_future(), soon.get_future());
+        hclib::async([&]() { soon.put(3); });
+        assert(any.wait() == 1);
+        hclib::shared_future<size_t> first = hclib::when_any(
+                soon.get_future(), never.get_future());
+        assert(first.wait() == 0);
+
+        // over an array of futures, awaited along with another future
+        hclib::promise_t<int> q0, q1, q2;
+        hclib_future_t *array[] = { q0.get_future(), q1.get_future() };
+        hclib::shared_future<void> pair = hclib::when_all(array, array + 2);
+        hclib::shared_future<size_t> either = hclib::when_any(array,
+                array + 2);
+        int total = 0;
+        HCLIB_FINISH {
+            hclib::async_await([&]() {
+                    total = q0.get_future()->get() + q1.get_future()->get() +
+                        q2.get_future()->get();
+                }, pair, q2.get_future());
+            hclib::async([&]() { q1.put(1); });
+            hclib::async([&]() { q0.put(2); });
+            hclib::async([&]() { q2.put(3); });
+        }
+        assert(total == 6);
+        assert(either.wait() == 0 || either.get() == 1);
+
+        // combined futures can themselves be combined
+        hclib::promise_t<void> p0, p1, p2;
+        hclib::shared_future<void> all = hclib::when_all(
+                hclib::when_any(p0.get_future(), p1.get_future()),
+                p2.get_future());
+        hclib::async([&]() { p1.put(); });
+        hclib::async([&]() { p2.put(); });
+        all.wait();
+        p0.put();
+        never.put(0);
+    });
+    printf("Exiting...\n");
+    return 0;
+}
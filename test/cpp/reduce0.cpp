@@ -0,0 +1,58 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Sum reductions over 1D, 2D and 3D forasync domains
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.hpp"
+
+#define H1 1024
+#define T1 33
+#define H2 64
+#define T2 7
+#define H3 32
+#define T3 5
+
+int main (int argc, char ** argv) {
+    hclib::launch([]() {
+        const int modes[] = { FORASYNC_MODE_RECURSIVE, FORASYNC_MODE_FLAT };
+        auto sum = [](long a, long b) { return a + b; };
+
+        for (int mode : modes) {
+            loop_domain_t loop1 = {0, H1, 1, T1};
+            long res1 = hclib::forasync1D_reduce(&loop1, 0L,
+                    [](int i) { return (long)i; }, sum, mode);
+            assert(res1 == (long)H1 * (H1 - 1) / 2);
+
+            loop_domain_t loop2[2] = {{0, H2, 1, T2}, {0, H2, 1, T2}};
+            long res2 = hclib::forasync2D_reduce(loop2, 0L,
+                    [](int i, int j) { return (long)(i * H2 + j); }, sum, mode);
+            assert(res2 == (long)(H2 * H2) * (H2 * H2 - 1) / 2);
+
+            loop_domain_t loop3[3] = {{0, H3, 1, T3}, {0, H3, 1, T3},
+                {0, H3, 1, T3}};
+            long res3 = hclib::forasync3D_reduce(loop3, 0L,
+                    [](int i, int j, int k) { return 1L; }, sum, mode);
+            assert(res3 == (long)H3 * H3 * H3);
+        }
+    });
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * DESC: Future-returning forasync reductions with a non-additive operator
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "hclib.hpp"
+
+#define H1 4096
+#define T1 100
+
+int main (int argc, char ** argv) {
+    int *vals = (int *)malloc(H1 * sizeof(int));
+    for (int i = 0; i < H1; i++) {
+        vals[i] = (i * 7919) % H1;
+    }
+
+    hclib::launch([=]() {
+        auto max = [](int a, int b) { return a > b ? a : b; };
+
+        loop_domain_t loop1 = {0, H1, 1, T1};
+        hclib::future_t<int> *max1 = hclib::forasync1D_reduce_future(&loop1,
+                -1, [=](int i) { return vals[i]; }, max);
+
+        loop_domain_t loop2[2] = {{0, H1 / 64, 1, 3}, {0, 64, 1, 5}};
+        hclib::future_t<int> *max2 = hclib::forasync2D_reduce_future(loop2,
+                -1, [=](int i, int j) { return vals[i * 64 + j] / 2; }, max,
+                FORASYNC_MODE_FLAT);
+
+        loop_domain_t loop3[3] = {{0, 16, 1, 3}, {0, 16, 1, 5}, {0, 16, 1, 7}};
+        hclib::future_t<int> *count3 = hclib::forasync3D_reduce_future(loop3,
+                0, [](int i, int j, int k) { return 1; },
+                [](int a, int b) { return a + b; });
+
+        assert(max1->wait() == H1 - 1);
+        assert(max2->wait() == (H1 - 1) / 2);
+        assert(count3->wait() == 16 * 16 * 16);
+    });
+    free(vals);
+    printf("OK\n");
+    return 0;
+}
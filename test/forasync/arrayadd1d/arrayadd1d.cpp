@@ -18,9 +18,16 @@
  * HC CONCORD foreach add.hc example 
  */
 
+
 #include "hclib.hpp"
 #include <sys/time.h>
 
+static double mysecond() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + ((double) tv.tv_usec / 1000000);
+}
+
 using namespace std;
 
 void check(int *a,int val,int num_iters){
@@ -61,6 +68,7 @@ int main(int argc, char *argv[])
 
         }
        //Add the elements of arrays b and c and store them in a
+       double start = mysecond();
        hclib::finish([=]() {
          hclib::loop_domain_t loop = {0, num_iters, 1, tilesize};
          hclib::forasync1D(&loop, [=](int i) {
@@ -68,8 +76,28 @@ int main(int argc, char *argv[])
          }, FORASYNC_MODE_RECURSIVE);
          //}, FORASYNC_MODE_FLAT);
        });
+       const double index_time = mysecond() - start;
+
+       check(a,101,num_iters);
+
+       //Same again, with one call per tile so the inner loop can vectorize
+       for(i=0; i<num_iters; i++){
+        a[i]=0;
+       }
+       start = mysecond();
+       hclib::finish([=]() {
+         hclib::loop_domain_t loop = {0, num_iters, 1, tilesize};
+         hclib::forasync1D_range(&loop, [=](const hclib::loop_domain_t &c0) {
+            for (int i = c0.low; i < c0.high; i += c0.stride) {
+                a[i]=b[i]+c[i];
+            }
+         }, FORASYNC_MODE_RECURSIVE);
+       });
+       const double range_time = mysecond() - start;
 
        check(a,101,num_iters);
+       printf("per-index=%.3f ms range=%.3f ms\n", index_time * 1000,
+               range_time * 1000);
        printf("Test passed\n");
    });
    return 0;
@@ -19,6 +19,13 @@
  */
 
 #include "hclib.hpp"
+#include <sys/time.h>
+
+static double mysecond() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + ((double) tv.tv_usec / 1000000);
+}
 
 void check(int *a,int val,int num_iters){
 	int i;
@@ -66,6 +73,7 @@ int main(int argc, char *argv[])
 
         }
         //Add the elements of arrays b and c and store them in a
+        double start = mysecond();
         hclib::finish([=]() {
             hclib::loop_domain_t loop[3] = {{0, num_iters1, 1, tilesize1},
             {0, num_iters2, 1, tilesize2}, {0, num_iters3, 1, tilesize3}} ;
@@ -74,8 +82,36 @@ int main(int argc, char *argv[])
             }, FORASYNC_MODE_RECURSIVE);
             //}, FORASYNC_MODE_FLAT);
         });
+        const double index_time = mysecond() - start;
+
+        check(a,101,num_iters1*num_iters2*num_iters3);
+
+        //Same again, with one call per tile so the inner loop can vectorize
+        for(i=0; i<num_iters1*num_iters2*num_iters3; i++){
+            a[i]=0;
+        }
+        start = mysecond();
+        hclib::finish([=]() {
+            hclib::loop_domain_t loop[3] = {{0, num_iters1, 1, tilesize1},
+            {0, num_iters2, 1, tilesize2}, {0, num_iters3, 1, tilesize3}} ;
+            hclib::forasync3D_range(loop, [=](const hclib::loop_domain_t &c0,
+                    const hclib::loop_domain_t &c1,
+                    const hclib::loop_domain_t &c2) {
+                for (int i = c0.low; i < c0.high; i += c0.stride) {
+                    for (int j = c1.low; j < c1.high; j += c1.stride) {
+                        const int row = i*num_iters2*num_iters3+j*num_iters3;
+                        for (int k = c2.low; k < c2.high; k += c2.stride) {
+                            a[row+k]=b[row+k]+c[row+k];
+                        }
+                    }
+                }
+            }, FORASYNC_MODE_RECURSIVE);
+        });
+        const double range_time = mysecond() - start;
 
         check(a,101,num_iters1*num_iters2*num_iters3);
+        printf("per-index=%.3f ms range=%.3f ms\n", index_time * 1000,
+                range_time * 1000);
         printf("Test passed\n");
     });
 	return 0;
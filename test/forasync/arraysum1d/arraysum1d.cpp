@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Sum the elements of an array with forasync1D_reduce, and compare against the
+ * hand-written baseline of atomically adding into a single shared counter.
+ */
+
+#include "hclib.hpp"
+#include <atomic>
+#include <sys/time.h>
+
+static double mysecond() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + ((double) tv.tv_usec / 1000000);
+}
+
+int main(int argc, char *argv[])
+{
+    hclib::launch([=]() {
+        if (argc != 3) {
+            printf("USAGE:./arraysum1d NUM_ITERS TILE_SIZE\n");
+            exit(1);
+        }
+        const int num_iters = atoi(argv[1]);
+        const int tilesize = atoi(argv[2]);
+
+        int *a = (int *)malloc(sizeof(int) * num_iters);
+        for (int i = 0; i < num_iters; i++) {
+            a[i] = i % 100;
+        }
+        long expected = 0;
+        for (int i = 0; i < num_iters; i++) {
+            expected += a[i];
+        }
+
+        hclib::loop_domain_t loop = {0, num_iters, 1, tilesize};
+
+        // Baseline: every iteration atomically adds into one shared counter
+        std::atomic<long> atomic_sum(0);
+        std::atomic<long> *atomic_sum_ptr = &atomic_sum;
+        double start = mysecond();
+        hclib::finish([=]() {
+            hclib::loop_domain_t atomic_loop = loop;
+            hclib::forasync1D(&atomic_loop, [=](int i) {
+                atomic_sum_ptr->fetch_add(a[i], std::memory_order_relaxed);
+            }, FORASYNC_MODE_RECURSIVE);
+        });
+        const double atomic_time = mysecond() - start;
+
+        // Per-worker partial sums combined at the end of the reduction
+        start = mysecond();
+        const long reduce_sum = hclib::forasync1D_reduce(&loop, 0L,
+                [=](int i) { return (long)a[i]; },
+                [](long x, long y) { return x + y; }, FORASYNC_MODE_RECURSIVE);
+        const double reduce_time = mysecond() - start;
+
+        if (atomic_sum.load() != expected || reduce_sum != expected) {
+            printf("ERROR expected %ld, atomic=%ld, reduce=%ld\n", expected,
+                    atomic_sum.load(), reduce_sum);
+            exit(1);
+        }
+
+        printf("workers=%d atomic=%.3f ms reduce=%.3f ms speedup=%.2fx\n",
+                hclib::num_workers(), atomic_time * 1000, reduce_time * 1000,
+                atomic_time / reduce_time);
+        printf("Test passed\n");
+        free(a);
+    });
+    return 0;
+}
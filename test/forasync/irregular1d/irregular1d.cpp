@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A 1D loop whose iterations have very uneven costs (most are cheap, a few
+ * are expensive, and cost grows towards the end of the domain). Compares the
+ * flat and recursive modes for a given tile size against the adaptive mode,
+ * which needs no tile size.
+ */
+
+#include "hclib.hpp"
+#include <sys/time.h>
+
+static double mysecond() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + ((double) tv.tv_usec / 1000000);
+}
+
+static int work(int i, int num_iters) {
+    int cost = 1 + (int)((long)i * 64 / num_iters);
+    if (i % 97 == 0) cost *= 100;
+    unsigned x = i;
+    for (int k = 0; k < cost * 50; k++) {
+        x = x * 1103515245 + 12345;
+    }
+    return (int)(x & 1);
+}
+
+int main(int argc, char *argv[])
+{
+    hclib::launch([=]() {
+        if (argc != 3) {
+            printf("USAGE:./irregular1d NUM_ITERS TILE_SIZE\n");
+            exit(1);
+        }
+        const int num_iters = atoi(argv[1]);
+        const int tilesize = atoi(argv[2]);
+        int *a = (int *)malloc(sizeof(int) * num_iters);
+
+        int expected = 0;
+        for (int i = 0; i < num_iters; i++) {
+            expected += work(i, num_iters);
+        }
+
+        const int modes[] = { FORASYNC_MODE_FLAT, FORASYNC_MODE_RECURSIVE,
+            FORASYNC_MODE_ADAPTIVE };
+        const char *names[] = { "flat", "recursive", "adaptive" };
+        for (int m = 0; m < 3; m++) {
+            const int mode = modes[m];
+            for (int i = 0; i < num_iters; i++) a[i] = 0;
+
+            const double start = mysecond();
+            hclib::finish([=]() {
+                hclib::loop_domain_t loop = {0, num_iters, 1, tilesize};
+                hclib::forasync1D(&loop, [=](int i) {
+                    a[i] = work(i, num_iters);
+                }, mode);
+            });
+            const double elapsed = mysecond() - start;
+
+            int sum = 0;
+            for (int i = 0; i < num_iters; i++) sum += a[i];
+            if (sum != expected) {
+                printf("ERROR %s: sum=%d != %d\n", names[m], sum, expected);
+                exit(1);
+            }
+            printf("workers=%d mode=%s tile=%d time=%.3f ms\n",
+                    hclib::num_workers(), names[m], tilesize, elapsed * 1000);
+        }
+        printf("Test passed\n");
+        free(a);
+    });
+    return 0;
+}
@@ -21,3 +21,9 @@ echo "========== Running arrayadd2d =========="
 
 echo "========== Running arrayadd3d =========="
 ./arrayadd3d/arrayadd3d 1024 1024 2048 100 50 77
+
+echo "========== Running arraysum1d =========="
+./arraysum1d/arraysum1d 1048576 1024
+
+echo "========== Running irregular1d =========="
+./irregular1d/irregular1d 100000 1000
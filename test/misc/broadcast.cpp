@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Broadcast dependency: many tasks await the same promise, and are all made
+ * ready by a single put.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <atomic>
+#include <sys/time.h>
+using namespace std;
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        int waiters = argc <= 1 ? 8000 : atoi(argv[1]);
+        int rounds = argc <= 2 ? 100 : atoi(argv[2]);
+
+        std::atomic<long> count(0);
+        long put_time = 0;
+        long start = get_usecs();
+        for (int r = 0; r < rounds; r++) {
+            hclib::promise_t<void> promise;
+            hclib_future_t *fs[] = { promise.get_future(), NULL };
+            HCLIB_FINISH {
+                for (int i = 0; i < waiters; i++) {
+                    hclib::async_await([&]() { count++; }, fs);
+                }
+                long before_put = get_usecs();
+                promise.put();
+                put_time += get_usecs() - before_put;
+            }
+        }
+        long end = get_usecs();
+
+        assert(count == (long) waiters * rounds);
+        cout << rounds << " broadcasts to " << waiters << " waiters: " <<
+            ((double)(end-start))/1000 << " ms, put " <<
+            ((double)put_time)/1000 << " ms" << endl;
+    });
+    return 0;
+}
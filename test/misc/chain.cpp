@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Long chain of dependent steps, each a few instructions, built either from
+ * async_future_await or from future continuations, spawned or run inline.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+using namespace std;
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
+}
+
+template<typename S>
+void run(const string &name, int length, S step) {
+    hclib::promise_t<long> *start = new hclib::promise_t<long>();
+    hclib::shared_future<long> tail(start);
+    hclib_promise_retain(start);
+
+    long t0 = get_usecs();
+    for (int i = 0; i < length; i++) {
+        tail = step(tail);
+    }
+    long t1 = get_usecs();
+    start->put(0);
+    hclib_promise_release(start);
+    long res = tail.wait();
+    long t2 = get_usecs();
+
+    assert(res == length);
+    cout << name << ((double)(t1-t0))/1000 << " ms to build, " <<
+        ((double)(t2-t1))/1000 << " ms to run" << endl;
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        int length = argc <= 1 ? 1000000 : atoi(argv[1]);
+
+        cout << "Chain of " << length << " steps" << endl;
+        run("async_future_await: ", length, [](hclib::shared_future<long> prev) {
+                return hclib::async_future_await([=]() mutable {
+                        return prev.get() + 1;
+                    }, prev);
+            });
+        run("then:               ", length, [](hclib::shared_future<long> prev) {
+                return prev.then([](long x) { return x + 1; });
+            });
+        run("then_inline:        ", length, [](hclib::shared_future<long> prev) {
+                return prev.then_inline([](long x) { return x + 1; });
+            });
+    });
+    return 0;
+}
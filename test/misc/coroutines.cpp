@@ -0,0 +1,178 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Cost of suspending many tasks on a future: blocking each in
+ * future_t::wait(), which parks it on its own fiber, against co_await in a
+ * coroutine, which parks only its frame. Reports the time to spawn and suspend
+ * and to resume each task, and the memory held per suspended task.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <time.h>
+#include <unistd.h>
+using namespace std;
+
+#ifdef HCLIB_COROUTINES
+
+static atomic<size_t> heap_bytes(0);
+
+void *operator new(size_t size) {
+    heap_bytes += size;
+    void *ptr = malloc(size);
+    if (!ptr) throw bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct memory {
+    long vsize;
+    long rss;
+};
+
+static memory read_memory() {
+    memory mem = { 0, 0 };
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &mem.vsize, &mem.rss) != 2) {
+            mem.vsize = mem.rss = 0;
+        }
+        fclose(statm);
+    }
+    const long page = sysconf(_SC_PAGESIZE);
+    mem.vsize *= page;
+    mem.rss *= page;
+    return mem;
+}
+
+struct measurement {
+    uint64_t start, suspended, end;
+    memory before, held;
+    size_t heap_before, heap_held;
+};
+
+/*
+ * Spawns n waiters on a promise through spawn_waiter. Each waiter counts
+ * itself in arrived before suspending, and the last one releases the task
+ * that takes the measurements and wakes them all.
+ */
+template <typename S>
+static measurement run(int n, S spawn_waiter) {
+    measurement s;
+    hclib::promise_t<int> go;
+    hclib::promise_t<void> all_arrived;
+    atomic<int> arrived(0);
+    atomic<long> sum(0);
+
+    s.before = read_memory();
+    s.heap_before = heap_bytes;
+    s.start = now_ns();
+    HCLIB_FINISH {
+        hclib::async_await([&]() {
+            s.suspended = now_ns();
+            s.held = read_memory();
+            s.heap_held = heap_bytes;
+            go.put(1);
+        }, all_arrived.get_future());
+        for (int i = 0; i < n; i++) {
+            spawn_waiter(go.get_future(), &all_arrived, &arrived, &sum, n);
+        }
+    }
+    s.end = now_ns();
+    if (sum != n) {
+        cerr << "Error: " << sum << " of " << n << " tasks resumed" << endl;
+        exit(1);
+    }
+    return s;
+}
+
+static void arrive(hclib::promise_t<void> *all_arrived, atomic<int> *arrived,
+        int n) {
+    if (arrived->fetch_add(1) + 1 == n) all_arrived->put();
+}
+
+static hclib::task<> waiter(hclib::future_t<int> *go,
+        hclib::promise_t<void> *all_arrived, atomic<int> *arrived,
+        atomic<long> *sum, int n) {
+    arrive(all_arrived, arrived, n);
+    *sum += co_await go;
+}
+
+static void report(const char *name, int n, const measurement &s) {
+    printf("%-10s suspend %8.0f ns/task, resume %8.0f ns/task, "
+            "rss %8.0f B/task, vsize %8.0f B/task, heap %6.0f B/task\n",
+            name, (double) (s.suspended - s.start) / n,
+            (double) (s.end - s.suspended) / n,
+            (double) (s.held.rss - s.before.rss) / n,
+            (double) (s.held.vsize - s.before.vsize) / n,
+            (double) (s.heap_held - s.heap_before) / n);
+}
+
+int main(int argc, char** argv) {
+    const int n = argc <= 1 ? 4000 : atoi(argv[1]);
+    const int reps = argc <= 2 ? 3 : atoi(argv[2]);
+
+    hclib::launch([=]() {
+        printf("%d suspended tasks, %d workers\n", n, hclib_num_workers());
+        for (int r = 0; r < reps; r++) {
+            measurement fiber = run(n, [](hclib::future_t<int> *go,
+                        hclib::promise_t<void> *all_arrived,
+                        atomic<int> *arrived, atomic<long> *sum, int n) {
+                hclib::async([=]() {
+                    arrive(all_arrived, arrived, n);
+                    *sum += go->wait();
+                });
+            });
+            report("wait()", n, fiber);
+
+            measurement coroutine = run(n, [](hclib::future_t<int> *go,
+                        hclib::promise_t<void> *all_arrived,
+                        atomic<int> *arrived, atomic<long> *sum, int n) {
+                hclib::co_spawn(waiter(go, all_arrived, arrived, sum, n));
+            });
+            report("co_await", n, coroutine);
+        }
+    });
+    return 0;
+}
+
+#else
+
+int main(int argc, char** argv) {
+    printf("C++20 coroutines not supported, skipping\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Layered DAG of tasks: each of the width nodes of a layer waits on fanin
+ * nodes of the previous layer. All of the tasks are created before the first
+ * layer is released, and each one waits either on its raw list of futures,
+ * allocated for it, or on a single when_all future.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <sys/time.h>
+using namespace std;
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
+}
+
+double run(int layers, int width, int fanin, bool combined) {
+    hclib::promise_t<void> *nodes = new hclib::promise_t<void>[layers * width];
+    vector<hclib_future_t*> inputs(fanin);
+
+    long start = get_usecs();
+    HCLIB_FINISH {
+        for (int l = 1; l < layers; l++) {
+            for (int i = 0; i < width; i++) {
+                for (int j = 0; j < fanin; j++) {
+                    // spread the inputs over the previous layer
+                    const int in = (i + j * (width / fanin + 1)) % width;
+                    inputs[j] = nodes[(l - 1) * width + in].get_future();
+                }
+
+                hclib::promise_t<void> *node = &nodes[l * width + i];
+                if (combined) {
+                    hclib::async_await([=]() { node->put(); },
+                            hclib::when_all(inputs.data(),
+                                inputs.data() + fanin));
+                } else {
+                    // the list has to outlive the wait on it
+                    hclib_future_t **fs = new hclib_future_t*[fanin + 1];
+                    copy(inputs.begin(), inputs.end(), fs);
+                    fs[fanin] = NULL;
+                    hclib::async_await([=]() { node->put(); delete[] fs; },
+                            fs);
+                }
+            }
+        }
+        for (int i = 0; i < width; i++) {
+            nodes[i].put();
+        }
+    }
+    long end = get_usecs();
+
+    delete[] nodes;
+    return ((double)(end-start))/1000;
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        int layers = argc <= 1 ? 100 : atoi(argv[1]);
+        int width = argc <= 2 ? 1000 : atoi(argv[2]);
+        int fanin = argc <= 3 ? 4 : atoi(argv[3]);
+
+        cout << "DAG of " << layers << " x " << width << " nodes, fan-in " <<
+            fanin << endl;
+        cout << "future list: " << run(layers, width, fanin, false) <<
+            " ms" << endl;
+        cout << "when_all:    " << run(layers, width, fanin, true) <<
+            " ms" << endl;
+    });
+    return 0;
+}
@@ -16,6 +16,8 @@
 
 #include "hclib.hpp"
 #include <iostream>
+#include <sys/resource.h>
+#include <sys/time.h>
 using namespace std;
 
 static int threshold = 2;
@@ -25,6 +27,10 @@ int fib_serial(int n) {
     return fib_serial(n-1) + fib_serial(n-2);
 }
 
+/*
+ * Each promise is owned by the shared_future of its consumer, and is deleted
+ * once the consumer is done with it.
+ */
 void fib(int n, hclib::promise_t<int>* res) {
   int r;
   if (n <= threshold) {
@@ -34,34 +40,50 @@ void fib(int n, hclib::promise_t<int>* res) {
   } 
 
   // compute f1 asynchronously
-  hclib::promise_t<int>* f1 = new hclib::promise_t<int>();
+  hclib::promise_t<int>* p1 = new hclib::promise_t<int>();
+  hclib::shared_future<int> f1(p1);
   hclib::async([=]() { 
-    fib(n - 1, f1);
+    fib(n - 1, p1);
   });
 
   // compute f2 serially (f1 is done asynchronously).
-  hclib::promise_t<int>* f2 = new hclib::promise_t<int>();
+  hclib::promise_t<int>* p2 = new hclib::promise_t<int>();
+  hclib::shared_future<int> f2(p2);
   hclib::async([=]() { 
-    fib(n - 2, f2);
+    fib(n - 2, p2);
   });
 
   // wait for dependences, before updating the result
-  hclib::async_await([=] {
-    int r = f1->get_future()->get() + f2->get_future()->get();
+  hclib::async_await([=]() mutable {
+    int r = f1.get() + f2.get();
     res->put(r);
-  }, f1->get_future(), f2->get_future());
+  }, f1, f2);
+}
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
 }
 
 int main(int argc, char** argv) {
     hclib::launch([=]() {
         int n = argc == 1 ? 30 : atoi(argv[1]);
-        threshold = argc == 2 ? 10 : atoi(argv[2]);
+        threshold = argc <= 2 ? 10 : atoi(argv[2]);
+        long start = get_usecs();
         hclib::promise_t<int>* promise = new hclib::promise_t<int>();
+        hclib::shared_future<int> result(promise);
         HCLIB_FINISH {
             fib(n, promise);
         }
-        int res = promise->get_future()->get();
-        cout << "Fib(" << n << ") = " << res << endl;
+        int res = result.get();
+        long end = get_usecs();
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        cout << "Fib(" << n << ") = " << res << ". Time = " <<
+            ((double)(end-start))/1000000 << " s, max RSS = " <<
+            usage.ru_maxrss << " KB" << endl;
     });
     return 0;
 }
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Scans a set of files, hashing each one chunk by chunk, either with blocking
+ * reads or with hclib_async_read fetching the next chunk while the current one
+ * is hashed.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+using namespace std;
+
+#define CHUNK (64 * 1024)
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
+}
+
+static uint64_t hash_chunk(uint64_t h, const char *buf, long n) {
+    for (long i = 0; i < n; i++) {
+        h = (h ^ (unsigned char) buf[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t scan_blocking(const string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    assert(fd >= 0);
+    vector<char> buf(CHUNK);
+    uint64_t h = 14695981039346656037ULL;
+    long n;
+    while ((n = read(fd, buf.data(), CHUNK)) > 0) {
+        h = hash_chunk(h, buf.data(), n);
+    }
+    assert(n == 0);
+    close(fd);
+    return h;
+}
+
+uint64_t scan_async(const string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    assert(fd >= 0);
+    vector<char> bufs[2] = { vector<char>(CHUNK), vector<char>(CHUNK) };
+    uint64_t h = 14695981039346656037ULL;
+    int cur = 0;
+    hclib_future_t *pending = hclib_async_read(fd, bufs[cur].data(), CHUNK);
+    long n;
+    while ((n = (long) (intptr_t) hclib_future_wait(pending)) > 0) {
+        hclib_future_release(pending);
+        pending = hclib_async_read(fd, bufs[1 - cur].data(), CHUNK);
+        h = hash_chunk(h, bufs[cur].data(), n);
+        cur = 1 - cur;
+    }
+    assert(n == 0);
+    hclib_future_release(pending);
+    close(fd);
+    return h;
+}
+
+template <typename SCAN>
+uint64_t scan_all(const vector<string> &paths, SCAN scan) {
+    vector<uint64_t> hashes(paths.size());
+    HCLIB_FINISH {
+        for (size_t i = 0; i < paths.size(); i++) {
+            hclib::async([&paths, &hashes, scan, i]() {
+                    hashes[i] = scan(paths[i]);
+                });
+        }
+    }
+    uint64_t h = 0;
+    for (uint64_t x : hashes) h ^= x;
+    return h;
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        const int nfiles = argc <= 1 ? 32 : atoi(argv[1]);
+        const long size = (argc <= 2 ? 4 : atol(argv[2])) << 20;
+
+        char dir[] = "/tmp/hclib-filescan-XXXXXX";
+        if (!mkdtemp(dir)) {
+            perror("mkdtemp");
+            exit(1);
+        }
+        vector<string> paths;
+        vector<char> data(size);
+        srand(42);
+        for (int f = 0; f < nfiles; f++) {
+            for (long i = 0; i < size; i++) {
+                data[i] = (char) rand();
+            }
+            paths.push_back(string(dir) + "/" + to_string(f));
+            const int fd = open(paths.back().c_str(),
+                    O_WRONLY | O_CREAT | O_TRUNC, 0600);
+            assert(fd >= 0);
+            const long written = write(fd, data.data(), size);
+            assert(written == size);
+            close(fd);
+        }
+
+        long start = get_usecs();
+        const uint64_t h1 = scan_all(paths, scan_blocking);
+        long end = get_usecs();
+        const double blocking_ms = (end - start) / 1000.0;
+        start = get_usecs();
+        const uint64_t h2 = scan_all(paths, scan_async);
+        end = get_usecs();
+        const double async_ms = (end - start) / 1000.0;
+        assert(h1 == h2);
+
+        for (const string &path : paths) {
+            unlink(path.c_str());
+        }
+        rmdir(dir);
+
+        cout << nfiles << " files of " << (size >> 20) << " MB: blocking reads "
+            << blocking_ms << " ms, hclib_async_read " << async_ms << " ms" <<
+            endl;
+    });
+    return 0;
+}
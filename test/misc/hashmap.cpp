@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Mixes of insertions and lookups of random keys in parallel, into a
+ * std::unordered_map behind a mutex and into a concurrent_map, with and
+ * without buffered insertions.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <sys/time.h>
+using namespace std;
+
+static long get_usecs() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec * 1000000 + t.tv_usec;
+}
+
+static inline uint64_t key_of(uint64_t i, uint64_t nkeys) {
+    return (i * 0x9e3779b97f4a7c15ULL >> 16) % nkeys;
+}
+
+/*
+ * Run op(i, insert) for i in [0, nops) in parallel, with insertions for
+ * insert_percent of the operations.
+ */
+template <typename O>
+static long run(long nops, int insert_percent, O op) {
+    long start = get_usecs();
+    loop_domain_t loop = {0, (int) nops, 1, 4096};
+    hclib::finish([&]() {
+        hclib::forasync1D(&loop, [=](int i) {
+            op(i, i % 100 < insert_percent);
+        }, FORASYNC_MODE_RECURSIVE);
+    });
+    return get_usecs() - start;
+}
+
+int main(int argc, char** argv) {
+    const long nops = argc <= 1 ? 4000000 : atol(argv[1]);
+    const long nkeys = argc <= 2 ? nops / 2 : atol(argv[2]);
+
+    hclib::launch([=]() {
+        printf("%ld operations over %ld keys, %d workers\n", nops, nkeys,
+                hclib_num_workers());
+        const int mixes[] = { 100, 50, 10 };
+        for (int insert_percent : mixes) {
+            std::mutex lock;
+            unordered_map<uint64_t, uint64_t> locked;
+            long found_locked = 0;
+            long locked_time = run(nops, insert_percent, [&](long i,
+                        bool insert) {
+                const uint64_t key = key_of(i, nkeys);
+                std::lock_guard<std::mutex> guard(lock);
+                if (insert) {
+                    locked.insert(make_pair(key, i));
+                } else if (locked.count(key)) {
+                    found_locked++;
+                }
+            });
+
+            hclib::concurrent_map<uint64_t, uint64_t> map;
+            hclib::accumulator<long> found;
+            long map_time;
+            hclib::finish([&]() {
+                map_time = run(nops, insert_percent, [&](long i,
+                            bool insert) {
+                    const uint64_t key = key_of(i, nkeys);
+                    if (insert) {
+                        map.insert(key, i);
+                    } else if (map.contains(key)) {
+                        found.local()++;
+                    }
+                });
+            }, found);
+
+            if (map.size() != locked.size() ||
+                    found.get() != found_locked) {
+                cerr << "Error: the maps differ" << endl;
+                exit(1);
+            }
+            printf("%3d%% inserts: mutex %7.3f s, concurrent_map %7.3f s",
+                    insert_percent, locked_time / 1e6, map_time / 1e6);
+
+            if (insert_percent == 100) {
+                hclib::concurrent_map<uint64_t, uint64_t> buffered;
+                long buffered_time = get_usecs();
+                hclib::finish([&]() {
+                    run(nops, insert_percent, [&](long i, bool insert) {
+                        buffered.buffer_insert(key_of(i, nkeys), i);
+                    });
+                }, buffered);
+                buffered_time = get_usecs() - buffered_time;
+                if (buffered.size() != locked.size()) {
+                    cerr << "Error: the maps differ" << endl;
+                    exit(1);
+                }
+                printf(", buffered %7.3f s", buffered_time / 1e6);
+            }
+            printf("\n");
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * 1D and 2D Jacobi stencils over blocks of rows, synchronized either by a
+ * phaser barrier between long-lived block tasks, or by a finish scope per
+ * iteration.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <sys/time.h>
+using namespace std;
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
+}
+
+/*
+ * A grid of rows x cols points with fixed boundaries, in two buffers so that
+ * each iteration reads one and writes the other.
+ */
+struct grid {
+    int rows, cols;
+    vector<double> a, b;
+
+    grid(int rows, int cols) : rows(rows), cols(cols),
+            a((rows + 2) * (cols + 2), 0.0) {
+        // hot top and left edges
+        for (int j = 0; j < cols + 2; j++) {
+            a[j] = 1.0;
+        }
+        for (int i = 0; i < rows + 2; i++) {
+            a[i * (cols + 2)] = 1.0;
+        }
+        b = a;
+    }
+
+    // blocks are made of rows, or of columns in 1D
+    int size() const {
+        return rows == 1 ? cols : rows;
+    }
+
+    // update block [lo, hi) in iteration iter
+    void update(int iter, int lo, int hi) {
+        const double *in = iter % 2 ? b.data() : a.data();
+        double *out = iter % 2 ? a.data() : b.data();
+        const int w = cols + 2;
+        if (rows == 1) {
+            for (int j = lo + 1; j <= hi; j++) {
+                out[w + j] = (in[w + j - 1] + in[w + j + 1]) / 2;
+            }
+            return;
+        }
+        for (int i = lo + 1; i <= hi; i++) {
+            for (int j = 1; j <= cols; j++) {
+                out[i * w + j] = (in[(i - 1) * w + j] + in[(i + 1) * w + j] +
+                        in[i * w + j - 1] + in[i * w + j + 1]) / 4;
+            }
+        }
+    }
+
+    double checksum(int iters) const {
+        const vector<double> &v = iters % 2 ? b : a;
+        double sum = 0;
+        for (double x : v) sum += x;
+        return sum;
+    }
+};
+
+static inline int block_lo(int size, int nblocks, int k) {
+    return (long) size * k / nblocks;
+}
+
+double run_finish(grid &g, int nblocks, int iters) {
+    for (int t = 0; t < iters; t++) {
+        HCLIB_FINISH {
+            for (int k = 0; k < nblocks; k++) {
+                hclib::async([&g, nblocks, t, k]() {
+                        g.update(t, block_lo(g.size(), nblocks, k),
+                            block_lo(g.size(), nblocks, k + 1));
+                    });
+            }
+        }
+    }
+    return g.checksum(iters);
+}
+
+double run_phaser(grid &g, int nblocks, int iters) {
+    HCLIB_FINISH {
+        hclib_phaser_t *ph = hclib_phaser_create(PHASER_SIG_WAIT);
+        for (int k = 0; k < nblocks; k++) {
+            hclib::async_phased([&g, ph, nblocks, iters, k]() {
+                    const int lo = block_lo(g.size(), nblocks, k);
+                    const int hi = block_lo(g.size(), nblocks, k + 1);
+                    for (int t = 0; t < iters; t++) {
+                        g.update(t, lo, hi);
+                        hclib_phaser_next(ph);
+                    }
+                }, ph, PHASER_SIG_WAIT);
+        }
+    }
+    return g.checksum(iters);
+}
+
+void compare(const string &name, int rows, int cols, int nblocks, int iters) {
+    grid g1(rows, cols), g2(rows, cols);
+    long start = get_usecs();
+    const double s1 = run_finish(g1, nblocks, iters);
+    long end = get_usecs();
+    const double finish_ms = (end - start) / 1000.0;
+    start = get_usecs();
+    const double s2 = run_phaser(g2, nblocks, iters);
+    end = get_usecs();
+    const double phaser_ms = (end - start) / 1000.0;
+    assert(fabs(s1 - s2) < 1e-9 * fabs(s1) + 1e-12);
+
+    cout << name << " " << rows << "x" << cols << ", " << nblocks <<
+        " blocks, " << iters << " iterations: finish per iteration " <<
+        finish_ms << " ms, phaser " << phaser_ms << " ms" << endl;
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        int iters = argc <= 1 ? 1000 : atoi(argv[1]);
+        int nblocks = argc <= 2 ? 4 * hclib::num_workers() : atoi(argv[2]);
+
+        compare("1D", 1, 1 << 16, nblocks, iters);
+        compare("2D", 256, 256, nblocks, iters);
+    });
+    return 0;
+}
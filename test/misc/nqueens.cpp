@@ -89,6 +89,52 @@ long get_usecs (void)
    return t.tv_sec*1000000+t.tv_usec;
 }
 
+/*
+ * Search for a single solution, cancelling the rest of the search once it is
+ * found if token is set.
+ */
+struct board {
+  int q[32];
+};
+
+volatile int found;
+long found_at;
+
+void nqueens_first(board A, int depth, int size, cancel_token *token) {
+  if (size == depth) {
+    if (__sync_bool_compare_and_swap(&found, 0, 1)) {
+      found_at = get_usecs();
+      if (token) token->cancel();
+    }
+    return;
+  }
+  for(int i=0; i<size; i++) {
+      if (token && is_cancelled()) return;
+      board B = A;
+      B.q[depth] = i;
+      if (!ok((depth +  1), B.q)) {
+	hclib::async([=]() {
+        nqueens_first(B, depth+1, size, token);
+	});
+      }
+  }
+}
+
+void first_solution(int n, bool cancel) {
+  cancel_token token;
+  board a;
+  found = 0;
+  long start = get_usecs();
+  cancellable_finish(token, [&]() {
+      nqueens_first(a, 0, n, cancel ? &token : NULL);
+  });
+  long end = get_usecs();
+  assert(found);
+  printf("NQueens(%d) first solution %s cancellation: found after %fsec, "
+         "search done after %fsec\n", n, cancel ? "with" : "without",
+         (found_at-start)/1000000.0, (end-start)/1000000.0);
+}
+
 int main(int argc, char* argv[])
 {
   hclib::launch([=]() {
@@ -110,6 +156,9 @@ int main(int argc, char* argv[])
       verify_queens(n);  
       free((void*)atomic);
       printf("NQueens(%d) Time = %fsec\n",n,dur);
+
+      first_solution(n, false);
+      first_solution(n, true);
   });
 
   return 0;
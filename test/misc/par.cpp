@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * hclib::par algorithms against the serial std:: ones on the same input. The
+ * sort input is built as in test/cilk/Cilksort.cpp, so that the times can be
+ * compared with Cilksort's.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+using namespace std;
+
+static long get_usecs() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec * 1000000 + t.tv_usec;
+}
+
+static void report(const char *name, long serial, long parallel, bool same) {
+    if (!same) {
+        cerr << "Error: par::" << name << " differs from std::" << name
+            << endl;
+        exit(1);
+    }
+    printf("%-15s std %8.3f s, par %8.3f s, speedup %5.2f\n", name,
+            serial / 1e6, parallel / 1e6, (double) serial / parallel);
+}
+
+template <typename S, typename P>
+static void compare(const char *name, S serial, P parallel) {
+    long start = get_usecs();
+    auto expected = serial();
+    long serial_time = get_usecs() - start;
+    start = get_usecs();
+    auto result = parallel();
+    long parallel_time = get_usecs() - start;
+    report(name, serial_time, parallel_time, result == expected);
+}
+
+int main(int argc, char** argv) {
+    const int n = argc <= 1 ? 10000000 : atoi(argv[1]);
+
+    hclib::launch([=]() {
+        printf("%d elements, %d workers\n", n, hclib_num_workers());
+        vector<int> in(n);
+        srand(1);
+        for (int i = 0; i < n; i++) in[i] = i;
+        for (int i = 0; i < n; i++) swap(in[i], in[rand() % n]);
+        vector<double> out(n);
+
+        auto root = [](int x) { return sqrt((double) x); };
+        compare("for_each", [&]() {
+            vector<int> v(in);
+            for_each(v.begin(), v.end(), [](int &x) { x = x * 3 + 1; });
+            return v;
+        }, [&]() {
+            vector<int> v(in);
+            hclib::par::for_each(v.begin(), v.end(),
+                    [](int &x) { x = x * 3 + 1; });
+            return v;
+        });
+        compare("transform", [&]() {
+            transform(in.begin(), in.end(), out.begin(), root);
+            return out;
+        }, [&]() {
+            vector<double> v(n);
+            hclib::par::transform(in.begin(), in.end(), v.begin(), root);
+            return v;
+        });
+        compare("reduce", [&]() {
+            return accumulate(in.begin(), in.end(), 0L);
+        }, [&]() {
+            return hclib::par::reduce(in.begin(), in.end(), 0L);
+        });
+        compare("inclusive_scan", [&]() {
+            vector<long> v(n);
+            partial_sum(in.begin(), in.end(), v.begin(), plus<long>());
+            return v;
+        }, [&]() {
+            vector<long> v(n);
+            hclib::par::inclusive_scan(in.begin(), in.end(), v.begin(),
+                    plus<long>());
+            return v;
+        });
+        auto below_half = [=](int x) { return x < n / 2; };
+        compare("partition", [&]() {
+            vector<int> v(in);
+            stable_partition(v.begin(), v.end(), below_half);
+            return v;
+        }, [&]() {
+            vector<int> v(in);
+            hclib::par::partition(v.begin(), v.end(), below_half);
+            return v;
+        });
+        compare("sort", [&]() {
+            vector<int> v(in);
+            sort(v.begin(), v.end());
+            return v;
+        }, [&]() {
+            vector<int> v(in);
+            hclib::par::sort(v.begin(), v.end());
+            return v;
+        });
+    });
+    return 0;
+}
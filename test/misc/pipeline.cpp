@@ -0,0 +1,121 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Throughput of a 4-stage pipeline (source, two transforms, sink) streaming
+ * values through bounded channels, against a fresh promise per value and
+ * stage.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <sys/time.h>
+using namespace std;
+
+long get_usecs (void)
+{
+   struct timeval t;
+   gettimeofday(&t,NULL);
+   return t.tv_sec*1000000+t.tv_usec;
+}
+
+static void report(const string &name, long n, long start, long end) {
+    const double secs = ((double)(end-start))/1000000;
+    cout << name << secs * 1000 << " ms, " << n / secs / 1e6 <<
+        " M values/s" << endl;
+}
+
+template<typename F>
+void stage(hclib::channel<long> &in, hclib::channel<long> &out, F f) {
+    hclib::async([&in, &out, f]() {
+            long v;
+            while (in.recv(v)) {
+                out.send(f(v));
+            }
+            out.close();
+        });
+}
+
+long run_channels(long n, int capacity) {
+    hclib::channel<long> c0(capacity), c1(capacity), c2(capacity);
+    long sum = 0;
+    HCLIB_FINISH {
+        hclib::async([&]() {
+                for (long i = 0; i < n; i++) {
+                    c0.send(i);
+                }
+                c0.close();
+            });
+        stage(c0, c1, [](long v) { return v * 2; });
+        stage(c1, c2, [](long v) { return v + 1; });
+        hclib::async([&]() {
+                long v;
+                while (c2.recv(v)) {
+                    sum += v;
+                }
+            });
+    }
+    return sum;
+}
+
+long run_promises(long n) {
+    hclib::promise_t<long> *start = new hclib::promise_t<long>();
+    hclib::shared_future<long> sum(start);
+    start->put(0);
+    // in windows, so as not to overflow the deques with ready tasks
+    const long window = 1024;
+    for (long base = 0; base < n; base += window) {
+        HCLIB_FINISH {
+            for (long i = base; i < n && i < base + window; i++) {
+                hclib::shared_future<long> v = hclib::async_future([=]() {
+                        return i;
+                    });
+                v = hclib::async_future_await([=]() mutable {
+                        return v.get() * 2;
+                    }, v);
+                v = hclib::async_future_await([=]() mutable {
+                        return v.get() + 1;
+                    }, v);
+                // the sink adds values in order, as with the channels
+                sum = hclib::async_future_await([=]() mutable {
+                        return sum.get() + v.get();
+                    }, sum, v);
+            }
+        }
+    }
+    return sum.wait();
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        long n = argc <= 1 ? 1000000 : atol(argv[1]);
+        const long expected = n * n;
+
+        cout << "Pipeline of 4 stages, " << n << " values" << endl;
+        for (int capacity : { 1, 16, 256 }) {
+            long start = get_usecs();
+            assert(run_channels(n, capacity) == expected);
+            long end = get_usecs();
+            report("channels, capacity " + to_string(capacity) + ": ", n,
+                    start, end);
+        }
+        long start = get_usecs();
+        assert(run_promises(n) == expected);
+        long end = get_usecs();
+        report("promise per value:    ", n, start, end);
+    });
+    return 0;
+}
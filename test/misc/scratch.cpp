@@ -0,0 +1,88 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Tasks allocating a few temporaries of mixed sizes each, with malloc/free and
+ * with scratch memory reclaimed by a finish scope around each task's work. The
+ * cost of that finish scope alone is measured with malloc/free as well.
+ */
+
+#include "hclib.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+#define TEMPORARIES 4
+
+static long get_usecs() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec * 1000000 + t.tv_usec;
+}
+
+static inline size_t size_of(int task, int k) {
+    return 64 << ((task + k) % 8);
+}
+
+template <typename A, typename R>
+static void use_temporaries(int task, A alloc, R release) {
+    char *temporaries[TEMPORARIES];
+    for (int k = 0; k < TEMPORARIES; k++) {
+        temporaries[k] = (char *) alloc(size_of(task, k));
+        memset(temporaries[k], k, size_of(task, k));
+    }
+    for (int k = 0; k < TEMPORARIES; k++) {
+        release(temporaries[k]);
+    }
+}
+
+template <typename T>
+static long run(int ntasks, T task) {
+    long start = get_usecs();
+    loop_domain_t loop = {0, ntasks, 1, 16};
+    hclib::finish([&]() {
+        hclib::forasync1D(&loop, task, FORASYNC_MODE_RECURSIVE);
+    });
+    return get_usecs() - start;
+}
+
+int main(int argc, char** argv) {
+    const int ntasks = argc <= 1 ? 1000000 : atoi(argv[1]);
+
+    hclib::launch([=]() {
+        printf("%d tasks, %d workers\n", ntasks, hclib_num_workers());
+        long malloc_time = run(ntasks, [](int i) {
+            use_temporaries(i, malloc, free);
+        });
+        long scoped_malloc_time = run(ntasks, [](int i) {
+            HCLIB_FINISH {
+                use_temporaries(i, malloc, free);
+            }
+        });
+        long scratch_time = run(ntasks, [](int i) {
+            HCLIB_FINISH {
+                use_temporaries(i,
+                        [](size_t n) { return hclib::scratch_alloc(n); },
+                        [](char *) {});
+            }
+        });
+        printf("malloc/free %7.3f s, in a finish %7.3f s, scratch_alloc "
+                "%7.3f s\n", malloc_time / 1e6, scoped_malloc_time / 1e6,
+                scratch_time / 1e6);
+    });
+    return 0;
+}
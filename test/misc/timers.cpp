@@ -0,0 +1,104 @@
+/*
+ * Copyright 2017 Rice University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Overhead and precision of the timer wheel with many pending timers: the cost
+ * of arming and cancelling a timer, and how late delayed tasks run.
+ */
+
+#include "hclib.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <time.h>
+using namespace std;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct delayed {
+    uint64_t due;
+    uint64_t late;
+};
+
+static void record(void *arg) {
+    delayed *d = (delayed *) arg;
+    d->late = now_ns() - d->due;
+}
+
+static void never(void *arg) {
+    abort();
+}
+
+int main(int argc, char** argv) {
+    hclib::launch([=]() {
+        const int ntimers = argc <= 1 ? 100000 : atoi(argv[1]);
+        const uint64_t max_delay = (argc <= 2 ? 200 : atol(argv[2])) * 1000000;
+
+        vector<delayed> timers(ntimers);
+        srand(42);
+        uint64_t start = now_ns();
+        HCLIB_FINISH {
+            for (int i = 0; i < ntimers; i++) {
+                // none expires before all are armed
+                const uint64_t delay = 100000000 + (uint64_t) rand() %
+                    max_delay;
+                timers[i].due = now_ns() + delay;
+                hclib_future_release(hclib_async_after(delay, record,
+                            &timers[i]));
+            }
+            cout << ntimers << " timers armed, " <<
+                (double) (now_ns() - start) / ntimers << " ns per timer" <<
+                endl;
+        }
+
+        vector<uint64_t> late(ntimers);
+        double sum = 0;
+        for (int i = 0; i < ntimers; i++) {
+            late[i] = timers[i].late;
+            sum += late[i];
+        }
+        sort(late.begin(), late.end());
+        cout << "lateness: mean " << sum / ntimers / 1000 << " us, median " <<
+            late[ntimers / 2] / 1000.0 << " us, p99 " <<
+            late[(long) ntimers * 99 / 100] / 1000.0 << " us, max " <<
+            late[ntimers - 1] / 1000.0 << " us" << endl;
+
+        vector<hclib_future_t *> futures(ntimers);
+        HCLIB_FINISH {
+            for (int i = 0; i < ntimers; i++) {
+                futures[i] = hclib_async_after(1000000000ULL * (1 + i % 60),
+                        never, NULL);
+            }
+            start = now_ns();
+            for (int i = 0; i < ntimers; i++) {
+                hclib_timer_cancel(futures[i]);
+            }
+            cout << ntimers << " timers cancelled, " <<
+                (double) (now_ns() - start) / ntimers << " ns per timer" <<
+                endl;
+        }
+        for (int i = 0; i < ntimers; i++) {
+            hclib_future_release(futures[i]);
+        }
+    });
+    return 0;
+}
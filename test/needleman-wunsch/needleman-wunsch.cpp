@@ -193,8 +193,10 @@ int main ( int argc, char* argv[] ) {
                         int* left_tile_right_column = (int *)tile_matrix[  i][j-1].right_column->get_future()->get(); 
                         int* diagonal_tile_bottom_right = (int *)tile_matrix[i-1][j-1].bottom_right->get_future()->get();
 
-                        int  * curr_tile_tmp = (int*) malloc(sizeof(int)*(1+tile_width)*(1+tile_height));
-                        int ** curr_tile = (int**) malloc(sizeof(int*)*(1+tile_height));
+                        // the tile itself is reclaimed by the end of this finish
+                        HCLIB_FINISH {
+                        int  * curr_tile_tmp = hclib::scratch_alloc<int>((1+tile_width)*(1+tile_height));
+                        int ** curr_tile = hclib::scratch_alloc<int*>(1+tile_height);
                         for (index = 0; index < tile_height+1; ++index) {
                             curr_tile[index] = &curr_tile_tmp[index*(1+tile_width)];
                         }
@@ -208,10 +210,14 @@ int main ( int argc, char* argv[] ) {
                             curr_tile[0][index] = above_tile_bottom_row[index-1];
                         }
 
-                        for ( ii = 1; ii < tile_height+1; ++ii ) {
-                            for ( jj = 1; jj < tile_width+1; ++jj ) {
-                                signed char char_from_1 = string_1[(j-1)*tile_width+(jj-1)];
-                                signed char char_from_2 = string_2[(i-1)*tile_height+(ii-1)];
+                        // as far as the compiler knows, stores to the scratch tile could modify the captures
+                        const signed char *row_1 = &string_1[(j-1)*tile_width];
+                        const signed char *row_2 = &string_2[(i-1)*tile_height];
+                        const int height = tile_height, width = tile_width;
+                        for ( ii = 1; ii < height+1; ++ii ) {
+                            for ( jj = 1; jj < width+1; ++jj ) {
+                                signed char char_from_1 = row_1[jj-1];
+                                signed char char_from_2 = row_2[ii-1];
 
                                 int diag_score = curr_tile[ii-1][jj-1] + alignment_score_matrix[char_from_2][char_from_1];
                                 int left_score = curr_tile[ii  ][jj-1] + alignment_score_matrix[char_from_1][GAP];
@@ -237,9 +243,7 @@ int main ( int argc, char* argv[] ) {
                             curr_bottom_row[index] = curr_tile[tile_height][index+1];
                         }
                         tile_matrix[i][j].bottom_row->put(curr_bottom_row);
-
-                        free(curr_tile);
-                        free(curr_tile_tmp);
+                        }
                     }, tile_matrix[i][j-1].right_column->get_future(),
                     tile_matrix[i-1][j].bottom_row->get_future(),
                     tile_matrix[i-1][j-1].bottom_right->get_future());
@@ -0,0 +1,150 @@
+#!/bin/bash
+# Builds and runs the applications listed in ./apps with 1, 2, 4, ... workers
+# and with each given HPT file, timing them with the footer HCLIB_STATS prints
+# at finalize. Results go to a JSON file, and are compared against a baseline
+# of a previous run, failing on any run slower than the threshold allows.
+
+usage() {
+	echo "USAGE: ./run.sh [-w MAX_WORKERS] [-p HPT_FILE]... [-r REPEATS]"
+	echo "                [-o RESULTS] [-b BASELINE] [-t THRESHOLD_PERCENT]"
+	echo "Each run is repeated REPEATS times (default 3), keeping the fastest."
+	echo "Runs with an HPT file use the workers it describes."
+	echo "RESULTS defaults to results.json; without a BASELINE, baseline.json"
+	echo "is used if it exists, with a THRESHOLD_PERCENT of 10 by default."
+	echo "Copy the results of a run to baseline.json to compare later runs to it."
+	exit 1
+}
+
+HERE=$(cd $(dirname $0) && pwd)
+TEST_DIR=$(dirname $HERE)
+MAX_WORKERS=$(nproc)
+HPT_FILES=""
+REPEATS=3
+RESULTS=$HERE/results.json
+BASELINE=$HERE/baseline.json
+THRESHOLD=10
+TIMEOUT=${TIMEOUT:-600}
+
+while getopts "w:p:r:o:b:t:h" opt; do
+	case $opt in
+		w) MAX_WORKERS=$OPTARG ;;
+		p) HPT_FILES="$HPT_FILES $(cd $(dirname $OPTARG) && pwd)/$(basename $OPTARG)" ;;
+		r) REPEATS=$OPTARG ;;
+		o) RESULTS=$OPTARG ;;
+		b) BASELINE=$OPTARG ;;
+		t) THRESHOLD=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+
+if [ -z "$HCLIB_ROOT" ]; then
+	echo "Please set the HCLIB_ROOT environment variable."
+	exit 1
+fi
+
+# configurations as workers:hpt, where hpt is an HPT file or default
+CONFIGS=""
+for ((w = 1; w < MAX_WORKERS; w *= 2)); do
+	CONFIGS="$CONFIGS $w:default"
+done
+CONFIGS="$CONFIGS $MAX_WORKERS:default"
+for hpt in $HPT_FILES; do
+	CONFIGS="$CONFIGS null:$hpt"
+done
+
+mkdir -p $HERE/logs
+failures=""
+records=""
+
+# the applications may read stdin
+while IFS=';' read -r -u 3 name dir command check; do
+	[[ -z "$name" || "$name" == \#* ]] && continue
+	executable=$(basename ${command%% *})
+	if ! make -C $TEST_DIR/$dir -B $executable > $HERE/logs/$name.build 2>&1; then
+		echo "$name: build failed, see logs/$name.build"
+		failures="$failures $name"
+		continue
+	fi
+
+	for config in $CONFIGS; do
+		workers=${config%%:*}
+		hpt=${config#*:}
+		if [ "$hpt" == "default" ]; then
+			label="$workers workers"
+		else
+			label=$(basename $hpt)
+		fi
+		export LOG=$HERE/logs/$name-$workers-$(basename $hpt .xml).log
+		best=""
+		for ((r = 0; r < REPEATS; r++)); do
+			if [ "$hpt" == "default" ]; then
+				env="HCLIB_WORKERS=$workers"
+			else
+				env="HCLIB_HPT_FILE=$hpt"
+			fi
+			(cd $TEST_DIR/$dir && env $env HCLIB_STATS=1 \
+				timeout $TIMEOUT $command > $LOG 2>&1 && eval "$check")
+			status=$?
+			msec=$(sed -n 's/^===== TEST PASSED in \([0-9.]*\) msec =====$/\1/p' $LOG)
+			if [[ $status -ne 0 || -z "$msec" ]]; then
+				best=""
+				break
+			fi
+			if [[ -z "$best" ]] || awk "BEGIN { exit !($msec < $best) }"; then
+				best=$msec
+			fi
+		done
+
+		if [ -z "$best" ]; then
+			echo "$name ($label): failed, see $LOG"
+			failures="$failures $name-$workers-$(basename $hpt .xml)"
+			continue
+		fi
+		echo "$name ($label): $best msec"
+		records="$records{\"app\": \"$name\", \"workers\": $workers, \"hpt\": \"$(basename $hpt)\", \"msec\": $best}
+"
+	done
+done 3< $HERE/apps
+
+# one record per line, which the comparison below relies on
+{
+	echo "["
+	printf "%s" "$records" | sed '$!s/$/,/; s/^/  /'
+	echo "]"
+} > $RESULTS
+echo "Results saved to $RESULTS"
+
+regressions=0
+if [ -f "$BASELINE" ] && [ "$BASELINE" != "$RESULTS" ]; then
+	echo "Comparing against $BASELINE, with a threshold of $THRESHOLD%"
+	awk -v threshold=$THRESHOLD '
+		function field(line, key,    m) {
+			if (!match(line, "\"" key "\": [^,}]*")) return ""
+			m = substr(line, RSTART + length(key) + 4, RLENGTH - length(key) - 4)
+			gsub(/"/, "", m)
+			return m
+		}
+		/"app"/ {
+			key = field($0, "app") " " field($0, "workers") " " field($0, "hpt")
+			if (FILENAME == ARGV[1]) {
+				baseline[key] = field($0, "msec")
+			} else if (key in baseline) {
+				msec = field($0, "msec")
+				change = (msec - baseline[key]) / baseline[key] * 100
+				flag = change > threshold ? "  REGRESSION" : ""
+				printf "%-40s %10.3f -> %10.3f msec (%+.1f%%)%s\n", key,
+					baseline[key], msec, change, flag
+				if (flag) regressions++
+			}
+		}
+		END { exit regressions > 0 }' $BASELINE $RESULTS || regressions=1
+fi
+
+if [ -n "$failures" ]; then
+	echo "FAILED:$failures"
+	exit 1
+fi
+if [ $regressions -ne 0 ]; then
+	echo "Performance regressed past $THRESHOLD%"
+	exit 1
+fi
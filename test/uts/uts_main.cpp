@@ -36,11 +36,9 @@ extern "C" {
 /* data per thread */
 struct stealStack_t {
 	long localWork;     /* amount of local only work*/
-	counter_t nNodes, nLeaves;  /* stats */
 	Node *stack;
 	int maxStackDepth;
 	int stack_head, stack_tail;
-	int maxTreeDepth;
 	int root;
 	int chunk_size, work_size;
 };
@@ -72,6 +70,10 @@ static int pollint_max        = 1024;
 /** Global arrays of worker specific states **/
 static StealStack    **threadStealStacks; // worker specific UTS-related stats
 
+/** Tree statistics, accumulated over the search **/
+static hclib::accumulator<counter_t> *nNodes, *nLeaves;
+static hclib::accumulator<int, hclib::max_of<int>> *maxTreeDepth;
+
 // forward declarations
 
 void ss_init(int *argc, char ***argv);
@@ -123,7 +125,7 @@ int main(int argc, char *argv[]) {
 
                 parTreeSearch();
             });
-        });
+        }, *nNodes, *nLeaves, *maxTreeDepth);
 
         t2 = uts_wctime();
 
@@ -166,7 +168,7 @@ void genChildren(Node * parent, int wid) {
 	int numChildren, childType;
 	StealStack *ss = threadStealStacks[wid];
 
-	ss->maxTreeDepth = max(ss->maxTreeDepth, parent->height);
+	maxTreeDepth->put(parent->height);
 
 	numChildren = uts_numChildren(parent);
 	childType   = uts_childType(parent);
@@ -201,7 +203,7 @@ void genChildren(Node * parent, int wid) {
 
 			/* If there is sufficient local work, release a chunk to the global queue */
 			if (ss->localWork > localSize) {
-				if ((ss->nNodes % polling_interval) == 0) {
+				if ((nNodes->local() % polling_interval) == 0) {
 					assert(chunkSize <= 20);
 					Node work[20];	//TODO: C++11 lambda currently does not allow capturing variable length arrays
 					//void * work = malloc(work_chunk_size);
@@ -215,7 +217,7 @@ void genChildren(Node * parent, int wid) {
 			}
 		}
 	} else {
-		ss->nLeaves++;
+		nLeaves->local()++;
 	}
 }
 
@@ -242,23 +244,8 @@ static void parTreeSearch() {
 }
 
 void showStats(double walltime) {
-	int i;
-	counter_t tnodes = 0, tleaves = 0, trel=0, tacq=0;
-	counter_t mdepth = 0, mheight = 0;
-	double elapsedSecs;
-
-	elapsedSecs = walltime;
-
-	// combine measurements from all threads
-	for (int i = 0; i < nthreads; i++) {
-		StealStack *ss = threadStealStacks[i];
-		tnodes  += ss->nNodes;
-		tleaves += ss->nLeaves;
-		mdepth   = max(mdepth, ss->maxStackDepth);
-		mheight  = max(mheight, ss->maxTreeDepth);
-	}
-
-	uts_showStats(1, chunkSize, elapsedSecs, tnodes, tleaves, mheight);
+	uts_showStats(1, chunkSize, walltime, nNodes->get(), nLeaves->get(),
+			maxTreeDepth->get());
 }
 
 
@@ -343,6 +330,9 @@ void ss_init(int *argc, char ***argv)
 		ss_initialize(threadStealStacks[i]);
 		threadStealStacks[i]->stack = (Node*)malloc(sizeof(Node) * MAXSTACKDEPTH);
 	}
+	nNodes = new hclib::accumulator<counter_t>();
+	nLeaves = new hclib::accumulator<counter_t>();
+	maxTreeDepth = new hclib::accumulator<int, hclib::max_of<int>>();
 
 	// Set a default polling interval
 	polling_interval = pollint_default;
@@ -351,10 +341,7 @@ void ss_init(int *argc, char ***argv)
 void ss_initialize(StealStack * s)
 {
 	s->localWork     = 0;
-	s->nNodes        = 0;
-	s->nLeaves       = 0;
 	s->maxStackDepth = 0;
-	s->maxTreeDepth  = 0;
 	s->root          = 0;
 	s->stack_head    = 0;
 	s->stack_tail    = 0;
@@ -382,6 +369,9 @@ void ss_finalize()
 		delete(threadStealStacks[i]);
 	}
 	delete(threadStealStacks);
+	delete nNodes;
+	delete nLeaves;
+	delete maxTreeDepth;
 }
 
 /**
@@ -404,7 +394,7 @@ int ss_get_work(int wid, void* node_c)
 		memcpy(node_c, &(s->stack[s->stack_head]), sizeof(Node));
 
 		s->localWork--;
-		s->nNodes++;
+		nNodes->local()++;
 		return STATUS_HAVEWORK;
 	}
 